@@ -56,6 +56,7 @@ public struct kowhai_protocol_header_t
         {
             public uint8_t command;
             public uint16_t id;
+            public uint16_t tag;
         }
 
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
@@ -69,8 +70,8 @@ public struct kowhai_protocol_symbol_spec_t
         public struct kowhai_protocol_data_payload_memory_spec_t
         {
             public uint16_t type;
-            public uint16_t offset;
-            public uint16_t size;
+            public uint32_t offset;
+            public uint32_t size;
         }
 
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
@@ -84,8 +85,8 @@ public struct kowhai_protocol_data_payload_spec_t
         public struct kowhai_protocol_descriptor_payload_spec_t
         {
             public uint16_t node_count;
-            public uint16_t offset;
-            public uint16_t size;
+            public uint32_t offset;
+            public uint32_t size;
         }
 
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
@@ -122,15 +123,15 @@ public struct kowhai_protocol_function_details_t
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
         public struct kowhai_protocol_function_call_t
         {
-            public uint16_t offset;
-            public uint16_t size;
+            public uint32_t offset;
+            public uint32_t size;
         }
 
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
         public struct kowhai_protocol_event_t
         {
-            public uint16_t offset;
-            public uint16_t size;
+            public uint32_t offset;
+            public uint32_t size;
         }
 
         [StructLayout(LayoutKind.Explicit, Pack = 1)]
@@ -317,7 +318,7 @@ public static int CreateCallFunctionPacket(byte[] protoPacket, int packetSize, r
         public static void CopyDescriptor(Kowhai.kowhai_node_t[] target, kowhai_protocol_payload_t payload)
         {
             GCHandle h = GCHandle.Alloc(target, GCHandleType.Pinned);
-            CopyIntPtrs(new IntPtr(h.AddrOfPinnedObject().ToInt64() + payload.spec.descriptor.offset), payload.buffer, payload.spec.descriptor.size);
+            CopyIntPtrs(new IntPtr(h.AddrOfPinnedObject().ToInt64() + payload.spec.descriptor.offset), payload.buffer, (int)payload.spec.descriptor.size);
             h.Free();
         }
 
@@ -105,7 +105,7 @@ private void ProcessPacket(byte[] buffer)
                         if (Kowhai.GetNode(descriptor, symbols, out nodeOffset, out node) == Kowhai.STATUS_OK)
                         {
                             KowhaiTree tree = kowhaiTreeMain;
-                            tree.UpdateData(data, nodeOffset + prot.payload.spec.data.memory.offset);
+                            tree.UpdateData(data, nodeOffset + (int)prot.payload.spec.data.memory.offset);
                             if (descriptor[0].symbol == (ushort)KowhaiSymbols.Symbols.Constants.Scope)
                             {
                                 Kowhai.kowhai_symbol_t[] symbolPath = new Kowhai.kowhai_symbol_t[] {
@@ -120,7 +120,7 @@ private void ProcessPacket(byte[] buffer)
                                     int arrayIndex = 0;
                                     if (symbols.Length == 2)
                                         arrayIndex = symbols[1].parts.array_index;
-                                    Array.Copy(data, 0, ScopePointData, arrayIndex * 2 + prot.payload.spec.data.memory.offset, data.Length);
+                                    Array.Copy(data, 0, ScopePointData, arrayIndex * 2 + (int)prot.payload.spec.data.memory.offset, data.Length);
                                     for (int i = 0; i < ScopePointData.Length / 2; i++)
                                     {
                                         UInt16 value = BitConverter.ToUInt16(ScopePointData, i * 2);
@@ -229,7 +229,7 @@ private void ProcessPacket(byte[] buffer)
                         if (functionCallForm != null)
                         {
                             byte[] buf = KowhaiProtocol.GetBuffer(prot);
-                            functionCallForm.SetFunctionOutData(buf, prot.payload.spec.function_call.offset);
+                            functionCallForm.SetFunctionOutData(buf, (int)prot.payload.spec.function_call.offset);
                             if (prot.header.command == KowhaiProtocol.CMD_CALL_FUNCTION_RESULT_END)
                                 ShowToast("Function Call Succeded", 800);
                         }
@@ -270,7 +270,7 @@ private void ProcessPacket(byte[] buffer)
                     case KowhaiProtocol.CMD_EVENT:
                     case KowhaiProtocol.CMD_EVENT_END:
                         if (GetTreeId() == prot.header.id)
-                            kowhaiTreeMain.UpdateData(KowhaiProtocol.GetBuffer(prot), prot.payload.spec.event_.offset);
+                            kowhaiTreeMain.UpdateData(KowhaiProtocol.GetBuffer(prot), (int)prot.payload.spec.event_.offset);
                         else
                             ShowToast(string.Format("Event: {0}", getSymbolName(null, prot.header.id)));
                         break;
@@ -49,7 +49,8 @@ KOW_CMD_ERROR_UNKNOWN = 0xFF
 class kowhai_protocol_header_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('command', uint8_t),
-                ('id_', uint16_t)]
+                ('id_', uint16_t),
+                ('tag', uint16_t)]
 
 class kowhai_protocol_symbol_spec_t(ctypes.Structure):
     _pack_ = 1
@@ -59,8 +60,8 @@ class kowhai_protocol_symbol_spec_t(ctypes.Structure):
 class kowhai_protocol_data_payload_memory_spec_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('type_', uint16_t),
-                ('offset', uint16_t),
-                ('size', uint16_t)]
+                ('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_data_payload_spec_t(ctypes.Structure):
     _pack_ = 1
@@ -70,8 +71,8 @@ class kowhai_protocol_data_payload_spec_t(ctypes.Structure):
 class kowhai_protocol_descriptor_payload_spec_t(ctypes.Structure):
     _pack_ = 1
     _fields_ = [('node_count', uint16_t),
-                ('offset', uint16_t),
-                ('size', uint16_t)]
+                ('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_id_list_t(ctypes.Structure):
     _pack_ = 1
@@ -98,13 +99,13 @@ class kowhai_protocol_function_details_t(ctypes.Structure):
 
 class kowhai_protocol_function_call_t(ctypes.Structure):
     _pack_ = 1
-    _fields_ = [('offset', uint16_t),
-                ('size', uint16_t)]
+    _fields_ = [('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_event_t(ctypes.Structure):
     _pack_ = 1
-    _fields_ = [('offset', uint16_t),
-                ('size', uint16_t)]
+    _fields_ = [('offset', uint32_t),
+                ('size', uint32_t)]
 
 class kowhai_protocol_payload_spec_t(ctypes.Union):
     _pack_ = 1
@@ -1,219 +1,1305 @@
 #include "kowhai.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #define VERSION 6
 
+// does the symbol path end with a KOWHAI_SLICE symbol
+#define IS_SLICE_PATH(num_symbols, symbols) ((num_symbols) > 1 && (symbols)[(num_symbols) - 1].parts.name == KOW_SLICE_SYMBOL)
+
 uint32_t kowhai_version(void)
 {
     return VERSION;
 }
 
-int kowhai_get_node_type_size(uint16_t type)
+int kowhai_get_node_type_size(uint16_t type)
+{
+    switch ((enum kowhai_node_type)type)
+    {
+        // meta tags only (no real size in the buffer)
+        case KOW_BRANCH_START:
+        case KOW_BRANCH_END:
+        case KOW_BRANCH_U_START:
+            return 0;
+
+        // normal types to describe a buffer
+        case KOW_INT8:
+        case KOW_UINT8:
+        case KOW_CHAR:
+            return 1;
+        case KOW_INT16:
+        case KOW_UINT16:
+            return 2;
+        case KOW_INT32:
+        case KOW_UINT32:
+        case KOW_FLOAT:
+            return 4;
+        default:
+            KOW_LOG(KOW_ERR" unknown item type: %d\n", type);
+            return -1;
+    }
+}
+
+static int get_node_size(const struct kowhai_node_t *node, int *size, int *num_nodes_processed);
+
+// find the branch start matching a branch end (counting the branch nesting back from the end)
+static const struct kowhai_node_t* branch_start(const struct kowhai_node_t *end)
+{
+    int depth = 0;
+    while (1)
+    {
+        end--;
+        if (end->type == KOW_BRANCH_END)
+            depth++;
+        else if (end->type == KOW_BRANCH_START || end->type == KOW_BRANCH_U_START)
+        {
+            if (depth == 0)
+                return end;
+            depth--;
+        }
+    }
+}
+
+// count the nodes after a branch start up to and including its branch end
+static int branch_node_count(const struct kowhai_node_t *start)
+{
+    int i = 0, depth = 0;
+    while (1)
+    {
+        i++;
+        if (start[i].type == KOW_BRANCH_START || start[i].type == KOW_BRANCH_U_START)
+            depth++;
+        else if (start[i].type == KOW_BRANCH_END && depth-- == 0)
+            return i;
+    }
+}
+
+// calculate the size of a single array item of a branch without a stack per branch level, the leaves of nested
+// (non union) branches are counted once per array item of every nested branch above them, only nested unions
+// (which grow to their largest child) are measured on their own
+static int get_branch_item_size(const struct kowhai_node_t *branch, int *size, int *num_nodes_processed)
+{
+    int i = 1, depth = 0, scale = 1, item_size = 0;
+    int child_size, child_nodes, ret;
+
+    while (1)
+    {
+        const struct kowhai_node_t *node = &branch[i];
+        if (node->type == KOW_BRANCH_END)
+        {
+            if (depth == 0)
+            {
+                *size = item_size;
+                *num_nodes_processed = i;
+                return KOW_STATUS_OK;
+            }
+            // leaving a nested branch
+            depth--;
+            scale /= branch_start(node)->count;
+            i++;
+        }
+        else if (node->type == KOW_BRANCH_START && branch->type == KOW_BRANCH_START && node->count > 0)
+        {
+            // entering a nested branch
+            depth++;
+            scale *= node->count;
+            i++;
+        }
+        else if (node->type == KOW_BRANCH_START && branch->type == KOW_BRANCH_START)
+        {
+            // an empty array adds nothing
+            i += branch_node_count(node) + 1;
+        }
+        else
+        {
+            // a leaf, a union or a child of a union
+            ret = get_node_size(node, &child_size, &child_nodes);
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            if (branch->type == KOW_BRANCH_START)
+                item_size += child_size * scale;
+            else if (child_size > item_size)
+                item_size = child_size;
+            i += child_nodes + 1;
+        }
+    }
+}
+
+// calculate the complete size of a node including all the sub-elements and array items.
+static int get_node_size(const struct kowhai_node_t *node, int *size, int *num_nodes_processed)
+{
+    const struct kowhai_index_t* index;
+    int ret, item_size;
+
+    // if the descriptor is compiled the size is already known
+    index = kowhai_descriptor_get_index(node);
+    if (index != NULL)
+    {
+        const struct kowhai_index_entry_t* entry = &index->entries[node - index->desc];
+        if (size != NULL)
+            *size = entry->size;
+        *num_nodes_processed = entry->node_count - 1;
+        return KOW_STATUS_OK;
+    }
+
+    // if this is not a branch then just return the size of the node item (otherwise we need to drill baby)
+    if (node->type != KOW_BRANCH_START && node->type != KOW_BRANCH_U_START)
+    {
+        ret = kowhai_get_node_type_size(node->type);
+        if (ret < 0)
+            return KOW_STATUS_INVALID_DESCRIPTOR;
+        if (size != NULL)
+            *size = ret * node->count;
+        *num_nodes_processed = 0;
+        return KOW_STATUS_OK;
+    }
+
+    // all the array items of a branch are the same size
+    ret = get_branch_item_size(node, &item_size, num_nodes_processed);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    if (size != NULL)
+        *size = item_size * node->count;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_get_node_size(const struct kowhai_node_t *node, int *size)
+{
+    int num_nodes_processed;
+    return get_node_size(node, size, &num_nodes_processed);
+}
+
+int kowhai_get_node_count(const struct kowhai_node_t *node, int *count)
+{
+    int size, ret;
+    ret = get_node_size(node, &size, count);
+    (*count)++;
+    return ret;
+}
+
+// walk positions before the first and after the last node
+#define WALK_INIT 0
+#define WALK_DONE 4
+
+int kowhai_walk_init(struct kowhai_walk_t *walk, const struct kowhai_node_t *desc, void *data, struct kowhai_walk_frame_t *frames, int frame_count)
+{
+    int i;
+    walk->event = WALK_INIT;
+    walk->node = NULL;
+    walk->end = NULL;
+    walk->data = NULL;
+    walk->offset = 0;
+    walk->size = 0;
+    walk->index = 0;
+    walk->depth = 0;
+    walk->desc = desc;
+    walk->tree_data = data;
+    walk->compiled = kowhai_descriptor_get_index(desc);
+    walk->next = desc;
+    walk->level = 0;
+    walk->frame = NULL;
+    walk->frames = NULL;
+    for (i = 0; i < frame_count; i++)
+        kowhai_walk_add_frame(walk, &frames[i]);
+    return KOW_STATUS_OK;
+}
+
+void kowhai_walk_add_frame(struct kowhai_walk_t *walk, struct kowhai_walk_frame_t *frame)
+{
+    struct kowhai_walk_frame_t **last = &walk->frames;
+    struct kowhai_walk_frame_t *parent = NULL;
+    // the deepest frame is normally the innermost open one (frames are added as the walk needs them)
+    if (walk->frame != NULL)
+    {
+        parent = walk->frame;
+        last = &walk->frame->child;
+    }
+    while (*last != NULL)
+    {
+        parent = *last;
+        last = &(*last)->child;
+    }
+    frame->parent = parent;
+    frame->child = NULL;
+    *last = frame;
+}
+
+// set the walk position to the current array item of the innermost open branch
+static int walk_branch_item(struct kowhai_walk_t *walk, struct kowhai_walk_frame_t *frame)
+{
+    walk->event = KOW_WALK_BRANCH_START;
+    walk->node = frame->node;
+    walk->end = NULL;
+    walk->depth = walk->level - 1;
+    walk->index = frame->index;
+    walk->offset = frame->offset;
+    walk->size = frame->stride;
+    walk->data = walk->tree_data != NULL ? (char*)walk->tree_data + frame->offset : NULL;
+    walk->next = frame->node + 1;
+    frame->size = 0;
+    return KOW_STATUS_OK;
+}
+
+// a child of the branch item has been walked, grow the item (unions only grow to their largest child)
+static void walk_child_done(struct kowhai_walk_frame_t *frame, int size)
+{
+    int end = frame->child_offset + size;
+    if (end > frame->size)
+        frame->size = end;
+}
+
+// move the walk to node, a child or the branch end of the innermost open branch (or the walk root)
+static int walk_visit(struct kowhai_walk_t *walk, const struct kowhai_node_t *node)
+{
+    struct kowhai_walk_frame_t *parent = walk->frame;
+    struct kowhai_walk_frame_t *frame;
+    int offset = 0;
+    int size;
+
+    if (parent != NULL)
+    {
+        if (node->type == KOW_BRANCH_END)
+        {
+            // the branch array item is complete
+            parent->end = node;
+            if (parent->stride == 0)
+                parent->stride = parent->size;
+            walk->event = KOW_WALK_BRANCH_END;
+            walk->node = parent->node;
+            walk->end = node;
+            walk->depth = walk->level - 1;
+            walk->index = parent->index;
+            walk->offset = parent->offset;
+            walk->size = parent->stride;
+            walk->data = walk->tree_data != NULL ? (char*)walk->tree_data + parent->offset : NULL;
+            return KOW_STATUS_OK;
+        }
+
+        // union children all start at the start of the union item
+        if (walk->compiled != NULL)
+            offset = walk->compiled->entries[node - walk->compiled->desc].offset;
+        else if (parent->node->type == KOW_BRANCH_START)
+            offset = parent->size;
+        parent->child_offset = offset;
+        offset += parent->offset;
+    }
+
+    walk->node = node;
+    walk->end = NULL;
+    walk->depth = walk->level;
+    walk->index = 0;
+    walk->offset = offset;
+    walk->data = walk->tree_data != NULL ? (char*)walk->tree_data + offset : NULL;
+
+    switch (node->type)
+    {
+        case KOW_BRANCH_START:
+        case KOW_BRANCH_U_START:
+            // the walk is left where it was if there is no frame for the branch
+            frame = parent != NULL ? parent->child : walk->frames;
+            if (frame == NULL)
+                return KOW_STATUS_TREE_TOO_DEEP;
+            walk->frame = frame;
+            walk->level++;
+            frame->node = node;
+            frame->end = NULL;
+            frame->offset = offset;
+            frame->index = 0;
+            frame->user = NULL;
+            frame->user_data = NULL;
+            frame->stride = walk->compiled != NULL ? walk->compiled->entries[node - walk->compiled->desc].stride : 0;
+            return walk_branch_item(walk, frame);
+        case KOW_BRANCH_END:
+            return KOW_STATUS_INVALID_DESCRIPTOR;
+        default:
+            size = kowhai_get_node_type_size(node->type);
+            if (size < 0)
+                return KOW_STATUS_INVALID_DESCRIPTOR;
+            walk->event = KOW_WALK_LEAF;
+            walk->size = size * node->count;
+            walk->next = node + 1;
+            return KOW_STATUS_OK;
+    }
+}
+
+int kowhai_walk_next(struct kowhai_walk_t *walk)
+{
+    struct kowhai_walk_frame_t *frame;
+
+    switch (walk->event)
+    {
+        case WALK_INIT:
+        case KOW_WALK_BRANCH_START:
+            break;
+        case KOW_WALK_LEAF:
+            // a leaf at the root is the whole walk
+            if (walk->level == 0)
+            {
+                walk->event = WALK_DONE;
+                return KOW_STATUS_NOT_FOUND;
+            }
+            walk_child_done(walk->frame, walk->size);
+            break;
+        case KOW_WALK_BRANCH_END:
+            // move to the next array item of the branch
+            frame = walk->frame;
+            if (frame->index + 1 < frame->node->count)
+            {
+                frame->index++;
+                frame->offset += frame->stride;
+                return walk_branch_item(walk, frame);
+            }
+            // or leave the branch
+            walk->level--;
+            walk->frame = frame->parent;
+            if (walk->level == 0)
+            {
+                walk->event = WALK_DONE;
+                return KOW_STATUS_NOT_FOUND;
+            }
+            walk_child_done(walk->frame, frame->stride * frame->node->count);
+            walk->next = frame->end + 1;
+            break;
+        default:
+            return KOW_STATUS_NOT_FOUND;
+    }
+
+    // until walk_visit succeeds the walk is before walk->next (so it can be retried once given another frame)
+    walk->event = WALK_INIT;
+    return walk_visit(walk, walk->next);
+}
+
+int kowhai_walk_skip(struct kowhai_walk_t *walk)
+{
+    struct kowhai_walk_frame_t *frame;
+
+    if (walk->event != KOW_WALK_BRANCH_START)
+        return KOW_STATUS_INVALID_SEQUENCE;
+    frame = walk->frame;
+
+    // the first item of an uncompiled branch has to be measured
+    if (frame->stride == 0 || frame->end == NULL)
+    {
+        int size, num_nodes_processed;
+        int ret = get_node_size(frame->node, &size, &num_nodes_processed);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        if (frame->node->count > 0)
+            frame->stride = size / frame->node->count;
+        frame->end = frame->node + num_nodes_processed;
+    }
+    frame->size = frame->stride;
+    walk->next = frame->end;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_walk_get_path(const struct kowhai_walk_t *walk, union kowhai_symbol_t *path, int *num_symbols)
+{
+    const struct kowhai_walk_frame_t *frame = walk->frames;
+    int i;
+    if (walk->event != KOW_WALK_BRANCH_START && walk->event != KOW_WALK_LEAF && walk->event != KOW_WALK_BRANCH_END)
+        return KOW_STATUS_INVALID_SEQUENCE;
+    if (*num_symbols < walk->depth + 1)
+    {
+        *num_symbols = walk->depth + 1;
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    }
+    // one symbol per open branch (the last is the current branch at branch events) and then the leaf
+    for (i = 0; i < walk->level; i++, frame = frame->child)
+        path[i].symbol = KOWHAI_SYMBOL(frame->node->symbol, frame->index);
+    if (walk->event == KOW_WALK_LEAF)
+        path[i].symbol = KOWHAI_SYMBOL(walk->node->symbol, 0);
+    *num_symbols = walk->depth + 1;
+    return KOW_STATUS_OK;
+}
+
+// run a walk to its end, adding a frame kept on this call's stack each time the walk reaches a new branch level
+static int walk_tree(struct kowhai_walk_t *walk, kowhai_walk_visit_t visit, void* param)
+{
+    struct kowhai_walk_frame_t frame;
+    int status;
+    while ((status = kowhai_walk_next(walk)) == KOW_STATUS_OK)
+    {
+        status = visit(param, walk);
+        if (status != KOW_STATUS_OK)
+            return status;
+    }
+    if (status != KOW_STATUS_TREE_TOO_DEEP)
+        return status == KOW_STATUS_NOT_FOUND ? KOW_STATUS_OK : status;
+    kowhai_walk_add_frame(walk, &frame);
+    return walk_tree(walk, visit, param);
+}
+
+int kowhai_walk_tree(const struct kowhai_node_t *desc, void *data, kowhai_walk_visit_t visit, void* param)
+{
+    struct kowhai_walk_t walk;
+    kowhai_walk_init(&walk, desc, data, NULL, 0);
+    return walk_tree(&walk, visit, param);
+}
+
+// list of compiled descriptors
+static struct kowhai_index_t* compiled_indexes = NULL;
+
+const struct kowhai_index_t* kowhai_descriptor_get_index(const struct kowhai_node_t *node)
+{
+    const struct kowhai_index_t* index = compiled_indexes;
+    while (index != NULL)
+    {
+        if (node >= index->desc && node < index->desc + index->node_count)
+            return index;
+        index = index->next;
+    }
+    return NULL;
+}
+
+int kowhai_descriptor_layout(const struct kowhai_node_t *node)
+{
+    const struct kowhai_index_t *index = kowhai_descriptor_get_index(node);
+    if (index == NULL)
+        return KOW_LAYOUT_PACKED;
+    return index->layout;
+}
+
+static int hash_symbol(uint16_t parent, uint16_t symbol, int table_size)
+{
+    return (int)(((uint32_t)parent * 31 + symbol) % (uint32_t)table_size);
+}
+
+// round offset up to a multiple of align
+#define ALIGN_UP(offset, align) (((offset) + (align) - 1) / (align) * (align))
+
+// fill in the index entries for the node at node_index (and all its children), returns the index of the next node or < 0 on error
+static int compile_node(const struct kowhai_node_t *desc, int layout, struct kowhai_index_entry_t *entries, int entry_count, int node_index, uint16_t parent)
+{
+    const struct kowhai_node_t *node = desc + node_index;
+    struct kowhai_index_entry_t *entry;
+    int i, size;
+
+    if (node_index >= entry_count || node_index >= KOW_INDEX_EMPTY)
+        return -KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    entry = entries + node_index;
+    entry->offset = 0;
+    entry->parent = parent;
+    entry->align = 1;
+
+    switch (node->type)
+    {
+        case KOW_BRANCH_START:
+        case KOW_BRANCH_U_START:
+        {
+            int child_offset = 0;
+            size = 0;
+            i = node_index + 1;
+            while (1)
+            {
+                int child_index = i;
+                struct kowhai_index_entry_t *child;
+                if (i >= entry_count)
+                    return -KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                if (desc[i].type == KOW_BRANCH_END)
+                    break;
+                i = compile_node(desc, layout, entries, entry_count, child_index, (uint16_t)node_index);
+                if (i < 0)
+                    return i;
+                child = &entries[child_index];
+                if (child->align > entry->align)
+                    entry->align = child->align;
+                // accumulate the branch size (union children all start at offset 0)
+                if (node->type == KOW_BRANCH_START)
+                {
+                    child->offset = ALIGN_UP(child_offset, child->align);
+                    child_offset = child->offset + child->size;
+                    size = child_offset;
+                }
+                else if (child->size > size)
+                    size = child->size;
+            }
+            // branch end node
+            entries[i].offset = 0;
+            entries[i].size = 0;
+            entries[i].stride = 0;
+            entries[i].node_count = 1;
+            entries[i].parent = (uint16_t)node_index;
+            entries[i].align = 1;
+            // pad the branch so each array item is aligned
+            size = ALIGN_UP(size, entry->align);
+            entry->stride = size;
+            entry->size = size * node->count;
+            entry->node_count = (uint16_t)(i - node_index + 1);
+            return i + 1;
+        }
+        default:
+            size = kowhai_get_node_type_size(node->type);
+            if (size < 0)
+                return -KOW_STATUS_INVALID_DESCRIPTOR;
+            if (layout == KOW_LAYOUT_ALIGNED)
+                entry->align = (uint16_t)size;
+            entry->stride = size;
+            entry->size = size * node->count;
+            entry->node_count = 1;
+            return node_index + 1;
+    }
+}
+
+int kowhai_descriptor_compile(const struct kowhai_node_t *desc, struct kowhai_index_t *index, struct kowhai_index_entry_t *entries, int entry_count, uint16_t *symbol_table, int symbol_table_size)
+{
+    return kowhai_descriptor_compile_layout(desc, KOW_LAYOUT_PACKED, index, entries, entry_count, symbol_table, symbol_table_size);
+}
+
+int kowhai_descriptor_compile_layout(const struct kowhai_node_t *desc, int layout, struct kowhai_index_t *index, struct kowhai_index_entry_t *entries, int entry_count, uint16_t *symbol_table, int symbol_table_size)
+{
+    int i, node_count;
+
+    if (desc->type != KOW_BRANCH_START)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    if (layout != KOW_LAYOUT_PACKED && layout != KOW_LAYOUT_ALIGNED)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
+    // calculate offsets and sizes of all the nodes
+    node_count = compile_node(desc, layout, entries, entry_count, 0, KOW_INDEX_EMPTY);
+    if (node_count < 0)
+        return -node_count;
+
+    // build the symbol table (every node but branch ends is keyed by its parent and symbol)
+    if (symbol_table == NULL)
+        symbol_table_size = 0;
+    else if (symbol_table_size <= node_count)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    for (i = 0; i < symbol_table_size; i++)
+        symbol_table[i] = KOW_INDEX_EMPTY;
+    for (i = 0; i < node_count && symbol_table != NULL; i++)
+    {
+        int slot;
+        if (desc[i].type == KOW_BRANCH_END)
+            continue;
+        // linear probing keeps nodes that share a parent and symbol in descriptor order
+        slot = hash_symbol(entries[i].parent, desc[i].symbol, symbol_table_size);
+        while (symbol_table[slot] != KOW_INDEX_EMPTY)
+            slot = (slot + 1) % symbol_table_size;
+        symbol_table[slot] = (uint16_t)i;
+    }
+
+    index->desc = desc;
+    index->node_count = node_count;
+    index->entries = entries;
+    index->symbol_table = symbol_table;
+    index->symbol_table_size = symbol_table_size;
+    index->layout = layout;
+
+    // register the index (replacing it if it is already registered)
+    kowhai_descriptor_release(index);
+    index->next = compiled_indexes;
+    compiled_indexes = index;
+
+    return KOW_STATUS_OK;
+}
+
+void kowhai_descriptor_release(struct kowhai_index_t *index)
+{
+    struct kowhai_index_t** p = &compiled_indexes;
+    while (*p != NULL)
+    {
+        if (*p == index)
+        {
+            *p = index->next;
+            break;
+        }
+        p = &(*p)->next;
+    }
+    index->next = NULL;
+}
+
+// memory ordering used by kowhai_seqlock, define these for other compilers (the fallbacks only suit single core targets)
+#ifndef KOW_SEQLOCK_ACQUIRE
+#if defined(__GNUC__)
+#define KOW_SEQLOCK_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define KOW_SEQLOCK_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define KOW_SEQLOCK_CAS(p, old_value, new_value) __sync_bool_compare_and_swap(p, old_value, new_value)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#if defined(_M_IX86) || defined(_M_X64)
+// x86 and x64 do not reorder loads with loads or stores with stores so only the compiler has to be held back
+#define KOW_SEQLOCK_ACQUIRE() _ReadWriteBarrier()
+#define KOW_SEQLOCK_RELEASE() _ReadWriteBarrier()
+#elif defined(_M_ARM64)
+#define KOW_SEQLOCK_ACQUIRE() __dmb(_ARM64_BARRIER_ISH)
+#define KOW_SEQLOCK_RELEASE() __dmb(_ARM64_BARRIER_ISH)
+#elif defined(_M_ARM)
+#define KOW_SEQLOCK_ACQUIRE() __dmb(_ARM_BARRIER_ISH)
+#define KOW_SEQLOCK_RELEASE() __dmb(_ARM_BARRIER_ISH)
+#else
+#include <windows.h>
+#define KOW_SEQLOCK_ACQUIRE() MemoryBarrier()
+#define KOW_SEQLOCK_RELEASE() MemoryBarrier()
+#endif
+#define KOW_SEQLOCK_CAS(p, old_value, new_value) (_InterlockedCompareExchange((volatile long*)(p), (long)(new_value), (long)(old_value)) == (long)(old_value))
+#else
+#define KOW_SEQLOCK_ACQUIRE()
+#define KOW_SEQLOCK_RELEASE()
+#define KOW_SEQLOCK_CAS(p, old_value, new_value) (*(p) == (old_value) ? (*(p) = (new_value), 1) : 0)
+#endif
+#endif
+
+// number of times a sequence lock, change tracker or snapshot has been registered or released, handles cache the ones
+// of their tree data while this does not change
+static uint32_t registrations = 0;
+
+// list of registered sequence locks
+static struct kowhai_seqlock_t* seqlocks = NULL;
+
+int kowhai_seqlock_init(struct kowhai_seqlock_t *lock, struct kowhai_tree_t *tree)
+{
+    int status = kowhai_get_node_size(tree->desc, &lock->size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    lock->sequence = 0;
+    lock->data = tree->data;
+    lock->next = seqlocks;
+    seqlocks = lock;
+    registrations++;
+    return KOW_STATUS_OK;
+}
+
+void kowhai_seqlock_release(struct kowhai_seqlock_t *lock)
+{
+    struct kowhai_seqlock_t** p = &seqlocks;
+    while (*p != NULL)
+    {
+        if (*p == lock)
+        {
+            *p = lock->next;
+            break;
+        }
+        p = &(*p)->next;
+    }
+    lock->next = NULL;
+    registrations++;
+}
+
+struct kowhai_seqlock_t* kowhai_seqlock_get(const void *data)
+{
+    struct kowhai_seqlock_t* lock = seqlocks;
+    while (lock != NULL)
+    {
+        if ((const char*)data >= (char*)lock->data && (const char*)data < (char*)lock->data + lock->size)
+            return lock;
+        lock = lock->next;
+    }
+    return NULL;
+}
+
+uint32_t kowhai_seqlock_read_begin(struct kowhai_seqlock_t *lock)
+{
+    uint32_t sequence;
+    do
+        sequence = lock->sequence;
+    while (sequence & 1);
+    KOW_SEQLOCK_ACQUIRE();
+    return sequence;
+}
+
+int kowhai_seqlock_read_retry(struct kowhai_seqlock_t *lock, uint32_t sequence)
+{
+    KOW_SEQLOCK_ACQUIRE();
+    return lock->sequence != sequence;
+}
+
+void kowhai_seqlock_write_begin(struct kowhai_seqlock_t *lock)
+{
+    uint32_t sequence;
+    // make the sequence odd, once no other writer has it odd
+    do
+        sequence = lock->sequence & ~1u;
+    while (!KOW_SEQLOCK_CAS(&lock->sequence, sequence, sequence + 1));
+    KOW_SEQLOCK_RELEASE();
+}
+
+void kowhai_seqlock_write_end(struct kowhai_seqlock_t *lock)
+{
+    KOW_SEQLOCK_RELEASE();
+    lock->sequence++;
+}
+
+// list of registered change trackers
+static struct kowhai_dirty_t* dirty_trackers = NULL;
+
+static int compare_dirty_entries(const void* a, const void* b)
+{
+    int offset_a = ((const struct kowhai_dirty_entry_t*)a)->offset;
+    int offset_b = ((const struct kowhai_dirty_entry_t*)b)->offset;
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+// the entries of a tracker being filled by a walk of its tree
+struct dirty_init_walk_t
+{
+    struct kowhai_dirty_entry_t *entries;
+    int entry_count;
+    int count;
+};
+
+static int dirty_init_visit(void* param, struct kowhai_walk_t *walk)
+{
+    struct dirty_init_walk_t *init = (struct dirty_init_walk_t*)param;
+    if (walk->event != KOW_WALK_LEAF)
+        return KOW_STATUS_OK;
+    if (init->count < init->entry_count)
+    {
+        init->entries[init->count].node = walk->node;
+        init->entries[init->count].offset = walk->offset;
+        init->entries[init->count].size = walk->size;
+        init->entries[init->count].generation = 0;
+    }
+    init->count++;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_dirty_init(struct kowhai_dirty_t *dirty, struct kowhai_tree_t *tree, struct kowhai_dirty_entry_t *entries, int *entry_count)
+{
+    struct dirty_init_walk_t init;
+    int i, count, reach = 0;
+    int status = kowhai_get_node_size(tree->desc, &dirty->size);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    // one entry per leaf visited by a walk of the tree
+    init.entries = entries;
+    init.entry_count = *entry_count;
+    init.count = 0;
+    status = kowhai_walk_tree(tree->desc, tree->data, dirty_init_visit, &init);
+    if (status != KOW_STATUS_OK)
+        return status;
+    count = init.count;
+    if (count > *entry_count)
+    {
+        *entry_count = count;
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    }
+    *entry_count = count;
+
+    // sort by offset and note how far each entry (or any before it, union members overlap) reaches so the entries
+    // overlapping a write can be found with a binary search
+    qsort(entries, count, sizeof(struct kowhai_dirty_entry_t), compare_dirty_entries);
+    for (i = 0; i < count; i++)
+    {
+        if (entries[i].offset + entries[i].size > reach)
+            reach = entries[i].offset + entries[i].size;
+        entries[i].reach = reach;
+    }
+
+    dirty->data = tree->data;
+    dirty->entries = entries;
+    dirty->entry_count = count;
+    dirty->generation = 0;
+
+    // register the tracker (replacing it if it is already registered)
+    kowhai_dirty_release(dirty);
+    dirty->next = dirty_trackers;
+    dirty_trackers = dirty;
+    registrations++;
+    return KOW_STATUS_OK;
+}
+
+void kowhai_dirty_release(struct kowhai_dirty_t *dirty)
+{
+    struct kowhai_dirty_t** p = &dirty_trackers;
+    while (*p != NULL)
+    {
+        if (*p == dirty)
+        {
+            *p = dirty->next;
+            break;
+        }
+        p = &(*p)->next;
+    }
+    dirty->next = NULL;
+    registrations++;
+}
+
+struct kowhai_dirty_t* kowhai_dirty_get(const void *data)
+{
+    struct kowhai_dirty_t* dirty = dirty_trackers;
+    while (dirty != NULL)
+    {
+        if ((const char*)data >= (char*)dirty->data && (const char*)data < (char*)dirty->data + dirty->size)
+            return dirty;
+        dirty = dirty->next;
+    }
+    return NULL;
+}
+
+// find the first entry (by offset) that an entry at or before it reaches past offset from, so the entries overlapping
+// some data start there
+static int dirty_find(struct kowhai_dirty_t *dirty, int offset)
+{
+    int first = 0, last = dirty->entry_count;
+    while (first < last)
+    {
+        int mid = (first + last) / 2;
+        if (dirty->entries[mid].reach <= offset)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return first;
+}
+
+void kowhai_dirty_mark(struct kowhai_dirty_t *dirty, int offset, int size)
+{
+    int first = dirty_find(dirty, offset);
+
+    dirty->generation++;
+
+    // mark every entry overlapping the written data
+    for (; first < dirty->entry_count && dirty->entries[first].offset < offset + size; first++)
+    {
+        struct kowhai_dirty_entry_t* entry = &dirty->entries[first];
+        if (entry->offset + entry->size > offset)
+            entry->generation = dirty->generation;
+    }
+}
+
+int kowhai_dirty_changed(struct kowhai_dirty_t *dirty, uint32_t since, int offset, int size)
+{
+    int i;
+    for (i = dirty_find(dirty, offset); i < dirty->entry_count && dirty->entries[i].offset < offset + size; i++)
+    {
+        struct kowhai_dirty_entry_t* entry = &dirty->entries[i];
+        if (entry->generation > since && entry->offset + entry->size > offset)
+            return 1;
+    }
+    return 0;
+}
+
+int kowhai_dirty_enumerate(struct kowhai_dirty_t *dirty, uint32_t since, void* param, kowhai_on_dirty_t on_dirty)
+{
+    int i;
+    for (i = 0; i < dirty->entry_count; i++)
+    {
+        if (dirty->entries[i].generation > since)
+        {
+            int status = on_dirty(param, &dirty->entries[i]);
+            if (status != KOW_STATUS_OK)
+                return status;
+        }
+    }
+    return KOW_STATUS_OK;
+}
+
+void kowhai_dirty_clear(struct kowhai_dirty_t *dirty)
+{
+    int i;
+    for (i = 0; i < dirty->entry_count; i++)
+        dirty->entries[i].generation = 0;
+}
+
+// list of registered snapshots
+static struct kowhai_snapshot_t* snapshots = NULL;
+
+#define CHUNK_COUNT(snapshot) (((snapshot)->size + (snapshot)->chunk_size - 1) / (snapshot)->chunk_size)
+#define CHUNK_SAVED(snapshot, chunk) ((snapshot)->saved[(chunk) / 8] & (1 << ((chunk) % 8)))
+
+int kowhai_snapshot_init(struct kowhai_snapshot_t *snapshot, struct kowhai_tree_t *tree, void *copy, int copy_size, uint8_t *saved, int saved_size, int chunk_size)
+{
+    int status = kowhai_get_node_size(tree->desc, &snapshot->size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (chunk_size <= 0)
+        return KOW_STATUS_BUFFER_INVALID;
+    snapshot->chunk_size = chunk_size;
+    if (copy_size < snapshot->size || saved_size * 8 < CHUNK_COUNT(snapshot))
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    snapshot->desc = tree->desc;
+    snapshot->data = tree->data;
+    snapshot->copy = copy;
+    snapshot->saved = saved;
+    snapshot->active = 0;
+
+    // register the snapshot (replacing it if it is already registered)
+    kowhai_snapshot_release(snapshot);
+    snapshot->next = snapshots;
+    snapshots = snapshot;
+    registrations++;
+    return KOW_STATUS_OK;
+}
+
+void kowhai_snapshot_release(struct kowhai_snapshot_t *snapshot)
+{
+    struct kowhai_snapshot_t** p = &snapshots;
+    while (*p != NULL)
+    {
+        if (*p == snapshot)
+        {
+            *p = snapshot->next;
+            break;
+        }
+        p = &(*p)->next;
+    }
+    snapshot->next = NULL;
+    registrations++;
+}
+
+// find the most recently registered snapshot (active or not) of some tree data, the other snapshots of the data were
+// registered before it so they follow it in the snapshot list
+static struct kowhai_snapshot_t* snapshot_find(const void *data)
+{
+    struct kowhai_snapshot_t* snapshot = snapshots;
+    while (snapshot != NULL)
+    {
+        if ((const char*)data >= (char*)snapshot->data && (const char*)data < (char*)snapshot->data + snapshot->size)
+            return snapshot;
+        snapshot = snapshot->next;
+    }
+    return NULL;
+}
+
+struct kowhai_snapshot_t* kowhai_snapshot_get(const void *data)
+{
+    struct kowhai_snapshot_t* snapshot = snapshots;
+    while (snapshot != NULL)
+    {
+        if (!snapshot->active && (const char*)data >= (char*)snapshot->data && (const char*)data < (char*)snapshot->data + snapshot->size)
+            return snapshot;
+        snapshot = snapshot->next;
+    }
+    return NULL;
+}
+
+int kowhai_snapshot_begin(struct kowhai_snapshot_t *snapshot)
+{
+    struct kowhai_seqlock_t* lock = kowhai_seqlock_get(snapshot->data);
+    int status = KOW_STATUS_OK;
+
+    // start the snapshot between writes so no write is half way through copying its chunks
+    if (lock != NULL)
+        kowhai_seqlock_write_begin(lock);
+    if (snapshot->active)
+        status = KOW_STATUS_INVALID_SEQUENCE;
+    else
+    {
+        memset(snapshot->saved, 0, (CHUNK_COUNT(snapshot) + 7) / 8);
+        snapshot->active = 1;
+    }
+    if (lock != NULL)
+        kowhai_seqlock_write_end(lock);
+    return status;
+}
+
+void kowhai_snapshot_end(struct kowhai_snapshot_t *snapshot)
+{
+    struct kowhai_seqlock_t* lock = kowhai_seqlock_get(snapshot->data);
+    if (lock != NULL)
+        kowhai_seqlock_write_begin(lock);
+    snapshot->active = 0;
+    if (lock != NULL)
+        kowhai_seqlock_write_end(lock);
+}
+
+// copy the chunks overlapping some tree data into a snapshot (unless they already have been)
+static void save_chunks(struct kowhai_snapshot_t *snapshot, int offset, int size)
+{
+    int chunk = offset / snapshot->chunk_size;
+    int last = (offset + size - 1) / snapshot->chunk_size;
+    if (size <= 0)
+        return;
+    for (; chunk <= last; chunk++)
+    {
+        int chunk_offset = chunk * snapshot->chunk_size;
+        int chunk_size = snapshot->chunk_size;
+        if (CHUNK_SAVED(snapshot, chunk))
+            continue;
+        if (chunk_offset + chunk_size > snapshot->size)
+            chunk_size = snapshot->size - chunk_offset;
+        memcpy((char*)snapshot->copy + chunk_offset, (char*)snapshot->data + chunk_offset, chunk_size);
+        snapshot->saved[chunk / 8] |= (uint8_t)(1 << (chunk % 8));
+    }
+}
+
+int kowhai_snapshot_read(struct kowhai_snapshot_t *snapshot, int offset, void *result, int size)
+{
+    struct kowhai_seqlock_t* lock = kowhai_seqlock_get(snapshot->data);
+
+    if (!snapshot->active)
+        return KOW_STATUS_INVALID_SEQUENCE;
+    if (offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    if (offset + size > snapshot->size)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+
+    // read chunk by chunk, from the copy if the chunk has been written since the snapshot began or the live data if not
+    while (size > 0)
+    {
+        int chunk = offset / snapshot->chunk_size;
+        int n = (chunk + 1) * snapshot->chunk_size - offset;
+        uint32_t sequence;
+        if (n > size)
+            n = size;
+        do
+        {
+            if (lock != NULL)
+                sequence = kowhai_seqlock_read_begin(lock);
+            if (CHUNK_SAVED(snapshot, chunk))
+                memcpy(result, (char*)snapshot->copy + offset, n);
+            else
+                memcpy(result, (char*)snapshot->data + offset, n);
+        }
+        while (lock != NULL && kowhai_seqlock_read_retry(lock, sequence));
+        result = (char*)result + n;
+        offset += n;
+        size -= n;
+    }
+    return KOW_STATUS_OK;
+}
+
+int kowhai_snapshot_get_tree(struct kowhai_snapshot_t *snapshot, struct kowhai_tree_t *tree)
 {
-    switch ((enum kowhai_node_type)type)
+    struct kowhai_seqlock_t* lock = kowhai_seqlock_get(snapshot->data);
+    int chunk;
+
+    if (!snapshot->active)
+        return KOW_STATUS_INVALID_SEQUENCE;
+
+    // copy the remaining chunks a chunk at a time so writers are only held up briefly
+    for (chunk = 0; chunk < CHUNK_COUNT(snapshot); chunk++)
     {
-        // meta tags only (no real size in the buffer)
-        case KOW_BRANCH_START:
-        case KOW_BRANCH_END:
-        case KOW_BRANCH_U_START:
-            return 0;
+        if (CHUNK_SAVED(snapshot, chunk))
+            continue;
+        if (lock != NULL)
+            kowhai_seqlock_write_begin(lock);
+        save_chunks(snapshot, chunk * snapshot->chunk_size, 1);
+        if (lock != NULL)
+            kowhai_seqlock_write_end(lock);
+    }
 
-        // normal types to describe a buffer
-        case KOW_INT8:
-        case KOW_UINT8:
-        case KOW_CHAR:
-            return 1;
-        case KOW_INT16:
-        case KOW_UINT16:
-            return 2;
-        case KOW_INT32:
-        case KOW_UINT32:
-        case KOW_FLOAT:
-            return 4;
-        default:
-            KOW_LOG(KOW_ERR" unknown item type: %d\n", type);
-            return -1;
+    tree->desc = snapshot->desc;
+    tree->data = snapshot->copy;
+    return KOW_STATUS_OK;
+}
+
+// copy the chunks of tree data about to be written into the active snapshots from snapshot to the end of the list
+static void snapshot_save_from(struct kowhai_snapshot_t *snapshot, const void *data, int size)
+{
+    while (snapshot != NULL)
+    {
+        if (snapshot->active && (const char*)data >= (char*)snapshot->data && (const char*)data < (char*)snapshot->data + snapshot->size)
+            save_chunks(snapshot, (int)((const char*)data - (char*)snapshot->data), size);
+        snapshot = snapshot->next;
     }
 }
 
-// calculate the complete size of a node including all the sub-elements and array items.
-static int get_node_size(const struct kowhai_node_t *node, int *size, int *num_nodes_processed)
+void kowhai_snapshot_save(const void *data, int size)
+{
+    snapshot_save_from(snapshots, data, size);
+}
+
+// the sequence lock, change tracker and snapshots registered for some tree data
+struct data_hooks_t
 {
-    int _size = 0;
-    int i = 0;
+    struct kowhai_seqlock_t* lock;
+    struct kowhai_dirty_t* dirty;
+    struct kowhai_snapshot_t* snapshots;
+};
 
-    *num_nodes_processed = 0;
+static void get_data_hooks(const void *tree_data, struct data_hooks_t *hooks)
+{
+    hooks->lock = kowhai_seqlock_get(tree_data);
+    hooks->dirty = kowhai_dirty_get(tree_data);
+    hooks->snapshots = snapshot_find(tree_data);
+}
 
-    switch (node->type)
+// the hooks of the tree data of a handle, as cached by kowhai_resolve unless any were registered or released since
+static void get_handle_hooks(const struct kowhai_handle_t *handle, struct data_hooks_t *hooks)
+{
+    if (handle->registrations != registrations)
     {
-        case KOW_BRANCH_START:
-        case KOW_BRANCH_U_START:
-            // this is a branch so look through all the elements in this branch and accumulate the sizes
-            while (1)
-            {
-                i++;
-                *num_nodes_processed = i;
-                switch ((enum kowhai_node_type)node[i].type)
-                {
-                    // navigate the hierarchy info
-                    case KOW_BRANCH_START:
-                    case KOW_BRANCH_U_START:
-                    {
-                        int child_branch_size = 0;
-                        int _num_child_nodes_processed;
-                        int ret;
-                        ret = get_node_size(node + i, &child_branch_size, &_num_child_nodes_processed);
-                        if (ret != KOW_STATUS_OK)
-                            return ret;
-                        // accumulate the branches size
-                        if (node->type == KOW_BRANCH_START)
-                            _size += child_branch_size;
-                        else if (child_branch_size > _size)
-                            _size = child_branch_size;
-                        // skip the already processed nodes
-                        i += _num_child_nodes_processed;
-                        break;
-                    }
-                    case KOW_BRANCH_END:
-                        // accumulate the whole array
-                        _size *= node->count;
-                        goto done;
-
-                    // accumulate the size of all the other node_count
-                    default:
-                    {
-                        int child_node_size = kowhai_get_node_type_size(node[i].type) * node[i].count;
-                        if (node->type == KOW_BRANCH_START)
-                            _size += child_node_size;
-                        else if (child_node_size > _size)
-                            _size = child_node_size;
-                        break;
-                    }
-                }
-            }
-            break;
-        default:
-            // if this is not a branch then just return the size of the node item (otherwise we need to drill baby)
-            _size = kowhai_get_node_type_size(node->type) * node->count;
-            *num_nodes_processed = 0;
-            break;
+        get_data_hooks(handle->tree->data, hooks);
+        return;
     }
+    hooks->lock = handle->lock;
+    hooks->dirty = handle->dirty;
+    hooks->snapshots = handle->snapshots;
+}
 
-done:
-    // update caller with size information
-    if (size != NULL)
-        *size = _size;
+// copy out of tree data, retrying if a write is published during the copy
+static void read_data(const struct data_hooks_t *hooks, void *dst, const void *src, int size)
+{
+    struct kowhai_seqlock_t* lock = hooks->lock;
+    uint32_t sequence;
+    if (lock == NULL)
+    {
+        memcpy(dst, src, size);
+        return;
+    }
+    do
+    {
+        sequence = kowhai_seqlock_read_begin(lock);
+        memcpy(dst, src, size);
+    }
+    while (kowhai_seqlock_read_retry(lock, sequence));
+}
 
-    return KOW_STATUS_OK;
+// copy in to tree data, publishing the write if the data is protected and marking it if the data is tracked
+static void write_data(const struct data_hooks_t *hooks, void *dst, const void *src, int size)
+{
+    if (hooks->lock != NULL)
+        kowhai_seqlock_write_begin(hooks->lock);
+    snapshot_save_from(hooks->snapshots, dst, size);
+    memcpy(dst, src, size);
+    if (hooks->dirty != NULL)
+        kowhai_dirty_mark(hooks->dirty, (int)((char*)dst - (char*)hooks->dirty->data), size);
+    if (hooks->lock != NULL)
+        kowhai_seqlock_write_end(hooks->lock);
 }
 
-int kowhai_get_node_size(const struct kowhai_node_t *node, int *size)
+// find the child of parent that matches symbol (and can hold its array index) in the index symbol table
+static int find_child(const struct kowhai_index_t *index, int parent, const union kowhai_symbol_t *symbol)
 {
-    int num_nodes_processed;
-    return get_node_size(node, size, &num_nodes_processed);
+    int slot;
+
+    // without a symbol table step over the children using the cached node counts
+    if (index->symbol_table == NULL)
+    {
+        int i = parent + 1;
+        while (index->desc[i].type != KOW_BRANCH_END)
+        {
+            if (index->desc[i].symbol == symbol->parts.name && index->desc[i].count > symbol->parts.array_index)
+                return i;
+            i += index->entries[i].node_count;
+        }
+        return -1;
+    }
+
+    slot = hash_symbol((uint16_t)parent, symbol->parts.name, index->symbol_table_size);
+    while (index->symbol_table[slot] != KOW_INDEX_EMPTY)
+    {
+        int i = index->symbol_table[slot];
+        if (index->entries[i].parent == parent &&
+            index->desc[i].symbol == symbol->parts.name &&
+            index->desc[i].count > symbol->parts.array_index)
+            return i;
+        slot = (slot + 1) % index->symbol_table_size;
+    }
+    return -1;
 }
 
-int kowhai_get_node_count(const struct kowhai_node_t *node, int *count)
+// resolve a symbol path using a compiled descriptor (node_index is the branch the path starts at)
+static int indexed_get_node(const struct kowhai_index_t *index, int node_index, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
 {
-    int size, ret;
-    ret = get_node_size(node, &size, count);
-    (*count)++;
-    return ret;
+    const struct kowhai_node_t *node = index->desc + node_index;
+    int _offset;
+    int i;
+
+    // the first symbol addresses the starting branch itself
+    if (num_symbols < 1 || symbols->parts.name != node->symbol || node->count <= symbols->parts.array_index)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+    _offset = index->entries[node_index].stride * symbols->parts.array_index;
+
+    // then each symbol after that is one table lookup
+    for (i = 1; i < num_symbols; i++)
+    {
+        if (index->desc[node_index].type != KOW_BRANCH_START && index->desc[node_index].type != KOW_BRANCH_U_START)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
+        node_index = find_child(index, node_index, &symbols[i]);
+        if (node_index < 0)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
+        _offset += index->entries[node_index].offset + index->entries[node_index].stride * symbols[i].parts.array_index;
+    }
+
+    if (offset != NULL)
+        *offset = _offset;
+    if (target_node != NULL)
+        *target_node = (struct kowhai_node_t*)index->desc + node_index;
+    return KOW_STATUS_OK;
 }
 
-/**
- * @brief find a item in the tree given its path
- * @param node to start searching from for the given item
- * @param num_symbols number of items in the path (@todo should we just terminate the path instead)
- * @param symbols the path of the item to seek
- * @param offset set to number of bytes from the current node to the requested symbol
- * @param target_node placeholder for the result of the node search
- * @param num_nodes_processed how many nodes were iterated over during this function call
- * @return < 0 on failure
- * @todo find the correct index (always 0 atm)
- */
-int get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node, int initial_branch, int branch_union)
-{
-    int i = 0;
-    int _offset = 0;
+// find the node at a symbol path by stepping down the descriptor one path level at a time (node is the branch the
+// path starts at), offset is from the start of the branch
+static int get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
+{
+    int level, size, num_nodes, child_offset, _offset = 0;
     int ret;
 
-    // look through all the items in the node list
-    while (1)
+    if (num_symbols < 1 || node->symbol != symbols[0].parts.name || node->count <= symbols[0].parts.array_index)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+    ret = get_node_size(node, &size, &num_nodes);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+
+    for (level = 0; ; level++)
     {
-        int skip_size;
-        int skip_nodes;
+        const struct kowhai_node_t *child;
+
+        // move to the addressed array item (leaf offsets are of the array item too)
+        _offset += size / node->count * symbols[level].parts.array_index;
+        if (level == num_symbols - 1)
+            break;
+        if (node->type != KOW_BRANCH_START && node->type != KOW_BRANCH_U_START)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
 
-        switch (node[i].type)
+        // find the child that matches the next path symbol, skipping the children before it
+        child = node + 1;
+        child_offset = 0;
+        while (1)
         {
-            case KOW_BRANCH_END:
-                // if we got a branch end then we didn't find it on this path
+            if (child->type == KOW_BRANCH_END)
                 return KOW_STATUS_INVALID_SYMBOL_PATH;
-            default:
-                // if the path symbols match and the node array count is large enough to contain our index this could be the target node
-                if ((symbols->parts.name == node[i].symbol) && (node[i].count > symbols->parts.array_index))
-                {
-                    if (num_symbols == 1)
-                    {
-                        // the symbol paths fully match in values and length so this is the node we are looking for
-                        ret = KOW_STATUS_OK;
-                        if (target_node != NULL)
-                            *target_node = (struct kowhai_node_t*)node + i;
-                        goto done;
-                    }
-                    
-                    if (node[i].type == KOW_BRANCH_START || node[i].type == KOW_BRANCH_U_START)
-                    {
-                        int branch_offset = 0;
-                        // this is not the target node but it is possibly in this branch so drill baby drill
-                        ret = get_node(node + i + 1, num_symbols - 1, symbols + 1, &branch_offset, target_node, 0, node[i].type == KOW_BRANCH_U_START);
-                        if (ret == KOW_STATUS_INVALID_SYMBOL_PATH)
-                            // branch ended without finding our target node so goto next
-                            break;
-                        // add the branch offset to current total
-                        _offset += branch_offset;
-                        goto done;
-                    }
-                }
+            ret = get_node_size(child, &size, &num_nodes);
+            if (ret != KOW_STATUS_OK)
+                return ret;
+            if (child->symbol == symbols[level + 1].parts.name && child->count > symbols[level + 1].parts.array_index)
                 break;
+            // union children all start at the start of the union item
+            if (node->type == KOW_BRANCH_START)
+                child_offset += size;
+            child += num_nodes + 1;
         }
-        
-        if (initial_branch)
-            return KOW_STATUS_INVALID_SYMBOL_PATH;
-        // this item is not a match so skip it (find out how many bytes and nodes to skip)
-        ret = get_node_size(node + i, &skip_size, &skip_nodes);
-        if (ret != KOW_STATUS_OK)
-            // propagate the error
-            return ret;
-        if (!branch_union)
-            _offset += skip_size;
-        i += skip_nodes + 1;
+        _offset += child_offset;
+        node = child;
     }
 
-done:
-
-    // update offset return parameter
     if (offset != NULL)
-    {
-        // we have the index of the target node
-        // the offset is: (the size of this node / its count) * symbol array index
-        int size;
-        ret = kowhai_get_node_size(node + i, &size);
-        if (ret != KOW_STATUS_OK)
-            return ret;
-        _offset += (size / node[i].count) * symbols->parts.array_index;
         *offset = _offset;
-    }
+    if (target_node != NULL)
+        *target_node = (struct kowhai_node_t*)node;
+    return KOW_STATUS_OK;
+}
 
-    return ret;
+int kowhai_get_path_size(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *size)
+{
+    int node_size, index, count;
+    int status = kowhai_get_node_size(node, &node_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (IS_SLICE_PATH(num_symbols, symbols))
+    {
+        count = symbols[num_symbols - 1].parts.array_index;
+        index = symbols[num_symbols - 2].parts.array_index;
+        if (count == 0 || index + count > node->count)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
+    }
+    else
+    {
+        index = symbols[num_symbols - 1].parts.array_index;
+        count = node->count - index;
+    }
+    *size = node_size / node->count * count;
+    return KOW_STATUS_OK;
 }
 
 int kowhai_get_node(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *offset, struct kowhai_node_t **target_node)
 {
+    const struct kowhai_index_t* index;
     if (node->type != KOW_BRANCH_START)
         return KOW_STATUS_INVALID_DESCRIPTOR;
-    return get_node(node, num_symbols, symbols, offset, target_node, 1, node->type == KOW_BRANCH_U_START);
+    // a trailing slice symbol does not change the addressed node
+    if (IS_SLICE_PATH(num_symbols, symbols))
+        num_symbols--;
+    // use the compiled descriptor if there is one
+    index = kowhai_descriptor_get_index(node);
+    if (index != NULL)
+        return indexed_get_node(index, (int)(node - index->desc), num_symbols, symbols, offset, target_node);
+    return get_node(node, num_symbols, symbols, offset, target_node);
 }
 
 int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int read_offset, void* result, int read_size)
@@ -222,6 +1308,7 @@ int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol
     int offset;
     int status;
     int size;
+    struct data_hooks_t hooks;
 
     // find this node
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
@@ -230,15 +1317,19 @@ int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol
     if (read_offset < 0)
         return KOW_STATUS_INVALID_OFFSET;
 
-    // check the read wont overrun the item
-    status = kowhai_get_node_size(node, &size);
+    // check the read wont overrun the item (or the slice)
+    if (IS_SLICE_PATH(num_symbols, symbols))
+        status = kowhai_get_path_size(node, num_symbols, symbols, &size);
+    else
+        status = kowhai_get_node_size(node, &size);
     if (status != KOW_STATUS_OK)
         return status;
     if (read_size + read_offset > size)
         return KOW_STATUS_NODE_DATA_TOO_SMALL;
 
     // do read
-    memcpy(result, (char*)tree->data + offset + read_offset, read_size);
+    get_data_hooks(tree->data, &hooks);
+    read_data(&hooks, result, (char*)tree->data + offset + read_offset, read_size);
     return status;
 }
 
@@ -248,6 +1339,7 @@ int kowhai_write(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbo
     int offset;
     int status;
     int size;
+    struct data_hooks_t hooks;
     
     // find this node
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
@@ -256,29 +1348,216 @@ int kowhai_write(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbo
     if (write_offset < 0)
         return KOW_STATUS_INVALID_OFFSET;
     
-    // check the write wont overrun the item
-    status = kowhai_get_node_size(node, &size);
+    // check the write wont overrun the item (or the slice)
+    if (IS_SLICE_PATH(num_symbols, symbols))
+        status = kowhai_get_path_size(node, num_symbols, symbols, &size);
+    else
+        status = kowhai_get_node_size(node, &size);
     if (status != KOW_STATUS_OK)
         return status;
     if (write_size + write_offset > size)
         return KOW_STATUS_NODE_DATA_TOO_SMALL;
     
     // do write
-    memcpy((char*)tree->data + offset + write_offset, value, write_size);
+    get_data_hooks(tree->data, &hooks);
+    write_data(&hooks, (char*)tree->data + offset + write_offset, value, write_size);
+    return status;
+}
+
+// number of path levels kept from the previous batch item so shared prefixes are not resolved again
+#define BATCH_PATH_CACHE_DEPTH 16
+
+// find the child of a branch that matches symbol, offset is set to the bytes from the start of the branch item to the child item
+static int step_node(const struct kowhai_node_t *branch, const union kowhai_symbol_t *symbol, int *offset, struct kowhai_node_t **child)
+{
+    const struct kowhai_index_t* index;
+    union kowhai_symbol_t path[2];
+
+    if (branch->type != KOW_BRANCH_START && branch->type != KOW_BRANCH_U_START)
+        return KOW_STATUS_INVALID_SYMBOL_PATH;
+    index = kowhai_descriptor_get_index(branch);
+    if (index != NULL)
+    {
+        int i = find_child(index, (int)(branch - index->desc), symbol);
+        if (i < 0)
+            return KOW_STATUS_INVALID_SYMBOL_PATH;
+        *offset = index->entries[i].offset + index->entries[i].stride * symbol->parts.array_index;
+        *child = (struct kowhai_node_t*)index->desc + i;
+        return KOW_STATUS_OK;
+    }
+    path[0].symbol = KOWHAI_SYMBOL(branch->symbol, 0);
+    path[1] = *symbol;
+    return get_node(branch, 2, path, offset, child);
+}
+
+static int compare_batch_items(const void* a, const void* b)
+{
+    int offset_a = ((const struct kowhai_batch_item_t*)a)->data_offset;
+    int offset_b = ((const struct kowhai_batch_item_t*)b)->data_offset;
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+// resolve the data offset of every item and check the item fits in its node, then sort the items by data offset
+static int resolve_batch(struct kowhai_tree_t *tree, int item_count, struct kowhai_batch_item_t* items)
+{
+    struct kowhai_node_t* path_nodes[BATCH_PATH_CACHE_DEPTH];
+    int path_offsets[BATCH_PATH_CACHE_DEPTH];
+    const union kowhai_symbol_t* path_symbols = NULL;
+    int path_depth = 0;
+    int i, status = KOW_STATUS_OK;
+
+    for (i = 0; i < item_count; i++)
+    {
+        struct kowhai_batch_item_t* item = &items[i];
+        struct kowhai_node_t* node = tree->desc;
+        int level = 0, offset = 0, size, available;
+        int num_symbols = item->num_symbols;
+
+        item->status = KOW_STATUS_INVALID_SYMBOL_PATH;
+        item->data_offset = 0;
+        if (IS_SLICE_PATH(num_symbols, item->symbols))
+            num_symbols--;
+        if (num_symbols < 1)
+        {
+            path_depth = 0;
+            goto next;
+        }
+
+        // reuse the path levels shared with the previous item
+        while (level < path_depth && level < num_symbols && item->symbols[level].symbol == path_symbols[level].symbol)
+            level++;
+        if (level > 0)
+        {
+            node = path_nodes[level - 1];
+            offset = path_offsets[level - 1];
+        }
+
+        // resolve the rest of the path one level at a time
+        path_symbols = item->symbols;
+        path_depth = level;
+        for (; level < num_symbols; level++)
+        {
+            const union kowhai_symbol_t* symbol = &item->symbols[level];
+            if (level == 0)
+            {
+                // the first symbol addresses the root branch
+                if (node->type != KOW_BRANCH_START || symbol->parts.name != node->symbol || node->count <= symbol->parts.array_index)
+                    goto next;
+                if (kowhai_get_node_size(node, &size) != KOW_STATUS_OK)
+                    goto next;
+                offset = size / node->count * symbol->parts.array_index;
+            }
+            else
+            {
+                int child_offset;
+                item->status = step_node(node, symbol, &child_offset, &node);
+                if (item->status != KOW_STATUS_OK)
+                    goto next;
+                offset += child_offset;
+            }
+            if (level < BATCH_PATH_CACHE_DEPTH)
+            {
+                path_nodes[level] = node;
+                path_offsets[level] = offset;
+                path_depth = level + 1;
+            }
+        }
+
+        // check the read/write wont overrun the node (from the addressed array item to the end of the node or slice)
+        item->status = kowhai_get_path_size(node, item->num_symbols, item->symbols, &available);
+        if (item->status != KOW_STATUS_OK)
+            goto next;
+        if (item->offset < 0)
+            item->status = KOW_STATUS_INVALID_OFFSET;
+        else if (item->offset + item->size > available)
+            item->status = KOW_STATUS_NODE_DATA_TOO_SMALL;
+        else
+            item->data_offset = offset + item->offset;
+
+next:
+        if (item->status != KOW_STATUS_OK && status == KOW_STATUS_OK)
+            status = item->status;
+    }
+
+    // stream through the tree data in order
+    if (status == KOW_STATUS_OK)
+        qsort(items, item_count, sizeof(struct kowhai_batch_item_t), compare_batch_items);
     return status;
 }
 
+int kowhai_read_batch(struct kowhai_tree_t *tree, int item_count, struct kowhai_batch_item_t* items)
+{
+    int i;
+    uint32_t sequence;
+    struct kowhai_seqlock_t* lock;
+    int status = resolve_batch(tree, item_count, items);
+    if (status != KOW_STATUS_OK)
+        return status;
+    // all the items are read from the same version of the tree data
+    lock = kowhai_seqlock_get(tree->data);
+    do
+    {
+        if (lock != NULL)
+            sequence = kowhai_seqlock_read_begin(lock);
+        for (i = 0; i < item_count; i++)
+            memcpy(items[i].buffer, (char*)tree->data + items[i].data_offset, items[i].size);
+    }
+    while (lock != NULL && kowhai_seqlock_read_retry(lock, sequence));
+    return KOW_STATUS_OK;
+}
+
+int kowhai_write_batch(struct kowhai_tree_t *tree, int item_count, struct kowhai_batch_item_t* items)
+{
+    int i, reach = 0;
+    struct kowhai_seqlock_t* lock;
+    struct kowhai_dirty_t* dirty;
+    struct kowhai_snapshot_t* snapshot;
+    int status = resolve_batch(tree, item_count, items);
+    if (status != KOW_STATUS_OK)
+        return status;
+    // the sort does not keep the order of items at the same offset, so overlapping writes have no defined winner
+    for (i = 0; i < item_count; i++)
+    {
+        if (items[i].size == 0)
+            continue;
+        if (items[i].data_offset < reach)
+        {
+            items[i].status = KOW_STATUS_INVALID_OFFSET;
+            return KOW_STATUS_INVALID_OFFSET;
+        }
+        reach = items[i].data_offset + items[i].size;
+    }
+    // all the items are published as one write
+    lock = kowhai_seqlock_get(tree->data);
+    dirty = kowhai_dirty_get(tree->data);
+    snapshot = snapshot_find(tree->data);
+    if (lock != NULL)
+        kowhai_seqlock_write_begin(lock);
+    for (i = 0; i < item_count; i++)
+    {
+        snapshot_save_from(snapshot, (char*)tree->data + items[i].data_offset, items[i].size);
+        memcpy((char*)tree->data + items[i].data_offset, items[i].buffer, items[i].size);
+        if (dirty != NULL)
+            kowhai_dirty_mark(dirty, (int)((char*)tree->data + items[i].data_offset - (char*)dirty->data), items[i].size);
+    }
+    if (lock != NULL)
+        kowhai_seqlock_write_end(lock);
+    return KOW_STATUS_OK;
+}
+
 int kowhai_get_int8(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int8_t* result)
 {
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_INT8 || node->type == KOW_UINT8)
     {
-        *result = *((int8_t*)((int8_t*)tree->data + offset));
+        get_data_hooks(tree->data, &hooks);
+        read_data(&hooks, result, (char*)tree->data + offset, sizeof(*result));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -289,12 +1568,14 @@ int kowhai_get_char(struct kowhai_tree_t *tree, int num_symbols, union kowhai_sy
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_CHAR)
     {
-        *result = *((char*)((char*)tree->data + offset));
+        get_data_hooks(tree->data, &hooks);
+        read_data(&hooks, result, (char*)tree->data + offset, sizeof(*result));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -305,12 +1586,14 @@ int kowhai_get_int16(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_INT16 || node->type == KOW_UINT16)
     {
-        *result = *((int16_t*)((char*)tree->data + offset));
+        get_data_hooks(tree->data, &hooks);
+        read_data(&hooks, result, (char*)tree->data + offset, sizeof(*result));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -321,12 +1604,14 @@ int kowhai_get_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_INT32 || node->type == KOW_UINT32)
     {
-        *result = *((uint32_t*)((char*)tree->data + offset));
+        get_data_hooks(tree->data, &hooks);
+        read_data(&hooks, result, (char*)tree->data + offset, sizeof(*result));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -337,12 +1622,14 @@ int kowhai_get_float(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_FLOAT)
     {
-        *result = *((float*)((char*)tree->data + offset));
+        get_data_hooks(tree->data, &hooks);
+        read_data(&hooks, result, (char*)tree->data + offset, sizeof(*result));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -353,13 +1640,14 @@ int kowhai_set_int8(struct kowhai_tree_t *tree, int num_symbols, union kowhai_sy
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_INT8 || node->type == KOW_UINT8)
     {
-        uint8_t* target_address = (uint8_t*)((uint8_t*)tree->data + offset);
-        *target_address = value;
+        get_data_hooks(tree->data, &hooks);
+        write_data(&hooks, (char*)tree->data + offset, &value, sizeof(value));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -370,13 +1658,14 @@ int kowhai_set_char(struct kowhai_tree_t *tree, int num_symbols, union kowhai_sy
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_CHAR)
     {
-        char* target_address = (char*)((char*)tree->data + offset);
-        *target_address = value;
+        get_data_hooks(tree->data, &hooks);
+        write_data(&hooks, (char*)tree->data + offset, &value, sizeof(value));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -387,13 +1676,14 @@ int kowhai_set_int16(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_INT16 || node->type == KOW_UINT16)
     {
-        int16_t* target_address = (int16_t*)((char*)tree->data + offset);
-        *target_address = value;
+        get_data_hooks(tree->data, &hooks);
+        write_data(&hooks, (char*)tree->data + offset, &value, sizeof(value));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -404,13 +1694,14 @@ int kowhai_set_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_INT32 || node->type == KOW_UINT32)
     {
-        uint32_t* target_address = (uint32_t*)((char*)tree->data + offset);
-        *target_address = value;
+        get_data_hooks(tree->data, &hooks);
+        write_data(&hooks, (char*)tree->data + offset, &value, sizeof(value));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
@@ -421,15 +1712,158 @@ int kowhai_set_float(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
     struct kowhai_node_t* node;
     int offset;
     int status;
+    struct data_hooks_t hooks;
     status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
     if (status != KOW_STATUS_OK)
         return status;
     if (node->type == KOW_FLOAT)
     {
-        float* target_address = (float*)((char*)tree->data + offset);
-        *target_address = value;
+        get_data_hooks(tree->data, &hooks);
+        write_data(&hooks, (char*)tree->data + offset, &value, sizeof(value));
         return status;
     }
     return KOW_STATUS_INVALID_NODE_TYPE;
 }
 
+
+int kowhai_resolve(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, struct kowhai_handle_t *handle)
+{
+    struct kowhai_node_t* node;
+    int offset;
+    int status;
+    int size;
+
+    // find this node
+    status = kowhai_get_node(tree->desc, num_symbols, symbols, &offset, &node);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(node, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    handle->element_size = size / node->count;
+
+    // the handle addresses the array items from the last symbols index to the end of the node (or slice)
+    status = kowhai_get_path_size(node, num_symbols, symbols, &size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    handle->tree = tree;
+    handle->node = node;
+    handle->offset = offset;
+    handle->count = size / handle->element_size;
+
+    // look up the lock, tracker and snapshots of the tree data once rather than on every access
+    handle->lock = kowhai_seqlock_get(tree->data);
+    handle->dirty = kowhai_dirty_get(tree->data);
+    handle->snapshots = snapshot_find(tree->data);
+    handle->registrations = registrations;
+    return KOW_STATUS_OK;
+}
+
+struct kowhai_seqlock_t* kowhai_handle_seqlock(const struct kowhai_handle_t *handle)
+{
+    struct data_hooks_t hooks;
+    get_handle_hooks(handle, &hooks);
+    return hooks.lock;
+}
+
+struct kowhai_dirty_t* kowhai_handle_dirty(const struct kowhai_handle_t *handle)
+{
+    struct data_hooks_t hooks;
+    get_handle_hooks(handle, &hooks);
+    return hooks.dirty;
+}
+
+int kowhai_handle_read(const struct kowhai_handle_t *handle, int read_offset, void* result, int read_size)
+{
+    struct data_hooks_t hooks;
+    if (read_offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    if (read_size + read_offset > handle->element_size * handle->count)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    get_handle_hooks(handle, &hooks);
+    read_data(&hooks, result, (char*)handle->tree->data + handle->offset + read_offset, read_size);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_handle_write(const struct kowhai_handle_t *handle, int write_offset, void* value, int write_size)
+{
+    struct data_hooks_t hooks;
+    if (write_offset < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+    if (write_size + write_offset > handle->element_size * handle->count)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    get_handle_hooks(handle, &hooks);
+    write_data(&hooks, (char*)handle->tree->data + handle->offset + write_offset, value, write_size);
+    return KOW_STATUS_OK;
+}
+
+// copy a single value out of / in to the tree if the handle node is one of the given types
+static int handle_get(const struct kowhai_handle_t *handle, uint16_t type1, uint16_t type2, void* result, int size)
+{
+    struct data_hooks_t hooks;
+    if (handle->node->type != type1 && handle->node->type != type2)
+        return KOW_STATUS_INVALID_NODE_TYPE;
+    get_handle_hooks(handle, &hooks);
+    read_data(&hooks, result, (char*)handle->tree->data + handle->offset, size);
+    return KOW_STATUS_OK;
+}
+
+static int handle_set(const struct kowhai_handle_t *handle, uint16_t type1, uint16_t type2, const void* value, int size)
+{
+    struct data_hooks_t hooks;
+    if (handle->node->type != type1 && handle->node->type != type2)
+        return KOW_STATUS_INVALID_NODE_TYPE;
+    get_handle_hooks(handle, &hooks);
+    write_data(&hooks, (char*)handle->tree->data + handle->offset, value, size);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_handle_get_int8(const struct kowhai_handle_t *handle, int8_t* result)
+{
+    return handle_get(handle, KOW_INT8, KOW_UINT8, result, sizeof(int8_t));
+}
+
+int kowhai_handle_get_char(const struct kowhai_handle_t *handle, char* result)
+{
+    return handle_get(handle, KOW_CHAR, KOW_CHAR, result, sizeof(char));
+}
+
+int kowhai_handle_get_int16(const struct kowhai_handle_t *handle, int16_t* result)
+{
+    return handle_get(handle, KOW_INT16, KOW_UINT16, result, sizeof(int16_t));
+}
+
+int kowhai_handle_get_int32(const struct kowhai_handle_t *handle, int32_t* result)
+{
+    return handle_get(handle, KOW_INT32, KOW_UINT32, result, sizeof(int32_t));
+}
+
+int kowhai_handle_get_float(const struct kowhai_handle_t *handle, float* result)
+{
+    return handle_get(handle, KOW_FLOAT, KOW_FLOAT, result, sizeof(float));
+}
+
+int kowhai_handle_set_int8(const struct kowhai_handle_t *handle, uint8_t value)
+{
+    return handle_set(handle, KOW_INT8, KOW_UINT8, &value, sizeof(uint8_t));
+}
+
+int kowhai_handle_set_char(const struct kowhai_handle_t *handle, char value)
+{
+    return handle_set(handle, KOW_CHAR, KOW_CHAR, &value, sizeof(char));
+}
+
+int kowhai_handle_set_int16(const struct kowhai_handle_t *handle, int16_t value)
+{
+    return handle_set(handle, KOW_INT16, KOW_UINT16, &value, sizeof(int16_t));
+}
+
+int kowhai_handle_set_int32(const struct kowhai_handle_t *handle, int32_t value)
+{
+    return handle_set(handle, KOW_INT32, KOW_UINT32, &value, sizeof(int32_t));
+}
+
+int kowhai_handle_set_float(const struct kowhai_handle_t *handle, float value)
+{
+    return handle_set(handle, KOW_FLOAT, KOW_FLOAT, &value, sizeof(float));
+}
@@ -8,6 +8,7 @@
 #pragma pack(1)
 
 #define KOW_UNDEFINED_SYMBOL 65535
+#define KOW_SLICE_SYMBOL 65534
 #define KOW_TREE_FOR_FUNCTION_CALL_ONLY 1
 
 /**
@@ -64,7 +65,9 @@ union kowhai_symbol_t
         uint16_t array_index;   ///< zero based array index of this node
     } parts;
 };
-#define KOWHAI_SYMBOL(name, array_index) ((array_index << 16) + name)
+#define KOWHAI_SYMBOL(name, array_index) (((array_index) << 16) + (name))
+/// append to a symbol path to address count array items starting at the array index of the last path symbol
+#define KOWHAI_SLICE(count) KOWHAI_SYMBOL(KOW_SLICE_SYMBOL, (count))
 
 #pragma pack()
 
@@ -85,6 +88,184 @@ union kowhai_symbol_t
 #define KOW_STATUS_NO_DATA                 14
 #define KOW_STATUS_PATH_TOO_SMALL          15
 #define KOW_STATUS_UNKNOWN_ERROR           16
+#define KOW_STATUS_TREE_TOO_DEEP           17
+
+#define KOW_INDEX_EMPTY 0xFFFF
+
+// tree data layouts (see kowhai_descriptor_compile_layout)
+#define KOW_LAYOUT_PACKED   0       ///< no padding between nodes, this is the default and the protocol wire layout
+#define KOW_LAYOUT_ALIGNED  1       ///< nodes are padded to their natural alignment (like a non packed c struct)
+
+/**
+ * @brief per node information calculated by kowhai_descriptor_compile
+ */
+struct kowhai_index_entry_t
+{
+    int offset;                 ///< byte offset of this node from the start of its parent branch (0 for the root node)
+    int size;                   ///< complete size of this node including all the sub-elements and array items
+    int stride;                 ///< size of a single array item of this node (ie size / count)
+    uint16_t node_count;        ///< number of descriptor nodes this node spans (branch start to branch end inclusive, 1 for leaf nodes)
+    uint16_t parent;            ///< index of the parent branch node (KOW_INDEX_EMPTY for the root node)
+    uint16_t align;             ///< alignment of this node in the tree data (always 1 for packed layouts)
+};
+
+/**
+ * @brief a compiled descriptor, see kowhai_descriptor_compile
+ */
+struct kowhai_index_t
+{
+    const struct kowhai_node_t *desc;       ///< the descriptor this index was compiled from
+    int node_count;                         ///< number of nodes in desc (and number of entries used)
+    struct kowhai_index_entry_t *entries;   ///< one entry per descriptor node
+    uint16_t *symbol_table;                 ///< hash table mapping (parent, symbol) to a node index
+    int symbol_table_size;                  ///< number of slots in symbol_table
+    int layout;                             ///< tree data layout the offsets and sizes were calculated for (KOW_LAYOUT_xxx)
+    struct kowhai_index_t *next;            ///< next compiled descriptor (internal use)
+};
+
+/**
+ * @brief a sequence lock protecting tree data shared between threads, see kowhai_seqlock_init
+ */
+struct kowhai_seqlock_t
+{
+    volatile uint32_t sequence;             ///< even while the data is stable, odd while a write is in progress
+    void *data;                             ///< start of the tree data this lock protects
+    int size;                               ///< number of bytes of tree data protected
+    struct kowhai_seqlock_t *next;          ///< next registered lock (internal use)
+};
+
+/**
+ * @brief change tracking of a single leaf node array of a tree (one per leaf of each branch array item)
+ */
+struct kowhai_dirty_entry_t
+{
+    const struct kowhai_node_t *node;       ///< the leaf node
+    int offset;                             ///< byte offset of the leaf data from the start of the tree data
+    int size;                               ///< bytes of all the leaf array items
+    uint32_t generation;                    ///< generation of the last write to the leaf data (0 if clean)
+    int reach;                              ///< end of the furthest reaching entry up to this one (internal use)
+};
+
+/**
+ * @brief change tracking of the data of a tree, see kowhai_dirty_init
+ */
+struct kowhai_dirty_t
+{
+    void *data;                             ///< start of the tree data tracked
+    int size;                               ///< number of bytes of tree data tracked
+    struct kowhai_dirty_entry_t *entries;   ///< one entry per leaf, sorted by offset
+    int entry_count;                        ///< number of entries used
+    uint32_t generation;                    ///< generation of the last write to the tree data
+    struct kowhai_dirty_t *next;            ///< next registered tracker (internal use)
+};
+
+/**
+ * @brief called for each changed leaf by kowhai_dirty_enumerate
+ * @param param, application specific parameter passed through
+ * @param entry, the changed leaf (kowhai_create_symbol_path2 can turn entry offset into a symbol path)
+ * @return kowhai status value, anything other than KOW_STATUS_OK stops the enumeration
+ */
+typedef int (*kowhai_on_dirty_t)(void* param, const struct kowhai_dirty_entry_t *entry);
+
+/**
+ * @brief a copy-on-write snapshot of the data of a tree, see kowhai_snapshot_init
+ */
+struct kowhai_snapshot_t
+{
+    struct kowhai_node_t *desc;             ///< descriptor of the tree data
+    void *data;                             ///< start of the live tree data
+    int size;                               ///< number of bytes of tree data
+    void *copy;                             ///< the snapshot data (only chunks marked in saved are valid)
+    uint8_t *saved;                         ///< one bit per chunk, set once the chunk has been copied
+    int chunk_size;                         ///< number of bytes of tree data per chunk
+    volatile int active;                    ///< non zero between kowhai_snapshot_begin and kowhai_snapshot_end
+    struct kowhai_snapshot_t *next;         ///< next registered snapshot (internal use)
+};
+
+// kowhai_walk events
+#define KOW_WALK_BRANCH_START   1   ///< entering an array item of a branch
+#define KOW_WALK_LEAF           2   ///< a leaf node (all of its array items)
+#define KOW_WALK_BRANCH_END     3   ///< leaving an array item of a branch
+
+/**
+ * @brief an open branch of a kowhai_walk, the walk needs one frame per branch level (see kowhai_walk_init)
+ */
+struct kowhai_walk_frame_t
+{
+    const struct kowhai_node_t *node;   ///< the branch start node
+    const struct kowhai_node_t *end;    ///< the branch end node (NULL until known)
+    int offset;                         ///< offset of the current array item of the branch
+    int index;                          ///< the current array item of the branch
+    int size;                           ///< bytes used so far by the children of the current item (internal use)
+    int stride;                         ///< size of a single array item of the branch (0 until known)
+    int child_offset;                   ///< offset of the current child from the start of the item (internal use)
+    const void *user;                   ///< free for the walk user to keep per branch state (NULL when the branch is entered)
+    void *user_data;                    ///< free for the walk user to keep per branch state (NULL when the branch is entered)
+    struct kowhai_walk_frame_t *parent; ///< the frame of the branch above (internal use)
+    struct kowhai_walk_frame_t *child;  ///< the frame for the branch below (internal use)
+};
+
+/**
+ * @brief iterator over a tree, see kowhai_walk_init and kowhai_walk_next
+ */
+struct kowhai_walk_t
+{
+    int event;                                      ///< what the walk is at (KOW_WALK_xxx)
+    const struct kowhai_node_t *node;               ///< the current node (the branch start node for branch events)
+    const struct kowhai_node_t *end;                ///< the branch end node (KOW_WALK_BRANCH_END only)
+    void *data;                                     ///< data of the current node (or branch array item), NULL if walking a descriptor only
+    int offset;                                     ///< byte offset of data from the start of the tree data
+    int size;                                       ///< bytes of all the leaf array items, or of the branch array item (0 at a branch start if not yet known)
+    int index;                                      ///< the current branch array item (0 for leaves)
+    int depth;                                      ///< number of branches above the current node
+    struct kowhai_walk_frame_t *frame;              ///< the innermost open branch (the current branch at branch events, the parent of a leaf), NULL at a root leaf
+
+    // internal state
+    const struct kowhai_node_t *desc;
+    void *tree_data;
+    const struct kowhai_index_t *compiled;
+    const struct kowhai_node_t *next;
+    int level;
+    struct kowhai_walk_frame_t *frames;
+};
+
+/**
+ * @brief called for each position of a walk by kowhai_walk_tree
+ * @param param, application specific parameter passed through
+ * @param walk, the walk at its new position (kowhai_walk_skip may be called on it)
+ * @return kowhai status value, anything other than KOW_STATUS_OK stops the walk
+ */
+typedef int (*kowhai_walk_visit_t)(void* param, struct kowhai_walk_t *walk);
+
+/**
+ * @brief a symbol path resolved once by kowhai_resolve, used for repeated reads and writes of the same node
+ */
+struct kowhai_handle_t
+{
+    struct kowhai_tree_t *tree;     ///< the tree the node belongs to
+    struct kowhai_node_t *node;     ///< the node the symbol path resolved to
+    int offset;                     ///< byte offset of the addressed node data from the start of the tree data
+    int element_size;               ///< size of a single array item of the node
+    int count;                      ///< number of array items from the addressed item to the end of the node
+    struct kowhai_seqlock_t *lock;  ///< the sequence lock of the tree data when the handle was resolved
+    struct kowhai_dirty_t *dirty;   ///< the change tracker of the tree data when the handle was resolved
+    struct kowhai_snapshot_t *snapshots; ///< the latest registered snapshot of the tree data when the handle was resolved
+    uint32_t registrations;         ///< the lock, tracker and snapshots above are used while no others are registered or released
+};
+
+/**
+ * @brief one read or write of a batch, see kowhai_read_batch and kowhai_write_batch
+ */
+struct kowhai_batch_item_t
+{
+    int num_symbols;                    ///< number of symbols that make up the symbols path below
+    union kowhai_symbol_t* symbols;     ///< a collection of symbols that forms a path to the node to read/write
+    int offset;                         ///< the offset into the node data to start reading/writing at
+    void* buffer;                       ///< the buffer to read the result into or write from
+    int size;                           ///< the number of bytes to read/write
+    int status;                         ///< set to the kowhai status of this item
+    int data_offset;                    ///< set to the offset of this item from the start of the tree data
+};
 
 /**
  * @brief return the version of the kowhai library
@@ -126,8 +307,319 @@ int kowhai_get_node_size(const struct kowhai_node_t *node, int *size);
  */
 int kowhai_get_node_count(const struct kowhai_node_t *node, int *count);
 
+/**
+ * @brief start walking a tree (or a branch of a descriptor) in descriptor order without recursion
+ * Each call to kowhai_walk_next moves to the next branch array item start, leaf node or branch array item end, so
+ * every array item of a branch is visited in turn and data offsets are calculated as the walk goes (honouring the
+ * layout of a compiled descriptor).
+ * @param walk, the walk state to initialise
+ * @param desc, the node to walk (normally the root branch of a descriptor)
+ * @param data, the tree data described by desc or NULL to only walk the descriptor
+ * @param frames, storage for the open branches of the walk (one per branch level), more can be added with
+ * kowhai_walk_add_frame
+ * @param frame_count, number of frames
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_walk_init(struct kowhai_walk_t *walk, const struct kowhai_node_t *desc, void *data, struct kowhai_walk_frame_t *frames, int frame_count);
+
+/**
+ * @brief give a walk storage for one more branch level (eg after kowhai_walk_next returned KOW_STATUS_TREE_TOO_DEEP)
+ * @param walk, the walk to extend (see kowhai_walk_init)
+ * @param frame, the frame to add, it must stay valid while the walk is used
+ */
+void kowhai_walk_add_frame(struct kowhai_walk_t *walk, struct kowhai_walk_frame_t *frame);
+
+/**
+ * @brief move a walk to its next position
+ * @param walk, the walk to move (see kowhai_walk_init)
+ * @return KOW_STATUS_OK if the walk is at a new position, KOW_STATUS_NOT_FOUND once all nodes have been visited,
+ * KOW_STATUS_TREE_TOO_DEEP if a branch is deeper than the walk has frames for (the walk does not move, so it can be
+ * continued after kowhai_walk_add_frame) or other on error
+ */
+int kowhai_walk_next(struct kowhai_walk_t *walk);
+
+/**
+ * @brief skip the children of the branch array item a walk is at, the next position is the end of the item
+ * @param walk, a walk at a KOW_WALK_BRANCH_START position
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_walk_skip(struct kowhai_walk_t *walk);
+
+/**
+ * @brief get the symbol path from the root of a walk to its current node
+ * @param walk, a walk at a position (see kowhai_walk_next)
+ * @param path, the symbol path (the array index of a leaf is 0)
+ * @param num_symbols, size of path on entry and number of symbols in it on return (walk depth + 1)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or KOW_STATUS_TARGET_BUFFER_TOO_SMALL if path is too small
+ */
+int kowhai_walk_get_path(const struct kowhai_walk_t *walk, union kowhai_symbol_t *path, int *num_symbols);
+
+/**
+ * @brief walk a whole tree calling visit at every position, the frames for the branch levels are kept on the stack
+ * (one small frame per level as the walk first reaches it) so trees of any depth can be walked
+ * @param desc, the node to walk (normally the root branch of a descriptor)
+ * @param data, the tree data described by desc or NULL to only walk the descriptor
+ * @param visit, called at every position of the walk
+ * @param param, application specific parameter passed through visit
+ * @return kowhai status value, ie KOW_STATUS_OK once every position was visited or the first status other than
+ * KOW_STATUS_OK returned by visit or the walk
+ */
+int kowhai_walk_tree(const struct kowhai_node_t *desc, void *data, kowhai_walk_visit_t visit, void* param);
+
+/**
+ * @brief calculate the number of bytes a symbol path addresses, ie from the addressed array item to the end of the node
+ * or if the path ends with a KOWHAI_SLICE symbol the number of bytes in the slice
+ * @param node, the node the symbol path resolves to (see kowhai_get_node)
+ * @param num_symbols, number of symbols in the symbols path
+ * @param symbols, the symbol path
+ * @param size, set to the number of bytes addressed
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_get_path_size(const struct kowhai_node_t *node, int num_symbols, const union kowhai_symbol_t *symbols, int *size);
+
+/**
+ * @brief compile a descriptor into an index so symbol paths can be resolved with one table lookup per path level
+ * Once compiled kowhai_get_node (and so kowhai_read, kowhai_write, kowhai_get_xxx, kowhai_set_xxx and the protocol
+ * server) use the index for any node within desc, and kowhai_get_node_size/kowhai_get_node_count return the cached
+ * node sizes and counts. The descriptor must not be changed while it is compiled.
+ * @param desc, the descriptor to compile (must start with a branch)
+ * @param index, the index to initialise, this is registered with the library until kowhai_descriptor_release is called
+ * @param entries, storage for the per node information (one entry per descriptor node is required)
+ * @param entry_count, number of items in entries
+ * @param symbol_table, storage for the symbol lookup table, or NULL to find children by stepping over the cached node counts
+ * @param symbol_table_size, number of items in symbol_table (must be larger than the number of descriptor nodes, twice as large is a good choice)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_descriptor_compile(const struct kowhai_node_t *desc, struct kowhai_index_t *index, struct kowhai_index_entry_t *entries, int entry_count, uint16_t *symbol_table, int symbol_table_size);
+
+/**
+ * @brief compile a descriptor into an index (as kowhai_descriptor_compile) for a given tree data layout
+ * With KOW_LAYOUT_ALIGNED every node is placed at a multiple of its natural alignment (the size of its type, or the
+ * largest alignment of its children for branches) and branch items are padded to their alignment, so the tree data
+ * matches a non packed c struct and can be accessed with aligned loads. The layout only applies while the index is
+ * registered. kowhai_walk (and so the diff/merge utilities) and the binary snapshot functions follow it. The protocol
+ * server and the json serialize functions only handle packed tree data, so while a descriptor is compiled aligned the
+ * server answers KOW_CMD_ERROR_INVALID_TREE_ID for its trees and kowhai_serialize_tree, kowhai_serialize_nodes and
+ * kowhai_deserialize_nodes return KOW_STATUS_INVALID_DESCRIPTOR.
+ * @param desc, the descriptor to compile (must start with a branch)
+ * @param layout, the tree data layout (KOW_LAYOUT_PACKED or KOW_LAYOUT_ALIGNED)
+ * @param index, the index to initialise, this is registered with the library until kowhai_descriptor_release is called
+ * @param entries, storage for the per node information (one entry per descriptor node is required)
+ * @param entry_count, number of items in entries
+ * @param symbol_table, storage for the symbol lookup table, or NULL to find children by stepping over the cached node counts
+ * @param symbol_table_size, number of items in symbol_table (must be larger than the number of descriptor nodes)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_descriptor_compile_layout(const struct kowhai_node_t *desc, int layout, struct kowhai_index_t *index, struct kowhai_index_entry_t *entries, int entry_count, uint16_t *symbol_table, int symbol_table_size);
+
+/**
+ * @brief unregister a compiled descriptor, kowhai_get_node etc will walk the descriptor again
+ * @param index, the index previously passed to kowhai_descriptor_compile
+ */
+void kowhai_descriptor_release(struct kowhai_index_t *index);
+
+/**
+ * @brief find the compiled index (if any) that a descriptor node belongs to
+ * @param node, any node within a compiled descriptor
+ * @return the index or NULL if the node is not part of a compiled descriptor
+ */
+const struct kowhai_index_t* kowhai_descriptor_get_index(const struct kowhai_node_t *node);
+
+/**
+ * @brief get the tree data layout a descriptor is currently compiled for
+ * @param node, any node within a descriptor
+ * @return KOW_LAYOUT_ALIGNED if the descriptor is compiled with kowhai_descriptor_compile_layout(KOW_LAYOUT_ALIGNED) otherwise KOW_LAYOUT_PACKED
+ */
+int kowhai_descriptor_layout(const struct kowhai_node_t *node);
+
+/**
+ * @brief protect the data of a tree with a sequence lock so it can be read and written from several threads
+ * Once registered kowhai_read, kowhai_write, the batch/handle functions, kowhai_get_xxx and kowhai_set_xxx (and so the
+ * protocol server READ_DATA/WRITE_DATA commands) publish their writes under the lock and retry reads that overlap a
+ * write, so every read returns data from a single point in time without readers taking a mutex. Code that writes the
+ * tree data directly must do so between kowhai_seqlock_write_begin and kowhai_seqlock_write_end. Locks should be
+ * registered before other threads use the library.
+ * @param lock, the lock to initialise, this is registered with the library until kowhai_seqlock_release is called
+ * @param tree, the tree whose data is protected
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_seqlock_init(struct kowhai_seqlock_t *lock, struct kowhai_tree_t *tree);
+
+/**
+ * @brief unregister a sequence lock, tree data accesses are no longer synchronised
+ * @param lock, the lock previously passed to kowhai_seqlock_init
+ */
+void kowhai_seqlock_release(struct kowhai_seqlock_t *lock);
+
+/**
+ * @brief find the sequence lock (if any) that protects some tree data
+ * @param data, any address within the tree data
+ * @return the lock or NULL if the data is not protected
+ */
+struct kowhai_seqlock_t* kowhai_seqlock_get(const void *data);
+
+/**
+ * @brief start a read of protected tree data, waits for any write in progress to finish
+ * The returned sequence also serves as a version of the tree data, it increases by 2 with every published write.
+ * @param lock, the lock protecting the data
+ * @return the sequence to pass to kowhai_seqlock_read_retry once the data has been copied
+ */
+uint32_t kowhai_seqlock_read_begin(struct kowhai_seqlock_t *lock);
+
+/**
+ * @brief finish a read of protected tree data
+ * @param lock, the lock protecting the data
+ * @param sequence, the value returned by kowhai_seqlock_read_begin
+ * @return non zero if a write overlapped the read and the data must be read again
+ */
+int kowhai_seqlock_read_retry(struct kowhai_seqlock_t *lock, uint32_t sequence);
+
+/**
+ * @brief start a write of protected tree data, waits for any other writer to finish
+ * @note writes do not nest, do not call kowhai_write etc on the protected tree before kowhai_seqlock_write_end
+ * @param lock, the lock protecting the data
+ */
+void kowhai_seqlock_write_begin(struct kowhai_seqlock_t *lock);
+
+/**
+ * @brief publish a write of protected tree data
+ * @param lock, the lock protecting the data
+ */
+void kowhai_seqlock_write_end(struct kowhai_seqlock_t *lock);
+
+/**
+ * @brief track which leaves of a tree are written so only changed data has to be synchronised
+ * Once registered kowhai_write, kowhai_write_batch, kowhai_handle_write, kowhai_set_xxx (and so the protocol server
+ * WRITE_DATA command) mark the leaves they write with a new generation. Code that writes the tree data directly should
+ * call kowhai_dirty_mark. Trackers should be registered before other threads use the library.
+ * @param dirty, the tracker to initialise, this is registered with the library until kowhai_dirty_release is called
+ * @param tree, the tree whose data is tracked
+ * @param entries, storage for the per leaf tracking (one entry per leaf of each branch array item is required)
+ * @param entry_count, number of items in entries, set to the number of entries required on return
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_TARGET_BUFFER_TOO_SMALL if entry_count is too small
+ */
+int kowhai_dirty_init(struct kowhai_dirty_t *dirty, struct kowhai_tree_t *tree, struct kowhai_dirty_entry_t *entries, int *entry_count);
+
+/**
+ * @brief unregister a change tracker, tree writes are no longer tracked
+ * @param dirty, the tracker previously passed to kowhai_dirty_init
+ */
+void kowhai_dirty_release(struct kowhai_dirty_t *dirty);
+
+/**
+ * @brief find the change tracker (if any) of some tree data
+ * @param data, any address within the tree data
+ * @return the tracker or NULL if the data is not tracked
+ */
+struct kowhai_dirty_t* kowhai_dirty_get(const void *data);
+
+/**
+ * @brief mark the leaves overlapping some tree data as changed, this starts a new generation
+ * @param dirty, the tracker of the tree data
+ * @param offset, byte offset of the changed data from the start of the tree data
+ * @param size, number of bytes changed
+ */
+void kowhai_dirty_mark(struct kowhai_dirty_t *dirty, int offset, int size);
+
+/**
+ * @brief check if any leaf overlapping some tree data changed after a generation
+ * @param dirty, the tracker of the tree data
+ * @param since, only count leaves written after this generation
+ * @param offset, byte offset of the data from the start of the tree data
+ * @param size, number of bytes of data
+ * @return non zero if a leaf overlapping the data changed
+ */
+int kowhai_dirty_changed(struct kowhai_dirty_t *dirty, uint32_t since, int offset, int size);
+
+/**
+ * @brief call on_dirty for every leaf changed after a generation, in tree data order
+ * @param dirty, the tracker of the tree data
+ * @param since, only report leaves written after this generation (0 for all changed leaves), a client that keeps the
+ * dirty->generation of its last sync can pass it here to get just the leaves changed since
+ * @param param, application specific parameter passed through the on_dirty callback
+ * @param on_dirty, called for each changed leaf
+ * @return kowhai status value, ie KOW_STATUS_OK on success or the first status on_dirty returned other than KOW_STATUS_OK
+ */
+int kowhai_dirty_enumerate(struct kowhai_dirty_t *dirty, uint32_t since, void* param, kowhai_on_dirty_t on_dirty);
+
+/**
+ * @brief mark every leaf as clean (generations keep counting from the current dirty->generation)
+ * @param dirty, the tracker of the tree data
+ */
+void kowhai_dirty_clear(struct kowhai_dirty_t *dirty);
+
+/**
+ * @brief register storage for copy-on-write snapshots of a tree
+ * While a snapshot is active kowhai_write, kowhai_write_batch, kowhai_handle_write and kowhai_set_xxx (and so the
+ * protocol server WRITE_DATA command) first copy each chunk of tree data they are about to change into the snapshot,
+ * so taking a snapshot costs nothing up front and a write only copies a chunk the first time it changes. Code that
+ * writes the tree data directly must call kowhai_snapshot_save first. If the tree is used from several threads it
+ * needs a kowhai_seqlock_t, which the snapshot uses to order chunk copies against writes.
+ * @param snapshot, the snapshot to initialise, this is registered with the library until kowhai_snapshot_release is called
+ * @param tree, the tree to snapshot
+ * @param copy, storage for the snapshot data (as large as the tree data)
+ * @param copy_size, number of bytes in copy
+ * @param saved, storage for the chunk bitmap (one bit per chunk)
+ * @param saved_size, number of bytes in saved
+ * @param chunk_size, number of bytes of tree data per chunk
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_TARGET_BUFFER_TOO_SMALL if copy or saved are too small
+ */
+int kowhai_snapshot_init(struct kowhai_snapshot_t *snapshot, struct kowhai_tree_t *tree, void *copy, int copy_size, uint8_t *saved, int saved_size, int chunk_size);
+
+/**
+ * @brief unregister snapshot storage, writes no longer copy chunks into it
+ * @param snapshot, the snapshot previously passed to kowhai_snapshot_init
+ */
+void kowhai_snapshot_release(struct kowhai_snapshot_t *snapshot);
+
+/**
+ * @brief find an inactive snapshot (if any) of some tree data
+ * @param data, any address within the tree data
+ * @return the snapshot or NULL if there is no idle snapshot of the data
+ */
+struct kowhai_snapshot_t* kowhai_snapshot_get(const void *data);
+
+/**
+ * @brief capture the tree data as it is now, this only clears the chunk bitmap
+ * @param snapshot, an inactive snapshot
+ * @return kowhai status value, ie KOW_STATUS_OK on success or KOW_STATUS_INVALID_SEQUENCE if the snapshot is already active
+ */
+int kowhai_snapshot_begin(struct kowhai_snapshot_t *snapshot);
+
+/**
+ * @brief finish with a snapshot, writes no longer copy chunks into it
+ * @param snapshot, an active snapshot
+ */
+void kowhai_snapshot_end(struct kowhai_snapshot_t *snapshot);
+
+/**
+ * @brief read tree data as it was when the snapshot began
+ * @param snapshot, an active snapshot
+ * @param offset, byte offset from the start of the tree data to read from
+ * @param result, the buffer to read into
+ * @param size, number of bytes to read
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_snapshot_read(struct kowhai_snapshot_t *snapshot, int offset, void *result, int size);
+
+/**
+ * @brief get a tree of the snapshot data (ie to serialize or diff), chunks not yet copied are copied now
+ * @param snapshot, an active snapshot
+ * @param tree, set to the descriptor of the tree and the snapshot data
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_snapshot_get_tree(struct kowhai_snapshot_t *snapshot, struct kowhai_tree_t *tree);
+
+/**
+ * @brief copy the chunks of tree data about to be written into every active snapshot that does not hold them yet
+ * @param data, the tree data about to be written
+ * @param size, number of bytes about to be written
+ */
+void kowhai_snapshot_save(const void *data, int size);
+
 /**
  * @brief Read from a tree data buffer starting at a symbol path
+ * If the symbol path ends with a KOWHAI_SLICE symbol the read must fit within the slice
  * @param tree, the tree to read from
  * @param num_symbols, number of symbols that make up the symbols path below
  * @param symbols, a collection of symbols that forms a path to the node to start the read from (not including the read_offset below)
@@ -140,6 +632,7 @@ int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol
 
 /**
  * @brief Write to a tree data buffer starting at a symbol path
+ * If the symbol path ends with a KOWHAI_SLICE symbol the write must fit within the slice
  * @param tree, the tree to write to
  * @param num_symbols, number of symbols that make up the symbols path below
  * @param symbols, a collection of symbols that forms a path to the node to start the write from (not including the wirte_offset below)
@@ -150,6 +643,30 @@ int kowhai_read(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol
  */
 int kowhai_write(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, int write_offset, void* value, int write_size);
 
+/**
+ * @brief Read many nodes from a tree data buffer in one call
+ * Symbol paths that share a prefix with the previous item only resolve the remaining path levels, and the
+ * copies are done in tree data order. If any item fails to resolve nothing is read.
+ * @note items are sorted by data_offset on return (so passing the same items again resolves them in data order)
+ * @param tree, the tree to read from
+ * @param item_count, number of items
+ * @param items, the reads to perform (status and data_offset are updated for each item)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or the status of the first item that failed
+ */
+int kowhai_read_batch(struct kowhai_tree_t *tree, int item_count, struct kowhai_batch_item_t* items);
+
+/**
+ * @brief Write many nodes to a tree data buffer in one call
+ * Every item is validated before anything is written, so either all the items are written or none are.
+ * Items that write to overlapping tree data are refused (KOW_STATUS_INVALID_OFFSET).
+ * @note items are sorted by data_offset on return (so passing the same items again resolves them in data order)
+ * @param tree, the tree to write to
+ * @param item_count, number of items
+ * @param items, the writes to perform (status and data_offset are updated for each item)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or the status of the first item that failed
+ */
+int kowhai_write_batch(struct kowhai_tree_t *tree, int item_count, struct kowhai_batch_item_t* items);
+
 /**
  * @brief Get a single byte char setting specified by a symbol path from a settings buffer
  * @param tree, the tree to get the value from
@@ -232,5 +749,68 @@ int kowhai_set_int32(struct kowhai_tree_t *tree, int num_symbols, union kowhai_s
  */
 int kowhai_set_float(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, float value);
 
-#endif
+/**
+ * @brief Resolve a symbol path once so the node can be read and written without walking the descriptor again
+ * @param tree, the tree the symbol path belongs to
+ * @param num_symbols, number of symbols that make up the symbols path below
+ * @param symbols, a collection of symbols that forms a path to the node
+ * @param handle, populated with the resolved node information on success
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_resolve(struct kowhai_tree_t *tree, int num_symbols, union kowhai_symbol_t* symbols, struct kowhai_handle_t *handle);
+
+/**
+ * @brief Get the sequence lock protecting the tree data of a resolved node
+ * The lock is cached by kowhai_resolve, it is looked up again if a lock, change tracker or snapshot has been registered
+ * or released since the handle was resolved
+ * @param handle, the resolved node
+ * @return the sequence lock of the tree data, or NULL if the data is not protected
+ */
+struct kowhai_seqlock_t* kowhai_handle_seqlock(const struct kowhai_handle_t *handle);
+
+/**
+ * @brief Get the change tracker of the tree data of a resolved node (cached as for kowhai_handle_seqlock)
+ * @param handle, the resolved node
+ * @return the change tracker of the tree data, or NULL if the data is not tracked
+ */
+struct kowhai_dirty_t* kowhai_handle_dirty(const struct kowhai_handle_t *handle);
+
+/**
+ * @brief Read from a tree data buffer starting at a resolved node
+ * @param handle, the resolved node to start the read from (not including the read_offset below)
+ * @param read_offset, the offset into the node data to start reading from
+ * @param result, the buffer to read the result into
+ * @param read_size, the number of bytes to read into the result
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_read(const struct kowhai_handle_t *handle, int read_offset, void* result, int read_size);
+
+/**
+ * @brief Write to a tree data buffer starting at a resolved node
+ * @param handle, the resolved node to start the write from (not including the write_offset below)
+ * @param write_offset, the offset into the node data to start writing at
+ * @param value, the buffer to write from
+ * @param write_size, the number of bytes to write into the tree data buffer
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_write(const struct kowhai_handle_t *handle, int write_offset, void* value, int write_size);
 
+/**
+ * @brief Get/set a value of a resolved node, these match kowhai_get_xxx/kowhai_set_xxx but skip the symbol path lookup
+ * @param handle, the resolved node
+ * @param result, the value of the node
+ * @param value, the new value to change the node to
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_handle_get_int8(const struct kowhai_handle_t *handle, int8_t* result);
+int kowhai_handle_get_char(const struct kowhai_handle_t *handle, char* result);
+int kowhai_handle_get_int16(const struct kowhai_handle_t *handle, int16_t* result);
+int kowhai_handle_get_int32(const struct kowhai_handle_t *handle, int32_t* result);
+int kowhai_handle_get_float(const struct kowhai_handle_t *handle, float* result);
+int kowhai_handle_set_int8(const struct kowhai_handle_t *handle, uint8_t value);
+int kowhai_handle_set_char(const struct kowhai_handle_t *handle, char value);
+int kowhai_handle_set_int16(const struct kowhai_handle_t *handle, int16_t value);
+int kowhai_handle_set_int32(const struct kowhai_handle_t *handle, int32_t value);
+int kowhai_handle_set_float(const struct kowhai_handle_t *handle, float value);
+
+#endif
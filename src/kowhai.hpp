@@ -0,0 +1,269 @@
+#ifndef _KOWHAI_HPP_
+#define _KOWHAI_HPP_
+
+/**
+ * @brief header only c++17 layer over kowhai
+ *
+ * A descriptor is declared as a constexpr array of kowhai_node_t, ie
+ *
+ *   constexpr kowhai_node_t settings_desc[] = { { KOW_BRANCH_START, SYM_SETTINGS, 1, 0 }, ... };
+ *
+ * and kowhai::view<settings_desc> gives typed access to a data buffer described by it. Node offsets,
+ * sizes and types are computed at compile time from the descriptor so an access is a fixed size copy
+ * at a constant offset (plus the array index strides). The same descriptor and data can be handed to
+ * the c api (and the protocol server) via view::tree().
+ *
+ * The offsets are those of the packed layout (KOW_LAYOUT_PACKED) so a view can not be used on the data of
+ * a descriptor compiled with another layout.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+extern "C" {
+#include "kowhai.h"
+}
+
+namespace kowhai {
+
+namespace detail {
+
+constexpr bool is_branch(uint16_t type)
+{
+    return type == KOW_BRANCH_START || type == KOW_BRANCH_U_START;
+}
+
+constexpr int type_size(uint16_t type)
+{
+    switch (type)
+    {
+        case KOW_INT8:
+        case KOW_UINT8:
+        case KOW_CHAR:
+            return 1;
+        case KOW_INT16:
+        case KOW_UINT16:
+            return 2;
+        case KOW_INT32:
+        case KOW_UINT32:
+        case KOW_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+// index of the node following node i and all its children
+template <size_t N>
+constexpr size_t next_sibling(const kowhai_node_t (&desc)[N], size_t i)
+{
+    int depth = 0;
+    do
+    {
+        if (is_branch(desc[i].type))
+            depth++;
+        else if (desc[i].type == KOW_BRANCH_END)
+            depth--;
+        i++;
+    }
+    while (depth > 0 && i < N);
+    return i;
+}
+
+// size of a single array item of node i
+template <size_t N>
+constexpr int element_size(const kowhai_node_t (&desc)[N], size_t i)
+{
+    int size = 0;
+    if (!is_branch(desc[i].type))
+        return type_size(desc[i].type);
+    for (size_t child = i + 1; child < N && desc[child].type != KOW_BRANCH_END; child = next_sibling(desc, child))
+    {
+        int child_size = element_size(desc, child) * desc[child].count;
+        if (desc[i].type == KOW_BRANCH_START)
+            size += child_size;
+        else if (child_size > size)
+            size = child_size;
+    }
+    return size;
+}
+
+template <size_t Depth>
+struct location
+{
+    bool found;
+    size_t node;            ///< descriptor index of the addressed node
+    int offset;             ///< offset of the addressed node with all array indices at 0
+    int strides[Depth];     ///< array item size at each path level
+};
+
+// resolve a path of child symbols (below the root branch) to a node location
+template <size_t N, size_t Depth>
+constexpr location<Depth> locate(const kowhai_node_t (&desc)[N], const uint16_t (&path)[Depth])
+{
+    location<Depth> loc = {false, 0, 0, {}};
+    size_t parent = 0;
+    for (size_t level = 0; level < Depth; level++)
+    {
+        size_t child = parent + 1;
+        int offset = 0;
+        if (!is_branch(desc[parent].type))
+            return loc;
+        while (child < N && desc[child].type != KOW_BRANCH_END && desc[child].symbol != path[level])
+        {
+            if (desc[parent].type == KOW_BRANCH_START)
+                offset += element_size(desc, child) * desc[child].count;
+            child = next_sibling(desc, child);
+        }
+        if (child >= N || desc[child].type == KOW_BRANCH_END)
+            return loc;
+        loc.offset += offset;
+        loc.strides[level] = element_size(desc, child);
+        parent = child;
+    }
+    loc.found = true;
+    loc.node = parent;
+    return loc;
+}
+
+template <uint16_t Type> struct leaf_type;
+template <> struct leaf_type<KOW_INT8> { typedef int8_t type; };
+template <> struct leaf_type<KOW_UINT8> { typedef uint8_t type; };
+template <> struct leaf_type<KOW_INT16> { typedef int16_t type; };
+template <> struct leaf_type<KOW_UINT16> { typedef uint16_t type; };
+template <> struct leaf_type<KOW_INT32> { typedef int32_t type; };
+template <> struct leaf_type<KOW_UINT32> { typedef uint32_t type; };
+template <> struct leaf_type<KOW_FLOAT> { typedef float type; };
+template <> struct leaf_type<KOW_CHAR> { typedef char type; };
+
+} // namespace detail
+
+/**
+ * @brief typed access to a tree data buffer described by the constexpr descriptor Desc
+ * Paths are lists of child symbols below the root branch, eg get<SYM_FLUXCAPACITOR, SYM_GAIN>(1) reads
+ * the gain of flux capacitor 1. Array indices are given positionally for each path symbol, missing
+ * trailing indices are 0. Indices are not range checked.
+ * @note get and set copy the data directly, they do not take a sequence lock or mark a change tracker or
+ * snapshot registered for the data. Use read and write (which go through kowhai_read/kowhai_write) for data
+ * that is shared with those.
+ */
+template <const auto& Desc>
+class view
+{
+    static_assert(Desc[0].type == KOW_BRANCH_START, "descriptor root must be a branch");
+
+    template <uint16_t... Path>
+    struct node
+    {
+        static_assert(sizeof...(Path) > 0, "path must address a child of the root branch");
+        static constexpr uint16_t path[] = {Path...};
+        static constexpr detail::location<sizeof...(Path)> loc = detail::locate(Desc, path);
+        static_assert(loc.found, "symbol path not found in the descriptor");
+        static constexpr const kowhai_node_t& desc = Desc[loc.node];
+    };
+
+    template <uint16_t... Path, typename... Indices>
+    static int index_offset(Indices... indices)
+    {
+        static_assert(sizeof...(Indices) <= sizeof...(Path), "too many array indices for the path");
+        const int index[] = {static_cast<int>(indices)..., 0};
+        int offset = node<Path...>::loc.offset;
+        for (size_t i = 0; i < sizeof...(Indices); i++)
+            offset += index[i] * node<Path...>::loc.strides[i];
+        return offset;
+    }
+
+    template <uint16_t... Path, typename... Indices>
+    static void symbol_path(union kowhai_symbol_t (&symbols)[sizeof...(Path) + 1], Indices... indices)
+    {
+        static_assert(sizeof...(Indices) <= sizeof...(Path), "too many array indices for the path");
+        const int index[] = {static_cast<int>(indices)..., 0};
+        const uint16_t path[] = {Path...};
+        symbols[0].symbol = KOWHAI_SYMBOL(Desc[0].symbol, 0);
+        for (size_t i = 0; i < sizeof...(Path); i++)
+            symbols[i + 1].symbol = KOWHAI_SYMBOL(path[i], i < sizeof...(Indices) ? index[i] : 0);
+    }
+
+public:
+    /// size of the whole tree data buffer
+    static constexpr int size = detail::element_size(Desc, 0) * Desc[0].count;
+
+    /// offset of a node from the start of the tree data (with all array indices at 0)
+    template <uint16_t... Path>
+    static constexpr int offset_of = node<Path...>::loc.offset;
+
+    /// size of all the array items of a node
+    template <uint16_t... Path>
+    static constexpr int size_of = detail::element_size(Desc, node<Path...>::loc.node) * node<Path...>::desc.count;
+
+    /// number of array items of a node
+    template <uint16_t... Path>
+    static constexpr int count_of = node<Path...>::desc.count;
+
+    /// c type of a leaf node
+    template <uint16_t... Path>
+    using type_of = typename detail::leaf_type<node<Path...>::desc.type>::type;
+
+    explicit view(void* data) : data_(static_cast<char*>(data)) {}
+
+    /// view the data of a tree that uses the same descriptor
+    explicit view(const struct kowhai_tree_t& tree) : data_(static_cast<char*>(tree.data))
+    {
+        assert(tree.desc == Desc);
+        assert(kowhai_descriptor_layout(tree.desc) == KOW_LAYOUT_PACKED);
+    }
+
+    template <uint16_t... Path, typename... Indices>
+    type_of<Path...> get(Indices... indices) const
+    {
+        type_of<Path...> value;
+        memcpy(&value, data_ + index_offset<Path...>(indices...), sizeof(value));
+        return value;
+    }
+
+    template <uint16_t... Path, typename... Indices>
+    void set(type_of<Path...> value, Indices... indices)
+    {
+        memcpy(data_ + index_offset<Path...>(indices...), &value, sizeof(value));
+    }
+
+    /// get through kowhai_read, returns a kowhai status
+    template <uint16_t... Path, typename... Indices>
+    int read(type_of<Path...>& value, Indices... indices) const
+    {
+        union kowhai_symbol_t symbols[sizeof...(Path) + 1];
+        struct kowhai_tree_t t = tree();
+        symbol_path<Path...>(symbols, indices...);
+        return kowhai_read(&t, sizeof...(Path) + 1, symbols, 0, &value, sizeof(value));
+    }
+
+    /// set through kowhai_write (taking a registered sequence lock and marking change trackers and snapshots), returns a kowhai status
+    template <uint16_t... Path, typename... Indices>
+    int write(type_of<Path...> value, Indices... indices)
+    {
+        union kowhai_symbol_t symbols[sizeof...(Path) + 1];
+        struct kowhai_tree_t t = tree();
+        symbol_path<Path...>(symbols, indices...);
+        return kowhai_write(&t, sizeof...(Path) + 1, symbols, 0, &value, sizeof(value));
+    }
+
+    void* data() const
+    {
+        return data_;
+    }
+
+    /// the descriptor and data as a c tree (ie to use with the c api or the protocol server)
+    struct kowhai_tree_t tree() const
+    {
+        struct kowhai_tree_t tree = {const_cast<struct kowhai_node_t*>(Desc), data_};
+        return tree;
+    }
+
+private:
+    char* data_;
+};
+
+} // namespace kowhai
+
+#endif
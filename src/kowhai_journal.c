@@ -0,0 +1,420 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "kowhai_journal.h"
+#include "kowhai_serialize.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define TEMP_SUFFIX ".tmp"
+
+//
+// platform file helpers
+//
+
+// flush a file and wait for it to reach the disk
+static int sync_file(FILE *file)
+{
+    if (fflush(file) != 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+#ifdef WIN32
+    if (_commit(_fileno(file)) != 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+#else
+    if (fsync(fileno(file)) != 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+#endif
+    return KOW_STATUS_OK;
+}
+
+// cut a file back to size bytes and wait for it to reach the disk
+static int truncate_file(const char *filename, long size)
+{
+    int status = KOW_STATUS_OK;
+    FILE *file = fopen(filename, "r+b");
+    if (file == NULL)
+        return KOW_STATUS_NOT_FOUND;
+#ifdef WIN32
+    if (_chsize(_fileno(file), size) != 0)
+        status = KOW_STATUS_UNKNOWN_ERROR;
+#else
+    if (ftruncate(fileno(file), size) != 0)
+        status = KOW_STATUS_UNKNOWN_ERROR;
+#endif
+    if (status == KOW_STATUS_OK)
+        status = sync_file(file);
+    fclose(file);
+    return status;
+}
+
+// atomically replace a file with another
+static int replace_file(const char *from, const char *to)
+{
+#ifdef WIN32
+    if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        return KOW_STATUS_UNKNOWN_ERROR;
+#else
+    char directory[KOW_JOURNAL_MAX_FILENAME];
+    const char *separator = strrchr(to, '/');
+    int fd, status = KOW_STATUS_OK;
+    if (rename(from, to) != 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    // the rename is only durable once the directory holding the file is synced
+    if (separator == NULL)
+        strcpy(directory, ".");
+    else if (separator == to)
+        strcpy(directory, "/");
+    else if ((size_t)(separator - to) < sizeof(directory))
+    {
+        memcpy(directory, to, separator - to);
+        directory[separator - to] = 0;
+    }
+    else
+        return KOW_STATUS_BUFFER_INVALID;
+    fd = open(directory, O_RDONLY);
+    if (fd < 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    if (fsync(fd) != 0)
+        status = KOW_STATUS_UNKNOWN_ERROR;
+    close(fd);
+    return status;
+#endif
+    return KOW_STATUS_OK;
+}
+
+//
+// records
+//
+
+static struct kowhai_journal_tree_t* find_tree(struct kowhai_journal_t *journal, uint16_t tree_id)
+{
+    int i;
+    for (i = 0; i < journal->tree_count; i++)
+    {
+        if (journal->trees[i].id == tree_id)
+            return &journal->trees[i];
+    }
+    return NULL;
+}
+
+static uint32_t record_crc(const struct kowhai_journal_record_t *record, const void *bytes)
+{
+    uint32_t crc = kowhai_crc32(0, &record->tree_id, sizeof(struct kowhai_journal_record_t) - sizeof(record->crc));
+    return kowhai_crc32(crc, bytes, record->size);
+}
+
+static int write_header(FILE *file, uint32_t magic, uint32_t generation)
+{
+    struct kowhai_journal_header_t header;
+    header.magic = magic;
+    header.version = KOW_JOURNAL_VERSION;
+    header.reserved = 0;
+    header.generation = generation;
+    if (fwrite(&header, sizeof(header), 1, file) != 1)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    return KOW_STATUS_OK;
+}
+
+static int read_header(FILE *file, uint32_t magic, uint32_t *generation)
+{
+    struct kowhai_journal_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != magic || header.version != KOW_JOURNAL_VERSION)
+        return KOW_STATUS_BUFFER_INVALID;
+    *generation = header.generation;
+    return KOW_STATUS_OK;
+}
+
+// read the next record and its bytes (in to the journal buffer), KOW_STATUS_NO_DATA at the end of the file or
+// KOW_STATUS_BUFFER_INVALID if the record is torn or damaged
+static int read_record(struct kowhai_journal_t *journal, FILE *file, struct kowhai_journal_record_t *record)
+{
+    size_t size = fread(record, 1, sizeof(struct kowhai_journal_record_t), file);
+    if (size == 0)
+        return KOW_STATUS_NO_DATA;
+    if (size != sizeof(struct kowhai_journal_record_t) || record->size > (uint32_t)journal->buffer_size)
+        return KOW_STATUS_BUFFER_INVALID;
+    if (fread(journal->buffer, 1, record->size, file) != record->size || record_crc(record, journal->buffer) != record->crc)
+        return KOW_STATUS_BUFFER_INVALID;
+    return KOW_STATUS_OK;
+}
+
+// load the trees from the snapshot file (if there is one)
+static int load_snapshot(struct kowhai_journal_t *journal)
+{
+    struct kowhai_journal_record_t record;
+    struct kowhai_journal_tree_t *tree;
+    int status;
+    FILE *file = fopen(journal->snapshot_filename, "rb");
+    if (file == NULL)
+        return KOW_STATUS_OK;
+
+    status = read_header(file, KOW_JOURNAL_SNAPSHOT_MAGIC, &journal->generation);
+    while (status == KOW_STATUS_OK)
+    {
+        status = read_record(journal, file, &record);
+        if (status != KOW_STATUS_OK)
+            break;
+        // trees that are no longer journaled are dropped at the next checkpoint
+        tree = find_tree(journal, record.tree_id);
+        if (tree != NULL)
+            status = kowhai_binary_load(journal->buffer, record.size, &tree->tree);
+    }
+    fclose(file);
+    if (status == KOW_STATUS_NO_DATA)
+        return KOW_STATUS_OK;
+    return status;
+}
+
+// apply the journal records of the current generation, clean is cleared if the journal needs rewriting
+static void replay_journal(struct kowhai_journal_t *journal, int *clean)
+{
+    struct kowhai_journal_record_t record;
+    struct kowhai_journal_tree_t *tree;
+    union kowhai_symbol_t root;
+    uint32_t generation;
+    int status, data_size;
+    FILE *file = fopen(journal->filename, "rb");
+
+    *clean = 0;
+    if (file == NULL)
+        return;
+    status = read_header(file, KOW_JOURNAL_MAGIC, &generation);
+    if (status == KOW_STATUS_OK && generation == journal->generation)
+    {
+        for (;;)
+        {
+            status = read_record(journal, file, &record);
+            if (status != KOW_STATUS_OK)
+                break;
+            tree = find_tree(journal, record.tree_id);
+            if (tree == NULL || kowhai_get_node_size(tree->tree.desc, &data_size) != KOW_STATUS_OK ||
+                (uint64_t)record.offset + record.size > (uint64_t)data_size)
+                continue;
+            // write through the library so locks, snapshots and dirty tracking see the replay
+            root.symbol = KOWHAI_SYMBOL(tree->tree.desc->symbol, 0);
+            kowhai_write(&tree->tree, 1, &root, record.offset, journal->buffer, record.size);
+        }
+        // a torn record is left by a crash during an append, the records before it are still good
+        *clean = (status == KOW_STATUS_NO_DATA);
+        journal->size = ftell(file);
+    }
+    fclose(file);
+}
+
+//
+// journal
+//
+
+int kowhai_journal_open(struct kowhai_journal_t *journal, const char *filename, const char *snapshot_filename,
+    struct kowhai_journal_tree_t *trees, int tree_count, void *buffer, int buffer_size, long checkpoint_size)
+{
+    int i, status, data_size, clean;
+
+    memset(journal, 0, sizeof(struct kowhai_journal_t));
+    journal->filename = filename;
+    journal->snapshot_filename = snapshot_filename;
+    journal->trees = trees;
+    journal->tree_count = tree_count;
+    journal->buffer = (char*)buffer;
+    journal->buffer_size = buffer_size;
+    journal->checkpoint_size = checkpoint_size;
+
+    if (strlen(snapshot_filename) + sizeof(TEMP_SUFFIX) > KOW_JOURNAL_MAX_FILENAME)
+        return KOW_STATUS_BUFFER_INVALID;
+    // the buffer must fit a whole tree to replay and checkpoint it
+    for (i = 0; i < tree_count; i++)
+    {
+        status = kowhai_get_node_size(trees[i].tree.desc, &data_size);
+        if (status != KOW_STATUS_OK)
+            return status;
+        if (data_size + sizeof(struct kowhai_journal_record_t) + sizeof(struct kowhai_binary_header_t) > (size_t)buffer_size)
+            return KOW_STATUS_SCRATCH_TOO_SMALL;
+    }
+
+    status = load_snapshot(journal);
+    if (status != KOW_STATUS_OK)
+        return status;
+    replay_journal(journal, &clean);
+    if (!clean)
+        return kowhai_journal_checkpoint(journal);
+
+    journal->file = fopen(filename, "ab");
+    if (journal->file == NULL)
+        return KOW_STATUS_NOT_FOUND;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_append(struct kowhai_journal_t *journal, uint16_t tree_id, int offset, int size)
+{
+    struct kowhai_journal_record_t record;
+    struct kowhai_journal_tree_t *tree;
+    union kowhai_symbol_t root;
+    char *bytes;
+    int status;
+
+    if (journal->file == NULL)
+        return KOW_STATUS_NO_DATA;
+    tree = find_tree(journal, tree_id);
+    if (tree == NULL)
+        return KOW_STATUS_NOT_FOUND;
+    if (offset < 0 || size < 0)
+        return KOW_STATUS_INVALID_OFFSET;
+
+    // commit the buffered records if there is no room for this one
+    if (journal->buffer_used + sizeof(record) + size > (size_t)journal->buffer_size)
+    {
+        status = kowhai_journal_commit(journal);
+        if (status != KOW_STATUS_OK)
+            return status;
+        if (sizeof(record) + size > (size_t)journal->buffer_size)
+            return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    }
+
+    // copy the bytes through the library so a concurrent write is not torn
+    bytes = journal->buffer + journal->buffer_used + sizeof(record);
+    root.symbol = KOWHAI_SYMBOL(tree->tree.desc->symbol, 0);
+    status = kowhai_read(&tree->tree, 1, &root, offset, bytes, size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    record.tree_id = tree_id;
+    record.reserved = 0;
+    record.offset = offset;
+    record.size = size;
+    record.crc = record_crc(&record, bytes);
+    memcpy(journal->buffer + journal->buffer_used, &record, sizeof(record));
+    journal->buffer_used += sizeof(record) + size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_commit(struct kowhai_journal_t *journal)
+{
+    int status;
+
+    if (journal->file == NULL)
+        return KOW_STATUS_NO_DATA;
+    if (journal->buffer_used == 0)
+        return KOW_STATUS_OK;
+
+    // one append and one sync for all the records written since the last commit
+    status = KOW_STATUS_OK;
+    if (fwrite(journal->buffer, journal->buffer_used, 1, (FILE*)journal->file) != 1)
+        status = KOW_STATUS_UNKNOWN_ERROR;
+    if (status == KOW_STATUS_OK)
+        status = sync_file((FILE*)journal->file);
+    if (status != KOW_STATUS_OK)
+    {
+        // cut off any part of the records that reached the file so later commits are not appended after a torn
+        // record (the replay would stop there), the records stay buffered for the next commit or checkpoint and
+        // nothing more is appended until the journal is usable again
+        fclose((FILE*)journal->file);
+        journal->file = NULL;
+        if (truncate_file(journal->filename, journal->size) == KOW_STATUS_OK)
+            journal->file = fopen(journal->filename, "ab");
+        return status;
+    }
+    journal->size += journal->buffer_used;
+    journal->buffer_used = 0;
+
+    if (journal->checkpoint_size > 0 && journal->size >= journal->checkpoint_size)
+        return kowhai_journal_checkpoint(journal);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_checkpoint(struct kowhai_journal_t *journal)
+{
+    struct kowhai_journal_record_t record;
+    char temp_filename[KOW_JOURNAL_MAX_FILENAME];
+    FILE *file;
+    int i, size, status;
+
+    // the buffered records are covered by the snapshot
+    journal->buffer_used = 0;
+    if (journal->file != NULL)
+    {
+        fclose((FILE*)journal->file);
+        journal->file = NULL;
+    }
+
+    // write the snapshot of the next generation to a temporary file
+    strcpy(temp_filename, journal->snapshot_filename);
+    strcat(temp_filename, TEMP_SUFFIX);
+    file = fopen(temp_filename, "wb");
+    if (file == NULL)
+        return KOW_STATUS_NOT_FOUND;
+    status = write_header(file, KOW_JOURNAL_SNAPSHOT_MAGIC, journal->generation + 1);
+    for (i = 0; i < journal->tree_count && status == KOW_STATUS_OK; i++)
+    {
+        size = journal->buffer_size - sizeof(record);
+        status = kowhai_binary_save(&journal->trees[i].tree, 0, journal->buffer + sizeof(record), &size);
+        if (status != KOW_STATUS_OK)
+            break;
+        record.tree_id = journal->trees[i].id;
+        record.reserved = 0;
+        record.offset = 0;
+        record.size = size;
+        record.crc = record_crc(&record, journal->buffer + sizeof(record));
+        memcpy(journal->buffer, &record, sizeof(record));
+        if (fwrite(journal->buffer, sizeof(record) + size, 1, file) != 1)
+            status = KOW_STATUS_UNKNOWN_ERROR;
+    }
+    if (status == KOW_STATUS_OK)
+        status = sync_file(file);
+    fclose(file);
+    if (status == KOW_STATUS_OK)
+        status = replace_file(temp_filename, journal->snapshot_filename);
+    if (status != KOW_STATUS_OK)
+    {
+        remove(temp_filename);
+        return status;
+    }
+    journal->generation++;
+
+    // start an empty journal of the new generation (the old one no longer applies)
+    file = fopen(journal->filename, "wb");
+    if (file == NULL)
+        return KOW_STATUS_NOT_FOUND;
+    status = write_header(file, KOW_JOURNAL_MAGIC, journal->generation);
+    if (status == KOW_STATUS_OK)
+        status = sync_file(file);
+    if (status != KOW_STATUS_OK)
+    {
+        fclose(file);
+        return status;
+    }
+    journal->file = file;
+    journal->size = sizeof(struct kowhai_journal_header_t);
+    return KOW_STATUS_OK;
+}
+
+int kowhai_journal_close(struct kowhai_journal_t *journal)
+{
+    int status;
+    if (journal->file == NULL)
+        return KOW_STATUS_NO_DATA;
+    status = kowhai_journal_commit(journal);
+    if (journal->file != NULL)
+        fclose((FILE*)journal->file);
+    journal->file = NULL;
+    return status;
+}
+
+void kowhai_journal_node_post_write(pkowhai_protocol_server_t server, void* param, uint16_t tree_id, struct kowhai_node_t* node, int offset, int bytes_written)
+{
+    struct kowhai_journal_t *journal = (struct kowhai_journal_t*)param;
+    int status = kowhai_journal_append(journal, tree_id, offset, bytes_written);
+    (void)server;
+    (void)node;
+    // the write has already been acknowledged so keep the first failure for the application to find
+    if (status != KOW_STATUS_OK && journal->error == KOW_STATUS_OK)
+        journal->error = status;
+}
@@ -0,0 +1,141 @@
+#ifndef _KOWHAI_JOURNAL_H_
+#define _KOWHAI_JOURNAL_H_
+
+#include "kowhai.h"
+#include "kowhai_protocol_server.h"
+
+#include <stddef.h>
+
+#define KOW_JOURNAL_MAGIC           0x4B4F574A  ///< "KOWJ", start of a journal file
+#define KOW_JOURNAL_SNAPSHOT_MAGIC  0x4B4F5753  ///< "KOWS", start of a journal snapshot file
+#define KOW_JOURNAL_VERSION         1           ///< version of the journal and snapshot file formats
+
+#define KOW_JOURNAL_MAX_FILENAME    260         ///< longest snapshot filename (the checkpoint writes it to a temporary file first)
+
+#pragma pack(1)
+
+/**
+ * @brief header at the start of journal and snapshot files
+ */
+struct kowhai_journal_header_t
+{
+    uint32_t magic;             ///< KOW_JOURNAL_MAGIC or KOW_JOURNAL_SNAPSHOT_MAGIC
+    uint16_t version;           ///< KOW_JOURNAL_VERSION
+    uint16_t reserved;
+    uint32_t generation;        ///< incremented by each checkpoint, a journal only applies to the snapshot of its generation
+};
+
+/**
+ * @brief a journal record, it is followed by size bytes of tree data (or in a snapshot file a binary container of the
+ * whole tree, see kowhai_binary_save)
+ */
+struct kowhai_journal_record_t
+{
+    uint32_t crc;               ///< kowhai_crc32 of the rest of the record and its bytes (detects a torn append)
+    uint16_t tree_id;           ///< the tree that was written
+    uint16_t reserved;
+    uint32_t offset;            ///< offset of the bytes in the tree data
+    uint32_t size;              ///< number of bytes following the record
+};
+
+#pragma pack()
+
+/**
+ * @brief a tree whose writes are journaled
+ */
+struct kowhai_journal_tree_t
+{
+    uint16_t id;                    ///< the tree id (as used by the protocol server)
+    struct kowhai_tree_t tree;      ///< the tree data to journal
+};
+
+/**
+ * @brief an append only journal of tree writes, see kowhai_journal_open
+ */
+struct kowhai_journal_t
+{
+    const char *filename;                   ///< the journal file
+    const char *snapshot_filename;          ///< the snapshot file written by each checkpoint
+    struct kowhai_journal_tree_t *trees;    ///< the journaled trees
+    int tree_count;                         ///< number of trees
+    char *buffer;                           ///< records waiting for the next commit
+    int buffer_size;                        ///< size of buffer
+    int buffer_used;                        ///< bytes of records in buffer
+    long checkpoint_size;                   ///< checkpoint once the journal grows to this many bytes (0 to only checkpoint explicitly)
+    long size;                              ///< bytes committed to the journal file
+    uint32_t generation;                    ///< generation of the journal and snapshot files
+    void *file;                             ///< journal file handle (internal use)
+    int error;                              ///< first append failure of kowhai_journal_node_post_write (KOW_STATUS_OK if none), cleared by the application
+};
+
+/**
+ * @brief open a journal, replaying the snapshot and journal files into the trees
+ * The trees are loaded from the snapshot file (each tree must match the descriptor hash and layout it was saved with)
+ * and then the committed journal records are applied in order. A record torn by a crash during an append ends the
+ * replay. If there is no snapshot the trees keep their current data. If the journal was missing, stale or torn a
+ * checkpoint is written, so the files always describe the trees once this returns.
+ * @param journal, the journal to open
+ * @param filename, the journal file
+ * @param snapshot_filename, the snapshot file
+ * @param trees, the trees to journal
+ * @param tree_count, number of trees
+ * @param buffer, holds records between commits, it must fit the largest tree plus a kowhai_journal_record_t and a
+ * kowhai_binary_header_t as it is also used to replay and checkpoint
+ * @param buffer_size, size of buffer
+ * @param checkpoint_size, checkpoint once the journal grows to this many bytes (0 to only checkpoint explicitly)
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_INVALID_DESCRIPTOR if a tree does not match the
+ * snapshot, KOW_STATUS_BUFFER_INVALID if the snapshot file is damaged, KOW_STATUS_SCRATCH_TOO_SMALL if buffer is too
+ * small or other on error
+ */
+int kowhai_journal_open(struct kowhai_journal_t *journal, const char *filename, const char *snapshot_filename,
+    struct kowhai_journal_tree_t *trees, int tree_count, void *buffer, int buffer_size, long checkpoint_size);
+
+/**
+ * @brief append a write of tree data to the journal
+ * The bytes are copied from the tree now but are only durable after the next kowhai_journal_commit, so many writes can
+ * share one file sync (group commit).
+ * @param journal, an open journal
+ * @param tree_id, the tree that was written
+ * @param offset, offset of the written bytes in the tree data
+ * @param size, number of bytes written
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_append(struct kowhai_journal_t *journal, uint16_t tree_id, int offset, int size);
+
+/**
+ * @brief append the buffered records to the journal file and sync it to disk (checkpointing if the journal has grown
+ * to checkpoint_size)
+ * If the append or sync fails the journal file is cut back to its committed records and the records stay buffered for
+ * the next commit. If the file can not be cut back it is closed, appends then fail with KOW_STATUS_NO_DATA until
+ * kowhai_journal_checkpoint succeeds (the checkpoint covers the buffered records).
+ * @param journal, an open journal
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_commit(struct kowhai_journal_t *journal);
+
+/**
+ * @brief write all the trees to a new snapshot file and start an empty journal
+ * The snapshot is written to a temporary file and renamed over the old one (and the directory synced), so a crash
+ * leaves either the old snapshot and journal or the new snapshot (the old journal is then ignored as it is of the wrong
+ * generation).
+ * @param journal, an open journal
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_checkpoint(struct kowhai_journal_t *journal);
+
+/**
+ * @brief commit any buffered records and close the journal
+ * @param journal, an open journal
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_journal_close(struct kowhai_journal_t *journal);
+
+/**
+ * @brief kowhai_node_post_write_t callback that appends protocol writes to a journal
+ * Pass the journal as the node_write_param of kowhai_server_init (or call this from the application callback) and
+ * call kowhai_journal_commit once the received packets have been processed. The callback can not fail the write so
+ * the first append that fails is kept in journal->error, check (and clear) it after processing the packets.
+ */
+void kowhai_journal_node_post_write(pkowhai_protocol_server_t server, void* param, uint16_t tree_id, struct kowhai_node_t* node, int offset, int bytes_written);
+
+#endif
@@ -0,0 +1,206 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "kowhai_mapped.h"
+
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//
+// platform file mapping
+//
+
+// open a file, creating it (empty) if create is set, and get its size
+static int open_file(struct kowhai_mapped_t *mapped, const char *filename, int create, size_t *file_size)
+{
+#ifdef WIN32
+    LARGE_INTEGER size;
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return KOW_STATUS_NOT_FOUND;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return KOW_STATUS_UNKNOWN_ERROR;
+    }
+    mapped->file = file;
+    *file_size = (size_t)size.QuadPart;
+#else
+    struct stat st;
+    int fd = open(filename, create ? O_RDWR | O_CREAT : O_RDWR, 0644);
+    if (fd < 0)
+        return KOW_STATUS_NOT_FOUND;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return KOW_STATUS_UNKNOWN_ERROR;
+    }
+    mapped->fd = fd;
+    *file_size = (size_t)st.st_size;
+#endif
+    return KOW_STATUS_OK;
+}
+
+// map the first size bytes of an open file (growing the file if it is smaller)
+static int map_file(struct kowhai_mapped_t *mapped, size_t size, size_t file_size)
+{
+#ifdef WIN32
+    // the mapping grows the file if required
+    (void)file_size;
+    mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL);
+    if (mapped->mapping == NULL)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    mapped->base = MapViewOfFile(mapped->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (mapped->base == NULL)
+        return KOW_STATUS_UNKNOWN_ERROR;
+#else
+    void *base;
+    if (size > file_size && ftruncate(mapped->fd, (off_t)size) != 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mapped->fd, 0);
+    if (base == MAP_FAILED)
+        return KOW_STATUS_UNKNOWN_ERROR;
+    mapped->base = base;
+#endif
+    mapped->size = size;
+    return KOW_STATUS_OK;
+}
+
+static int sync_file(struct kowhai_mapped_t *mapped)
+{
+#ifdef WIN32
+    if (!FlushViewOfFile(mapped->base, mapped->size) || !FlushFileBuffers(mapped->file))
+        return KOW_STATUS_UNKNOWN_ERROR;
+#else
+    if (msync(mapped->base, mapped->size, MS_SYNC) != 0)
+        return KOW_STATUS_UNKNOWN_ERROR;
+#endif
+    return KOW_STATUS_OK;
+}
+
+static void close_file(struct kowhai_mapped_t *mapped)
+{
+#ifdef WIN32
+    if (mapped->base != NULL)
+        UnmapViewOfFile(mapped->base);
+    if (mapped->mapping != NULL)
+        CloseHandle(mapped->mapping);
+    if (mapped->file != NULL)
+        CloseHandle(mapped->file);
+#else
+    if (mapped->base != NULL)
+        munmap(mapped->base, mapped->size);
+    if (mapped->fd >= 0)
+        close(mapped->fd);
+#endif
+    mapped->base = NULL;
+    mapped->size = 0;
+    mapped->fd = -1;
+    mapped->file = NULL;
+    mapped->mapping = NULL;
+}
+
+//
+// mapped trees
+//
+
+// check the header of an existing file (and find the descriptor if one is not given)
+static int check_header(struct kowhai_mapped_t *mapped, const struct kowhai_node_t **desc)
+{
+    if (mapped->size > 0x7FFFFFFF)
+        return KOW_STATUS_BUFFER_INVALID;
+    return kowhai_binary_check(mapped->base, (int)mapped->size, desc);
+}
+
+// bring the checksum of a file saved with one up to date with the writes to the mapping
+static void update_checksum(struct kowhai_mapped_t *mapped)
+{
+    struct kowhai_binary_header_t *header = (struct kowhai_binary_header_t*)mapped->base;
+    uint32_t checksum;
+    if (!(header->flags & KOW_BINARY_CHECKSUM))
+        return;
+    checksum = kowhai_crc32(0, header + 1, header->data_offset + header->data_size - sizeof(struct kowhai_binary_header_t));
+    if (checksum != header->checksum)
+        header->checksum = checksum;
+}
+
+// map a new file and write its header (and descriptor)
+static int create_file(struct kowhai_mapped_t *mapped, const struct kowhai_node_t *desc, int flags)
+{
+    struct kowhai_binary_header_t header;
+    int status = kowhai_binary_header(desc, flags & KOW_MAPPED_STORE_DESCRIPTOR, &header);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    // the file is extended with zeros so the tree data starts zeroed
+    status = map_file(mapped, header.data_offset + header.data_size, 0);
+    if (status != KOW_STATUS_OK)
+        return status;
+    memcpy(mapped->base, &header, sizeof(header));
+    memcpy((char*)mapped->base + sizeof(header), desc, header.descriptor_size);
+    mapped->created = 1;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_tree_open_mapped(struct kowhai_mapped_t *mapped, const char *filename, const struct kowhai_node_t *desc, int flags)
+{
+    size_t file_size;
+    int status;
+
+    memset(mapped, 0, sizeof(struct kowhai_mapped_t));
+    mapped->fd = -1;
+
+    // only create the file if there is a descriptor to create it with
+    status = open_file(mapped, filename, desc != NULL, &file_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    if (file_size == 0)
+    {
+        if (desc == NULL)
+            status = KOW_STATUS_BUFFER_INVALID;
+        else
+            status = create_file(mapped, desc, flags);
+    }
+    else
+    {
+        status = map_file(mapped, file_size, file_size);
+        if (status == KOW_STATUS_OK)
+            status = check_header(mapped, &desc);
+    }
+    if (status != KOW_STATUS_OK)
+    {
+        close_file(mapped);
+        return status;
+    }
+
+    mapped->tree.desc = (struct kowhai_node_t*)desc;
+    mapped->tree.data = (char*)mapped->base + ((struct kowhai_binary_header_t*)mapped->base)->data_offset;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_tree_sync_mapped(struct kowhai_mapped_t *mapped)
+{
+    if (mapped->base == NULL)
+        return KOW_STATUS_NO_DATA;
+    update_checksum(mapped);
+    return sync_file(mapped);
+}
+
+void kowhai_tree_close_mapped(struct kowhai_mapped_t *mapped)
+{
+    if (mapped->base != NULL)
+        update_checksum(mapped);
+    close_file(mapped);
+    mapped->tree.desc = NULL;
+    mapped->tree.data = NULL;
+}
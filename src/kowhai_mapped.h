@@ -0,0 +1,58 @@
+#ifndef _KOWHAI_MAPPED_H_
+#define _KOWHAI_MAPPED_H_
+
+#include "kowhai.h"
+#include "kowhai_serialize.h"
+
+#include <stddef.h>
+
+// kowhai_tree_open_mapped flags
+#define KOW_MAPPED_STORE_DESCRIPTOR KOW_BINARY_STORE_DESCRIPTOR ///< store the descriptor in a new file so it can be opened without one
+
+/**
+ * @brief a tree whose data lives in a memory mapped file, see kowhai_tree_open_mapped
+ */
+struct kowhai_mapped_t
+{
+    struct kowhai_tree_t tree;      ///< the descriptor and the mapped tree data
+    int created;                    ///< set if the file was created by kowhai_tree_open_mapped (the tree data is zeroed)
+    void *base;                     ///< start of the mapping (a kowhai_binary_header_t)
+    size_t size;                    ///< bytes mapped
+    int fd;                         ///< file descriptor (internal use)
+    void *file;                     ///< file handle (internal use)
+    void *mapping;                  ///< file mapping handle (internal use)
+};
+
+/**
+ * @brief bind the data of a tree to a memory mapped file so it persists without serializing
+ * A new file is created (holding zeroed tree data) if it does not exist. An existing file is used as is, so the tree
+ * data is available as soon as this returns, provided its header matches the descriptor hash and the current layout
+ * of the descriptor (see kowhai_descriptor_compile_layout). Writes to the tree data go straight to the file mapping,
+ * use kowhai_tree_sync_mapped to flush them to disk. Files use the binary container format (see kowhai_binary_save)
+ * so a saved container can be opened here. Opening does not write to the file, the checksum of a container saved with
+ * one is checked here and brought up to date by kowhai_tree_sync_mapped and kowhai_tree_close_mapped (so a file left
+ * unsynced after writes fails the check when opened again).
+ * @note files are not portable between machines of different byte orders
+ * @param mapped, set to the mapped tree
+ * @param filename, the file to map
+ * @param desc, the descriptor of the tree data, or NULL to use the descriptor stored in an existing file
+ * @param flags, KOW_MAPPED_xxx flags
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_INVALID_DESCRIPTOR if the file does not match
+ * desc, KOW_STATUS_BUFFER_INVALID if the file is not a mapped tree or other on error
+ */
+int kowhai_tree_open_mapped(struct kowhai_mapped_t *mapped, const char *filename, const struct kowhai_node_t *desc, int flags);
+
+/**
+ * @brief flush the tree data of a mapped tree to disk
+ * @param mapped, a tree opened with kowhai_tree_open_mapped
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_tree_sync_mapped(struct kowhai_mapped_t *mapped);
+
+/**
+ * @brief unmap a mapped tree, the tree data (and stored descriptor) can no longer be used
+ * @param mapped, a tree opened with kowhai_tree_open_mapped
+ */
+void kowhai_tree_close_mapped(struct kowhai_mapped_t *mapped);
+
+#endif
@@ -4,6 +4,57 @@
 
 #define SYM_COUNT_SIZE 1
 
+// bytes of the header on the wire (the request tag is the last member of the header)
+#define HEADER_SIZE(version) ((version) >= KOW_PROTOCOL_VERSION_3 ? sizeof(struct kowhai_protocol_header_t) : sizeof(struct kowhai_protocol_header_t) - sizeof(uint16_t))
+// bytes of a payload offset or size on the wire
+#define FIELD_SIZE(version) ((version) >= KOW_PROTOCOL_VERSION_2 ? sizeof(uint32_t) : sizeof(uint16_t))
+// bytes of the wire payload specs with offset and size fields of field_size bytes
+#define DATA_MEMORY_SPEC_SIZE(field_size) (sizeof(uint16_t) + 2 * (field_size))
+#define DESCRIPTOR_SPEC_SIZE(field_size) (sizeof(uint16_t) + 2 * (field_size))
+#define OFFSET_SIZE_SPEC_SIZE(field_size) (2 * (field_size))
+#define READ_MULTI_SPEC_SIZE(field_size) (sizeof(uint16_t) + 2 * (field_size))
+#define WRITE_MULTI_SPEC_SIZE(field_size) (sizeof(uint16_t) + (field_size))
+#define HANDLE_SPEC_SIZE(field_size) (sizeof(uint16_t) + DATA_MEMORY_SPEC_SIZE(field_size))
+#define SUBSCRIBE_SPEC_SIZE (sizeof(uint16_t) + 2 * sizeof(uint32_t))
+// bytes of the offset and size of a write list entry
+#define WRITE_ENTRY_SIZE (2 * sizeof(uint32_t))
+
+// read an offset or size field from a packet in to a uint32_t, returns the position after the field (value is a
+// member of a packed spec so it is copied in to rather than assigned)
+static char* read_field(void* src, int field_size, void* value)
+{
+    uint16_t value16;
+    uint32_t value32;
+    if (field_size == sizeof(uint16_t))
+    {
+        memcpy(&value16, src, sizeof(uint16_t));
+        value32 = value16;
+    }
+    else
+        memcpy(&value32, src, sizeof(uint32_t));
+    memcpy(value, &value32, sizeof(uint32_t));
+    return (char*)src + field_size;
+}
+
+// write an offset or size field to a packet, returns the position after the field
+static char* write_field(void* dst, int field_size, uint32_t value)
+{
+    uint16_t value16 = (uint16_t)value;
+    if (field_size == sizeof(uint16_t))
+        memcpy(dst, &value16, sizeof(uint16_t));
+    else
+        memcpy(dst, &value, sizeof(uint32_t));
+    return (char*)dst + field_size;
+}
+
+// check an offset and size fit fields of field_size bytes (so they do not wrap)
+static int check_fields(int field_size, uint32_t offset, uint32_t size)
+{
+    if (field_size == sizeof(uint16_t) && (offset > 0xFFFF || size > 0xFFFF))
+        return KOW_STATUS_INVALID_OFFSET;
+    return KOW_STATUS_OK;
+}
+
 static int parse_version(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
 {
     // check packet is large enough for version integer
@@ -16,6 +67,30 @@ static int parse_version(void* payload_packet, int packet_size, struct kowhai_pr
     return KOW_STATUS_OK;
 }
 
+static int parse_packet_size(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+{
+    // check packet is large enough for packet size integer
+    int required_size = sizeof(uint32_t);
+    if (packet_size < required_size)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+
+    // get packet size
+    memcpy(&payload->spec.packet_size, payload_packet, sizeof(uint32_t));
+    return KOW_STATUS_OK;
+}
+
+static int parse_protocol_version(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+{
+    // check packet is large enough for protocol version integer
+    int required_size = sizeof(uint32_t);
+    if (packet_size < required_size)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+
+    // get protocol version
+    memcpy(&payload->spec.protocol_version, payload_packet, sizeof(uint32_t));
+    return KOW_STATUS_OK;
+}
+
 /**
  * @brief Parse the symbols from a read packet into a formatted kowhai_protocol_payload_t structure
  * @param payload_packet a packet read over the protocol that needs the symbols parsed out of 
@@ -54,8 +129,10 @@ static int parse_symbols(void* payload_packet, int packet_size, struct kowhai_pr
  * @param payload parse the payload_packet into the data and buffer sections of this structure
  * @return KOW_STATUS_OK on success otherwise a KOW_STATUS error code
  */
-static int parse_data_payload(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_data_payload(void* payload_packet, int packet_size, int field_size, struct kowhai_protocol_payload_t* payload)
 {
+    char* spec;
+
     // parse symbols
     int required_size;
     int status = parse_symbols(payload_packet, packet_size, payload, &required_size);
@@ -63,21 +140,22 @@ static int parse_data_payload(void* payload_packet, int packet_size, struct kowh
         return status;
 
     // check packet is large enough for the rest of the payload spec
-    required_size += sizeof(struct kowhai_protocol_data_payload_memory_spec_t);
+    spec = (char*)payload_packet + required_size;
+    required_size += DATA_MEMORY_SPEC_SIZE(field_size);
     if (packet_size < required_size)
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
 
     // copy the rest of the payload spec
-    memcpy(&payload->spec.data.memory,
-        (uint8_t*)payload_packet + sizeof(payload->spec.data.symbols.count) + sizeof(union kowhai_symbol_t) * payload->spec.data.symbols.count,
-        sizeof(struct kowhai_protocol_data_payload_memory_spec_t));
+    memcpy(&payload->spec.data.memory.type, spec, sizeof(uint16_t));
+    spec = read_field(spec + sizeof(uint16_t), field_size, &payload->spec.data.memory.offset);
+    spec = read_field(spec, field_size, &payload->spec.data.memory.size);
 
     // check the packet is large enough to hold the payload buffer
-    if (payload->spec.data.memory.size > packet_size - required_size)
+    if (payload->spec.data.memory.size > (uint32_t)(packet_size - required_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
 
     // set payload buffer pointer
-    payload->buffer = (void*)((char*)payload_packet + sizeof(payload->spec.data.symbols.count) + sizeof(union kowhai_symbol_t) * payload->spec.data.symbols.count + sizeof(struct kowhai_protocol_data_payload_memory_spec_t));
+    payload->buffer = (void*)spec;
 
     return KOW_STATUS_OK;
 }
@@ -89,14 +167,79 @@ static int parse_data_payload(void* payload_packet, int packet_size, struct kowh
  * @param payload parse the payload_packet into the descriptor sections of this structure
  * @return KOW_STATUS_OK on success otherwise a KOW_STATUS error code
  */
-static int parse_descriptor_payload(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_descriptor_payload(void* payload_packet, int packet_size, int field_size, struct kowhai_protocol_payload_t* payload)
+{
+    char* spec = (char*)payload_packet;
+    if (packet_size < DESCRIPTOR_SPEC_SIZE(field_size))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    memcpy(&payload->spec.descriptor.node_count, spec, sizeof(uint16_t));
+    spec = read_field(spec + sizeof(uint16_t), field_size, &payload->spec.descriptor.offset);
+    spec = read_field(spec, field_size, &payload->spec.descriptor.size);
+    if (payload->spec.descriptor.size > packet_size - DESCRIPTOR_SPEC_SIZE(field_size))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    payload->buffer = (void*)spec;
+    return KOW_STATUS_OK;
+}
+
+static int parse_read_multi(void* payload_packet, int packet_size, int field_size, struct kowhai_protocol_payload_t* payload)
 {
-    if (packet_size < sizeof(struct kowhai_protocol_descriptor_payload_spec_t))
+    char* spec = (char*)payload_packet;
+    if (packet_size < READ_MULTI_SPEC_SIZE(field_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    memcpy(&payload->spec, payload_packet, sizeof(struct kowhai_protocol_descriptor_payload_spec_t));
-    if (payload->spec.descriptor.size > packet_size - sizeof(struct kowhai_protocol_descriptor_payload_spec_t))
+    memcpy(&payload->spec.read_multi.path_count, spec, sizeof(uint16_t));
+    spec = read_field(spec + sizeof(uint16_t), field_size, &payload->spec.read_multi.offset);
+    spec = read_field(spec, field_size, &payload->spec.read_multi.size);
+    if (payload->spec.read_multi.size > packet_size - READ_MULTI_SPEC_SIZE(field_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    payload->buffer = (void*)((char*)payload_packet + sizeof(struct kowhai_protocol_descriptor_payload_spec_t));
+    payload->buffer = (void*)spec;
+    return KOW_STATUS_OK;
+}
+
+static int parse_write_multi(void* payload_packet, int packet_size, int field_size, struct kowhai_protocol_payload_t* payload)
+{
+    char* spec = (char*)payload_packet;
+    if (packet_size < WRITE_MULTI_SPEC_SIZE(field_size))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    memcpy(&payload->spec.write_multi.entry_count, spec, sizeof(uint16_t));
+    spec = read_field(spec + sizeof(uint16_t), field_size, &payload->spec.write_multi.size);
+    if (payload->spec.write_multi.size > packet_size - WRITE_MULTI_SPEC_SIZE(field_size))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    payload->buffer = (void*)spec;
+    return KOW_STATUS_OK;
+}
+
+static int parse_handle(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+{
+    if (packet_size < sizeof(uint16_t))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    memcpy(&payload->spec.handle.handle, payload_packet, sizeof(uint16_t));
+    return KOW_STATUS_OK;
+}
+
+static int parse_handle_payload(void* payload_packet, int packet_size, int field_size, int has_payload, struct kowhai_protocol_payload_t* payload)
+{
+    char* spec = (char*)payload_packet;
+    if (packet_size < HANDLE_SPEC_SIZE(field_size))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    memcpy(&payload->spec.handle.handle, spec, sizeof(uint16_t));
+    memcpy(&payload->spec.handle.memory.type, spec + sizeof(uint16_t), sizeof(uint16_t));
+    spec = read_field(spec + 2 * sizeof(uint16_t), field_size, &payload->spec.handle.memory.offset);
+    spec = read_field(spec, field_size, &payload->spec.handle.memory.size);
+    if (!has_payload)
+        return KOW_STATUS_OK;
+    if (payload->spec.handle.memory.size > packet_size - HANDLE_SPEC_SIZE(field_size))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    payload->buffer = (void*)spec;
+    return KOW_STATUS_OK;
+}
+
+static int parse_subscribe(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+{
+    if (packet_size < SUBSCRIBE_SPEC_SIZE)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    memcpy(&payload->spec.subscribe.handle, payload_packet, sizeof(uint16_t));
+    memcpy(&payload->spec.subscribe.period, (char*)payload_packet + sizeof(uint16_t), sizeof(uint32_t));
+    memcpy(&payload->spec.subscribe.window, (char*)payload_packet + sizeof(uint16_t) + sizeof(uint32_t), sizeof(uint32_t));
     return KOW_STATUS_OK;
 }
 
@@ -130,31 +273,42 @@ static int parse_function_details(void* payload_packet, int packet_size, struct
     return KOW_STATUS_OK;
 }
 
-static int parse_function_call(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_function_call(void* payload_packet, int packet_size, int field_size, struct kowhai_protocol_payload_t* payload)
 {
-    if (packet_size < sizeof(struct kowhai_protocol_function_call_t))
+    char* spec = (char*)payload_packet;
+    if (packet_size < OFFSET_SIZE_SPEC_SIZE(field_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    memcpy(&payload->spec, payload_packet, sizeof(struct kowhai_protocol_function_call_t));
-    if (payload->spec.function_call.size > packet_size - sizeof(struct kowhai_protocol_function_call_t))
+    spec = read_field(spec, field_size, &payload->spec.function_call.offset);
+    spec = read_field(spec, field_size, &payload->spec.function_call.size);
+    if (payload->spec.function_call.size > packet_size - OFFSET_SIZE_SPEC_SIZE(field_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    payload->buffer = (void*)((char*)payload_packet + sizeof(struct kowhai_protocol_function_call_t));
+    payload->buffer = (void*)spec;
     return KOW_STATUS_OK;
 }
 
-static int parse_event(void* payload_packet, int packet_size, struct kowhai_protocol_payload_t* payload)
+static int parse_event(void* payload_packet, int packet_size, int field_size, struct kowhai_protocol_payload_t* payload)
 {
-    if (packet_size < sizeof(struct kowhai_protocol_event_t))
+    char* spec = (char*)payload_packet;
+    if (packet_size < OFFSET_SIZE_SPEC_SIZE(field_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    memcpy(&payload->spec, payload_packet, sizeof(struct kowhai_protocol_event_t));
-    if (payload->spec.event.size > packet_size - sizeof(struct kowhai_protocol_event_t))
+    spec = read_field(spec, field_size, &payload->spec.event.offset);
+    spec = read_field(spec, field_size, &payload->spec.event.size);
+    if (payload->spec.event.size > packet_size - OFFSET_SIZE_SPEC_SIZE(field_size))
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    payload->buffer = (void*)((char*)payload_packet + sizeof(struct kowhai_protocol_event_t));
+    payload->buffer = (void*)spec;
     return KOW_STATUS_OK;
 }
 
 int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol)
 {
-    int required_size = sizeof(struct kowhai_protocol_header_t);
+    return kowhai_protocol_parse2(proto_packet, packet_size, KOW_PROTOCOL_VERSION_1, protocol);
+}
+
+int kowhai_protocol_parse2(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol)
+{
+    int field_size = FIELD_SIZE(version);
+    int header_size = HEADER_SIZE(version);
+    int required_size = header_size;
     memset(protocol, 0, sizeof(struct kowhai_protocol_t));
 
     // check packet is large enough for header
@@ -176,19 +330,20 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
         case KOW_CMD_GET_FUNCTION_LIST_ACK_END:
             return parse_id_list((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
         case KOW_CMD_READ_DATA:
+        case KOW_CMD_RESOLVE:
             return parse_symbols((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload, &required_size);
         case KOW_CMD_WRITE_DATA:
         case KOW_CMD_WRITE_DATA_END:
         case KOW_CMD_WRITE_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK_END:
-            return parse_data_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_data_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size, &protocol->payload);
         case KOW_CMD_READ_DESCRIPTOR:
             // read descriptor command requires no more parameters
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DESCRIPTOR_ACK:
         case KOW_CMD_READ_DESCRIPTOR_ACK_END:
-            return parse_descriptor_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_descriptor_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size, &protocol->payload);
         case KOW_CMD_GET_FUNCTION_LIST:
         case KOW_CMD_GET_FUNCTION_DETAILS:
             // get function list/details command requires no more parameters
@@ -199,17 +354,46 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
         case KOW_CMD_CALL_FUNCTION_ACK:
         case KOW_CMD_CALL_FUNCTION_RESULT:
         case KOW_CMD_CALL_FUNCTION_RESULT_END:
-            return parse_function_call((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_function_call((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size, &protocol->payload);
         case KOW_CMD_CALL_FUNCTION_FAILED:
             return KOW_STATUS_OK;
         case KOW_CMD_EVENT:
         case KOW_CMD_EVENT_END:
-            return parse_event((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+            return parse_event((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size, &protocol->payload);
         case KOW_CMD_GET_SYMBOL_LIST:
             return KOW_STATUS_OK;
         case KOW_CMD_GET_SYMBOL_LIST_ACK:
         case KOW_CMD_GET_SYMBOL_LIST_ACK_END:
             return parse_string_list((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+        case KOW_CMD_SET_PACKET_SIZE:
+        case KOW_CMD_SET_PACKET_SIZE_ACK:
+            return parse_packet_size((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+        case KOW_CMD_SET_PROTOCOL_VERSION:
+        case KOW_CMD_SET_PROTOCOL_VERSION_ACK:
+            return parse_protocol_version((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+        case KOW_CMD_READ_MULTI:
+        case KOW_CMD_READ_MULTI_HANDLES:
+        case KOW_CMD_READ_MULTI_ACK:
+        case KOW_CMD_READ_MULTI_ACK_END:
+            return parse_read_multi((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size, &protocol->payload);
+        case KOW_CMD_WRITE_MULTI:
+        case KOW_CMD_WRITE_MULTI_ACK:
+            return parse_write_multi((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size, &protocol->payload);
+        case KOW_CMD_SUBSCRIBE:
+        case KOW_CMD_SUBSCRIBE_ACK:
+        case KOW_CMD_UNSUBSCRIBE:
+        case KOW_CMD_UNSUBSCRIBE_ACK:
+            return parse_subscribe((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+        case KOW_CMD_READ_HANDLE:
+            return parse_handle((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, &protocol->payload);
+        case KOW_CMD_RESOLVE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK_END:
+        case KOW_CMD_WRITE_HANDLE:
+        case KOW_CMD_WRITE_HANDLE_END:
+        case KOW_CMD_WRITE_HANDLE_ACK:
+            return parse_handle_payload((void*)((uint8_t*)proto_packet + required_size), packet_size - required_size, field_size,
+                protocol->header.command != KOW_CMD_RESOLVE_ACK, &protocol->payload);
 
         // error codes
         case KOW_CMD_ERROR_INVALID_COMMAND:
@@ -220,22 +404,27 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
         case KOW_CMD_ERROR_INVALID_SYMBOL_PATH:
         case KOW_CMD_ERROR_INVALID_TREE_ID:
         case KOW_CMD_ERROR_NO_DATA:
+        case KOW_CMD_ERROR_INVALID_HANDLE:
+        case KOW_CMD_ERROR_HANDLE_TABLE_FULL:
+        case KOW_CMD_ERROR_SUBSCRIPTION_TABLE_FULL:
             return KOW_STATUS_OK;
         default:
             return KOW_STATUS_INVALID_PROTOCOL_COMMAND;
     }
 }
 
-int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol, int* bytes_required)
+static int create(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol, int write_payload, int* bytes_required)
 {
     char* pkt = (char*)proto_packet;
+    int field_size = FIELD_SIZE(version);
+    int header_size = HEADER_SIZE(version);
 
     // write protocol header
-    *bytes_required = sizeof(struct kowhai_protocol_header_t);
+    *bytes_required = header_size;
     if (packet_size < *bytes_required)
         return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-    memcpy(pkt, &protocol->header, sizeof(struct kowhai_protocol_header_t));
-    pkt += sizeof(struct kowhai_protocol_header_t);
+    memcpy(pkt, &protocol->header, header_size);
+    pkt += header_size;
 
     // check protocol command
     switch (protocol->header.command)
@@ -262,6 +451,8 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
             memcpy(pkt, &protocol->payload.spec.id_list, sizeof(struct kowhai_protocol_id_list_t));
             pkt += sizeof(struct kowhai_protocol_id_list_t);
             // write payload
+            if (!write_payload)
+                break;
             *bytes_required += protocol->payload.spec.id_list.size;
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
@@ -274,6 +465,7 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
         case KOW_CMD_READ_DATA_ACK:
         case KOW_CMD_READ_DATA:
         case KOW_CMD_READ_DATA_ACK_END:
+        case KOW_CMD_RESOLVE:
             // write symbol count
             *bytes_required += SYM_COUNT_SIZE;
             if (packet_size < *bytes_required)
@@ -286,16 +478,21 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
             memcpy(pkt, protocol->payload.spec.data.symbols.array_, protocol->payload.spec.data.symbols.count * sizeof(union kowhai_symbol_t));
             pkt += protocol->payload.spec.data.symbols.count * sizeof(union kowhai_symbol_t);
-            // read data command requires no more parameters
-            if (protocol->header.command == KOW_CMD_READ_DATA)
+            // read data and resolve commands require no more parameters
+            if (protocol->header.command == KOW_CMD_READ_DATA || protocol->header.command == KOW_CMD_RESOLVE)
                 return KOW_STATUS_OK;
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_data_payload_memory_spec_t);
+            if (check_fields(field_size, protocol->payload.spec.data.memory.offset, protocol->payload.spec.data.memory.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += DATA_MEMORY_SPEC_SIZE(field_size);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.data.memory, sizeof(struct kowhai_protocol_data_payload_memory_spec_t));
-            pkt += sizeof(struct kowhai_protocol_data_payload_memory_spec_t);
+            memcpy(pkt, &protocol->payload.spec.data.memory.type, sizeof(uint16_t));
+            pkt = write_field(pkt + sizeof(uint16_t), field_size, protocol->payload.spec.data.memory.offset);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.data.memory.size);
             // write payload
+            if (!write_payload)
+                break;
             *bytes_required += protocol->payload.spec.data.memory.size;
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
@@ -307,12 +504,17 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
         case KOW_CMD_READ_DESCRIPTOR_ACK:
         case KOW_CMD_READ_DESCRIPTOR_ACK_END:
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_descriptor_payload_spec_t);
+            if (check_fields(field_size, protocol->payload.spec.descriptor.offset, protocol->payload.spec.descriptor.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += DESCRIPTOR_SPEC_SIZE(field_size);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.descriptor, sizeof(struct kowhai_protocol_descriptor_payload_spec_t));
-            pkt += sizeof(struct kowhai_protocol_descriptor_payload_spec_t);
+            memcpy(pkt, &protocol->payload.spec.descriptor.node_count, sizeof(uint16_t));
+            pkt = write_field(pkt + sizeof(uint16_t), field_size, protocol->payload.spec.descriptor.offset);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.descriptor.size);
             // write payload
+            if (!write_payload)
+                break;
             *bytes_required += protocol->payload.spec.descriptor.size;
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
@@ -334,12 +536,16 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
         case KOW_CMD_CALL_FUNCTION_RESULT:
         case KOW_CMD_CALL_FUNCTION_RESULT_END:
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_function_call_t);
+            if (check_fields(field_size, protocol->payload.spec.function_call.offset, protocol->payload.spec.function_call.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += OFFSET_SIZE_SPEC_SIZE(field_size);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.function_call, sizeof(struct kowhai_protocol_function_call_t));
-            pkt += sizeof(struct kowhai_protocol_function_call_t);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.function_call.offset);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.function_call.size);
             // write payload
+            if (!write_payload)
+                break;
             *bytes_required += protocol->payload.spec.function_call.size;
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
@@ -350,12 +556,16 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
         case KOW_CMD_EVENT:
         case KOW_CMD_EVENT_END:
             // write payload spec
-            *bytes_required += sizeof(struct kowhai_protocol_event_t);
+            if (check_fields(field_size, protocol->payload.spec.event.offset, protocol->payload.spec.event.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += OFFSET_SIZE_SPEC_SIZE(field_size);
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
-            memcpy(pkt, &protocol->payload.spec.event, sizeof(struct kowhai_protocol_event_t));
-            pkt += sizeof(struct kowhai_protocol_event_t);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.event.offset);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.event.size);
             // write payload
+            if (!write_payload)
+                break;
             *bytes_required += protocol->payload.spec.event.size;
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
@@ -372,79 +582,367 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
             memcpy(pkt, &protocol->payload.spec.string_list, sizeof(struct kowhai_protocol_string_list_t));
             pkt += sizeof(struct kowhai_protocol_string_list_t);
             // write payload
+            if (!write_payload)
+                break;
             *bytes_required += protocol->payload.spec.string_list.size;
             if (packet_size < *bytes_required)
                 return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
             memcpy(pkt, protocol->payload.buffer, protocol->payload.spec.string_list.size);
             pkt += protocol->payload.spec.string_list.size;
             break;
+        case KOW_CMD_SET_PACKET_SIZE:
+        case KOW_CMD_SET_PACKET_SIZE_ACK:
+            // write packet size
+            *bytes_required += sizeof(uint32_t);
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.packet_size, sizeof(uint32_t));
+            break;
+        case KOW_CMD_SET_PROTOCOL_VERSION:
+        case KOW_CMD_SET_PROTOCOL_VERSION_ACK:
+            // write protocol version
+            *bytes_required += sizeof(uint32_t);
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.protocol_version, sizeof(uint32_t));
+            break;
+        case KOW_CMD_READ_MULTI:
+        case KOW_CMD_READ_MULTI_HANDLES:
+        case KOW_CMD_READ_MULTI_ACK:
+        case KOW_CMD_READ_MULTI_ACK_END:
+            // write payload spec
+            if (check_fields(field_size, protocol->payload.spec.read_multi.offset, protocol->payload.spec.read_multi.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += READ_MULTI_SPEC_SIZE(field_size);
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.read_multi.path_count, sizeof(uint16_t));
+            pkt = write_field(pkt + sizeof(uint16_t), field_size, protocol->payload.spec.read_multi.offset);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.read_multi.size);
+            // write payload
+            if (!write_payload)
+                break;
+            *bytes_required += protocol->payload.spec.read_multi.size;
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, protocol->payload.buffer, protocol->payload.spec.read_multi.size);
+            break;
+        case KOW_CMD_WRITE_MULTI:
+        case KOW_CMD_WRITE_MULTI_ACK:
+            // write payload spec
+            if (check_fields(field_size, 0, protocol->payload.spec.write_multi.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += WRITE_MULTI_SPEC_SIZE(field_size);
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.write_multi.entry_count, sizeof(uint16_t));
+            pkt = write_field(pkt + sizeof(uint16_t), field_size, protocol->payload.spec.write_multi.size);
+            // write payload
+            if (!write_payload)
+                break;
+            *bytes_required += protocol->payload.spec.write_multi.size;
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            // the acknowledgement has no write list (and no buffer)
+            if (protocol->payload.spec.write_multi.size > 0)
+                memcpy(pkt, protocol->payload.buffer, protocol->payload.spec.write_multi.size);
+            break;
+        case KOW_CMD_SUBSCRIBE:
+        case KOW_CMD_SUBSCRIBE_ACK:
+        case KOW_CMD_UNSUBSCRIBE:
+        case KOW_CMD_UNSUBSCRIBE_ACK:
+            // write subscription
+            *bytes_required += SUBSCRIBE_SPEC_SIZE;
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.subscribe.handle, sizeof(uint16_t));
+            memcpy(pkt + sizeof(uint16_t), &protocol->payload.spec.subscribe.period, sizeof(uint32_t));
+            memcpy(pkt + sizeof(uint16_t) + sizeof(uint32_t), &protocol->payload.spec.subscribe.window, sizeof(uint32_t));
+            break;
+        case KOW_CMD_READ_HANDLE:
+            // write handle
+            *bytes_required += sizeof(uint16_t);
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.handle.handle, sizeof(uint16_t));
+            break;
+        case KOW_CMD_RESOLVE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK_END:
+        case KOW_CMD_WRITE_HANDLE:
+        case KOW_CMD_WRITE_HANDLE_END:
+        case KOW_CMD_WRITE_HANDLE_ACK:
+            // write payload spec
+            if (check_fields(field_size, protocol->payload.spec.handle.memory.offset, protocol->payload.spec.handle.memory.size) != KOW_STATUS_OK)
+                return KOW_STATUS_INVALID_OFFSET;
+            *bytes_required += HANDLE_SPEC_SIZE(field_size);
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, &protocol->payload.spec.handle.handle, sizeof(uint16_t));
+            memcpy(pkt + sizeof(uint16_t), &protocol->payload.spec.handle.memory.type, sizeof(uint16_t));
+            pkt = write_field(pkt + 2 * sizeof(uint16_t), field_size, protocol->payload.spec.handle.memory.offset);
+            pkt = write_field(pkt, field_size, protocol->payload.spec.handle.memory.size);
+            // write payload (the size of a resolve acknowledgement is the size of the data the handle addresses)
+            if (!write_payload || protocol->header.command == KOW_CMD_RESOLVE_ACK)
+                break;
+            *bytes_required += protocol->payload.spec.handle.memory.size;
+            if (packet_size < *bytes_required)
+                return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+            memcpy(pkt, protocol->payload.buffer, protocol->payload.spec.handle.memory.size);
+            break;
         default:
             return KOW_STATUS_INVALID_PROTOCOL_COMMAND;
     }
     return KOW_STATUS_OK;
 }
 
+int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol, int* bytes_required)
+{
+    return create(proto_packet, packet_size, KOW_PROTOCOL_VERSION_1, protocol, 1, bytes_required);
+}
+
+int kowhai_protocol_create2(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol, int* bytes_required)
+{
+    return create(proto_packet, packet_size, version, protocol, 1, bytes_required);
+}
+
+int kowhai_protocol_create_header(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol, int* bytes_required)
+{
+    return create(proto_packet, packet_size, version, protocol, 0, bytes_required);
+}
+
+int kowhai_protocol_get_payload(struct kowhai_protocol_t* protocol, void** payload, int* payload_size)
+{
+    *payload = protocol->payload.buffer;
+    // check protocol command
+    switch (protocol->header.command)
+    {
+        case KOW_CMD_GET_TREE_LIST_ACK:
+        case KOW_CMD_GET_TREE_LIST_ACK_END:
+        case KOW_CMD_GET_FUNCTION_LIST_ACK:
+        case KOW_CMD_GET_FUNCTION_LIST_ACK_END:
+            *payload_size = protocol->payload.spec.id_list.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_WRITE_DATA:
+        case KOW_CMD_WRITE_DATA_END:
+        case KOW_CMD_WRITE_DATA_ACK:
+        case KOW_CMD_READ_DATA_ACK:
+        case KOW_CMD_READ_DATA_ACK_END:
+            *payload_size = protocol->payload.spec.data.memory.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_READ_DESCRIPTOR_ACK:
+        case KOW_CMD_READ_DESCRIPTOR_ACK_END:
+            *payload_size = protocol->payload.spec.descriptor.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_CALL_FUNCTION:
+        case KOW_CMD_CALL_FUNCTION_ACK:
+        case KOW_CMD_CALL_FUNCTION_RESULT:
+        case KOW_CMD_CALL_FUNCTION_RESULT_END:
+            *payload_size = protocol->payload.spec.function_call.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_EVENT:
+        case KOW_CMD_EVENT_END:
+            *payload_size = protocol->payload.spec.event.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_GET_SYMBOL_LIST_ACK:
+        case KOW_CMD_GET_SYMBOL_LIST_ACK_END:
+            *payload_size = protocol->payload.spec.string_list.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_READ_MULTI:
+        case KOW_CMD_READ_MULTI_HANDLES:
+        case KOW_CMD_READ_MULTI_ACK:
+        case KOW_CMD_READ_MULTI_ACK_END:
+            *payload_size = protocol->payload.spec.read_multi.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_WRITE_MULTI:
+        case KOW_CMD_WRITE_MULTI_ACK:
+            *payload_size = protocol->payload.spec.write_multi.size;
+            return KOW_STATUS_OK;
+        case KOW_CMD_READ_HANDLE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK_END:
+        case KOW_CMD_WRITE_HANDLE:
+        case KOW_CMD_WRITE_HANDLE_END:
+        case KOW_CMD_WRITE_HANDLE_ACK:
+            *payload_size = protocol->payload.spec.handle.memory.size;
+            return KOW_STATUS_OK;
+        default:
+            // the command has no payload
+            *payload = NULL;
+            *payload_size = 0;
+            return KOW_STATUS_OK;
+    }
+}
+
 int kowhai_protocol_get_overhead(struct kowhai_protocol_t* protocol, int* overhead)
 {
+    return kowhai_protocol_get_overhead2(protocol, KOW_PROTOCOL_VERSION_1, overhead);
+}
+
+int kowhai_protocol_get_overhead2(struct kowhai_protocol_t* protocol, int version, int* overhead)
+{
+    int field_size = FIELD_SIZE(version);
+    int header_size = HEADER_SIZE(version);
     // check protocol command
     switch (protocol->header.command)
     {
         case KOW_CMD_GET_TREE_LIST:
-            *overhead = sizeof(struct kowhai_protocol_header_t);
+            *overhead = header_size;
             return KOW_STATUS_OK;
         case KOW_CMD_GET_TREE_LIST_ACK:
         case KOW_CMD_GET_TREE_LIST_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_id_list_t);
+            *overhead = header_size + sizeof(struct kowhai_protocol_id_list_t);
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DESCRIPTOR:
-            *overhead = sizeof(struct kowhai_protocol_header_t);
+            *overhead = header_size;
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DESCRIPTOR_ACK:
         case KOW_CMD_READ_DESCRIPTOR_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_descriptor_payload_spec_t);
+            *overhead = header_size + DESCRIPTOR_SPEC_SIZE(field_size);
             return KOW_STATUS_OK;
         case KOW_CMD_WRITE_DATA:
         case KOW_CMD_WRITE_DATA_END:
         case KOW_CMD_WRITE_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK:
         case KOW_CMD_READ_DATA_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_t) - sizeof(protocol->payload.spec.data.symbols.array_) +
-                sizeof(union kowhai_symbol_t) * protocol->payload.spec.data.symbols.count -
-                sizeof(protocol->payload.buffer);
+            *overhead = header_size + sizeof(protocol->payload.spec.data.symbols.count) +
+                sizeof(union kowhai_symbol_t) * protocol->payload.spec.data.symbols.count + DATA_MEMORY_SPEC_SIZE(field_size);
             return KOW_STATUS_OK;
         case KOW_CMD_READ_DATA:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(protocol->payload.spec.data.symbols.count) +
+        case KOW_CMD_RESOLVE:
+            *overhead = header_size + sizeof(protocol->payload.spec.data.symbols.count) +
                 sizeof(union kowhai_symbol_t) * protocol->payload.spec.data.symbols.count;
             return KOW_STATUS_OK;
         case KOW_CMD_GET_FUNCTION_LIST:
         case KOW_CMD_GET_FUNCTION_DETAILS:
-            *overhead = sizeof(struct kowhai_protocol_header_t);
+            *overhead = header_size;
             return KOW_STATUS_OK;
         case KOW_CMD_GET_FUNCTION_LIST_ACK:
         case KOW_CMD_GET_FUNCTION_LIST_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_id_list_t);
+            *overhead = header_size + sizeof(struct kowhai_protocol_id_list_t);
             return KOW_STATUS_OK;
         case KOW_CMD_GET_FUNCTION_DETAILS_ACK:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_function_details_t);
+            *overhead = header_size + sizeof(struct kowhai_protocol_function_details_t);
             return KOW_STATUS_OK;
         case KOW_CMD_CALL_FUNCTION:
         case KOW_CMD_CALL_FUNCTION_ACK:
         case KOW_CMD_CALL_FUNCTION_RESULT:
         case KOW_CMD_CALL_FUNCTION_RESULT_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_function_call_t);
+            *overhead = header_size + OFFSET_SIZE_SPEC_SIZE(field_size);
             return KOW_STATUS_OK;
         case KOW_CMD_EVENT:
         case KOW_CMD_EVENT_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_event_t);
+            *overhead = header_size + OFFSET_SIZE_SPEC_SIZE(field_size);
             return KOW_STATUS_OK;
         case KOW_CMD_GET_SYMBOL_LIST:
-            *overhead = sizeof(struct kowhai_protocol_header_t);
+            *overhead = header_size;
             return KOW_STATUS_OK;
         case KOW_CMD_GET_SYMBOL_LIST_ACK:
         case KOW_CMD_GET_SYMBOL_LIST_ACK_END:
-            *overhead = sizeof(struct kowhai_protocol_header_t) + sizeof(struct kowhai_protocol_string_list_t);
+            *overhead = header_size + sizeof(struct kowhai_protocol_string_list_t);
+            return KOW_STATUS_OK;
+        case KOW_CMD_SET_PACKET_SIZE:
+        case KOW_CMD_SET_PACKET_SIZE_ACK:
+        case KOW_CMD_SET_PROTOCOL_VERSION:
+        case KOW_CMD_SET_PROTOCOL_VERSION_ACK:
+            *overhead = header_size + sizeof(uint32_t);
+            return KOW_STATUS_OK;
+        case KOW_CMD_READ_MULTI:
+        case KOW_CMD_READ_MULTI_HANDLES:
+        case KOW_CMD_READ_MULTI_ACK:
+        case KOW_CMD_READ_MULTI_ACK_END:
+            *overhead = header_size + READ_MULTI_SPEC_SIZE(field_size);
+            return KOW_STATUS_OK;
+        case KOW_CMD_WRITE_MULTI:
+        case KOW_CMD_WRITE_MULTI_ACK:
+            *overhead = header_size + WRITE_MULTI_SPEC_SIZE(field_size);
+            return KOW_STATUS_OK;
+        case KOW_CMD_READ_HANDLE:
+            *overhead = header_size + sizeof(uint16_t);
+            return KOW_STATUS_OK;
+        case KOW_CMD_SUBSCRIBE:
+        case KOW_CMD_SUBSCRIBE_ACK:
+        case KOW_CMD_UNSUBSCRIBE:
+        case KOW_CMD_UNSUBSCRIBE_ACK:
+            *overhead = header_size + SUBSCRIBE_SPEC_SIZE;
+            return KOW_STATUS_OK;
+        case KOW_CMD_RESOLVE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK:
+        case KOW_CMD_READ_HANDLE_ACK_END:
+        case KOW_CMD_WRITE_HANDLE:
+        case KOW_CMD_WRITE_HANDLE_END:
+        case KOW_CMD_WRITE_HANDLE_ACK:
+            *overhead = header_size + HANDLE_SPEC_SIZE(field_size);
             return KOW_STATUS_OK;
         default:
             return KOW_STATUS_INVALID_PROTOCOL_COMMAND;
     }
 }
+
+int kowhai_protocol_add_path(void* paths, int paths_size, int* used, int symbol_count, const union kowhai_symbol_t* symbols)
+{
+    char* path = (char*)paths + *used;
+    int size = SYM_COUNT_SIZE + symbol_count * sizeof(union kowhai_symbol_t);
+    if (symbol_count > 0xFF || paths_size - *used < size)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    *path = (uint8_t)symbol_count;
+    memcpy(path + SYM_COUNT_SIZE, symbols, symbol_count * sizeof(union kowhai_symbol_t));
+    *used += size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_protocol_next_path(void* paths, int paths_size, int* position, int* symbol_count, union kowhai_symbol_t** symbols)
+{
+    uint8_t* path = (uint8_t*)paths + *position;
+    int size;
+    if (*position >= paths_size)
+        return KOW_STATUS_NOT_FOUND;
+    size = SYM_COUNT_SIZE + *path * sizeof(union kowhai_symbol_t);
+    if (paths_size - *position < size)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    *symbol_count = *path;
+    *symbols = (union kowhai_symbol_t*)(path + SYM_COUNT_SIZE);
+    *position += size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_protocol_add_write(void* entries, int entries_size, int* used, int symbol_count, const union kowhai_symbol_t* symbols, int offset, const void* value, int size)
+{
+    int path_used = *used;
+    uint32_t field;
+    char* entry;
+    int status = kowhai_protocol_add_path(entries, entries_size, &path_used, symbol_count, symbols);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (offset < 0 || size < 0 || entries_size - path_used < (int)WRITE_ENTRY_SIZE + size)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    entry = (char*)entries + path_used;
+    field = (uint32_t)offset;
+    memcpy(entry, &field, sizeof(uint32_t));
+    field = (uint32_t)size;
+    memcpy(entry + sizeof(uint32_t), &field, sizeof(uint32_t));
+    memcpy(entry + WRITE_ENTRY_SIZE, value, size);
+    *used = path_used + WRITE_ENTRY_SIZE + size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_protocol_next_write(void* entries, int entries_size, int* position, int* symbol_count, union kowhai_symbol_t** symbols, int* offset, void** value, int* size)
+{
+    int path_position = *position;
+    uint32_t entry_offset, entry_size;
+    char* entry;
+    int status = kowhai_protocol_next_path(entries, entries_size, &path_position, symbol_count, symbols);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (entries_size - path_position < (int)WRITE_ENTRY_SIZE)
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    entry = (char*)entries + path_position;
+    memcpy(&entry_offset, entry, sizeof(uint32_t));
+    memcpy(&entry_size, entry + sizeof(uint32_t), sizeof(uint32_t));
+    if (entry_offset > 0x7FFFFFFF || entry_size > (uint32_t)(entries_size - path_position - WRITE_ENTRY_SIZE))
+        return KOW_STATUS_PACKET_BUFFER_TOO_SMALL;
+    *offset = (int)entry_offset;
+    *size = (int)entry_size;
+    *value = entry + WRITE_ENTRY_SIZE;
+    *position = path_position + WRITE_ENTRY_SIZE + entry_size;
+    return KOW_STATUS_OK;
+}
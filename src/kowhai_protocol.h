@@ -66,6 +66,14 @@
 #define KOW_CMD_EVENT                        0x80
 // Server event (final packet)
 #define KOW_CMD_EVENT_END                    0x8F
+// Subscribe to events of the data addressed by a handle (see kowhai_server_tick)
+#define KOW_CMD_SUBSCRIBE                    0x81
+// Acknowledge subscribe command
+#define KOW_CMD_SUBSCRIBE_ACK                0x8E
+// Stop the events of a subscription
+#define KOW_CMD_UNSUBSCRIBE                  0x82
+// Acknowledge unsubscribe command
+#define KOW_CMD_UNSUBSCRIBE_ACK              0x8D
 
 // Get the symbol list
 #define KOW_CMD_GET_SYMBOL_LIST              0x90
@@ -74,6 +82,45 @@
 // Acknowledge get symbol list command (this is the final packet)
 #define KOW_CMD_GET_SYMBOL_LIST_ACK_END      0x9E
 
+// Negotiate the packet size (the largest packet the client can handle, the server acknowledges the size both can handle)
+#define KOW_CMD_SET_PACKET_SIZE              0xA0
+#define KOW_CMD_SET_PACKET_SIZE_ACK          0xAF
+
+// Negotiate the protocol version (the newest version the client can handle, the server acknowledges the version both can handle)
+#define KOW_CMD_SET_PROTOCOL_VERSION         0xB0
+#define KOW_CMD_SET_PROTOCOL_VERSION_ACK     0xBF
+
+// Read several nodes of a tree (the payload is a path list, see kowhai_protocol_add_path)
+#define KOW_CMD_READ_MULTI                   0xC0
+// Read several nodes of a tree (the payload is a list of 16 bit handles, see KOW_CMD_RESOLVE), acknowledged as read multi
+#define KOW_CMD_READ_MULTI_HANDLES           0xC1
+// Acknowledge read multi command (and return the values of the paths one after the other)
+#define KOW_CMD_READ_MULTI_ACK               0xCF
+// Acknowledge read multi command (this is the final packet)
+#define KOW_CMD_READ_MULTI_ACK_END           0xCE
+
+// Write several nodes of a tree in one step (the payload is a write list, see kowhai_protocol_add_write)
+#define KOW_CMD_WRITE_MULTI                  0xD0
+// Acknowledge write multi command (all the writes were applied)
+#define KOW_CMD_WRITE_MULTI_ACK              0xDF
+
+// Resolve a symbol path to a handle (the payload is the symbol path like read tree data)
+#define KOW_CMD_RESOLVE                      0xE0
+// Acknowledge resolve command (and return the handle, node type and the size of the data it addresses)
+#define KOW_CMD_RESOLVE_ACK                  0xEF
+// Read tree data addressed by a handle
+#define KOW_CMD_READ_HANDLE                  0xE1
+// Acknowledge read handle command (and return the data)
+#define KOW_CMD_READ_HANDLE_ACK              0xEE
+// Acknowledge read handle command (this is the final packet)
+#define KOW_CMD_READ_HANDLE_ACK_END          0xED
+// Write tree data addressed by a handle
+#define KOW_CMD_WRITE_HANDLE                 0xE2
+// Write tree data addressed by a handle (this is the final write packet)
+#define KOW_CMD_WRITE_HANDLE_END             0xE3
+// Acknowledge write handle command
+#define KOW_CMD_WRITE_HANDLE_ACK             0xEC
+
 // Error codes
 #define KOW_CMD_ERROR_INVALID_COMMAND        0xF0
 #define KOW_CMD_ERROR_INVALID_TREE_ID        0xF1
@@ -83,8 +130,33 @@
 #define KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE   0xF5
 #define KOW_CMD_ERROR_INVALID_SEQUENCE       0xF6
 #define KOW_CMD_ERROR_NO_DATA                0xF7
+#define KOW_CMD_ERROR_INVALID_HANDLE         0xF8
+#define KOW_CMD_ERROR_HANDLE_TABLE_FULL      0xF9
+#define KOW_CMD_ERROR_SUBSCRIPTION_TABLE_FULL 0xFA
 #define KOW_CMD_ERROR_UNKNOWN                0xFF
 
+//
+// Protocol versions
+//
+
+// data, descriptor, function call and event payload offsets and sizes are 16 bit (a connection starts with this version)
+#define KOW_PROTOCOL_VERSION_1               1
+// data, descriptor, function call and event payload offsets and sizes are 32 bit (for trees larger than 64 KB)
+#define KOW_PROTOCOL_VERSION_2               2
+// the header carries a request tag that the server echoes in each response packet (so requests can be pipelined)
+#define KOW_PROTOCOL_VERSION_3               3
+// newest protocol version
+#define KOW_PROTOCOL_VERSION                 KOW_PROTOCOL_VERSION_3
+
+//
+// Protocol limits
+//
+
+// smallest packet size that can be negotiated
+#define KOW_PROTOCOL_MIN_PACKET_SIZE         0x20
+// largest packet size that can be negotiated (id list and symbol list payload sizes are 16 bit)
+#define KOW_PROTOCOL_MAX_PACKET_SIZE         0x10000
+
 //
 // Protocol structures
 //
@@ -98,6 +170,7 @@ struct kowhai_protocol_header_t
 {
     uint8_t command;
     uint16_t id;
+    uint16_t tag;       ///< request tag, only on the wire from KOW_PROTOCOL_VERSION_3 (events are sent with tag 0)
 };
 
 /**
@@ -115,8 +188,8 @@ struct kowhai_protocol_symbol_spec_t
 struct kowhai_protocol_data_payload_memory_spec_t
 {
     uint16_t type;
-    uint16_t offset;
-    uint16_t size;
+    uint32_t offset;    ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
+    uint32_t size;      ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
 };
 
 /**
@@ -134,8 +207,8 @@ struct kowhai_protocol_data_payload_spec_t
 struct kowhai_protocol_descriptor_payload_spec_t
 {
     uint16_t node_count;
-    uint16_t offset;
-    uint16_t size;
+    uint32_t offset;    ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
+    uint32_t size;      ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
 };
 
 /**
@@ -182,8 +255,8 @@ struct kowhai_protocol_function_details_t
  */
 struct kowhai_protocol_function_call_t
 {
-    uint16_t offset;
-    uint16_t size;
+    uint32_t offset;    ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
+    uint32_t size;      ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
 };
 
 /**
@@ -191,8 +264,49 @@ struct kowhai_protocol_function_call_t
  */
 struct kowhai_protocol_event_t
 {
-    uint16_t offset;
-    uint16_t size;
+    uint32_t offset;    ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
+    uint32_t size;      ///< 16 bit on the wire before KOW_PROTOCOL_VERSION_2
+};
+
+/**
+ * @brief a read multi request (the payload is a path list or handle list) or response (the payload is part of the values)
+ */
+struct kowhai_protocol_read_multi_t
+{
+    uint16_t path_count;    ///< number of paths (or handles) in the list
+    uint32_t offset;        ///< offset of the payload in the path list or values (16 bit on the wire before KOW_PROTOCOL_VERSION_2)
+    uint32_t size;          ///< bytes of payload (16 bit on the wire before KOW_PROTOCOL_VERSION_2)
+};
+
+/**
+ * @brief a write multi request (the payload is a write list) or acknowledgement (there is no payload)
+ */
+struct kowhai_protocol_write_multi_t
+{
+    uint16_t entry_count;   ///< number of writes in the write list
+    uint32_t size;          ///< bytes of payload (16 bit on the wire before KOW_PROTOCOL_VERSION_2)
+};
+
+/**
+ * @brief tree data addressed by a handle (see KOW_CMD_RESOLVE), for a resolve acknowledgement the memory spec
+ * describes the data the handle addresses and there is no payload
+ */
+struct kowhai_protocol_handle_spec_t
+{
+    uint16_t handle;
+    struct kowhai_protocol_data_payload_memory_spec_t memory;
+};
+
+/**
+ * @brief a subscription to the data addressed by a handle, the server sends it in KOW_CMD_EVENT packets whose offset is
+ * the offset of the data in the tree data
+ */
+struct kowhai_protocol_subscribe_t
+{
+    uint16_t handle;    ///< the handle returned by KOW_CMD_RESOLVE_ACK
+    uint32_t period;    ///< server ticks between events, or 0 for an event whenever the data is written (not used to unsubscribe)
+    uint32_t window;    ///< for a period of 0 the server ticks from a write to the event, the writes in the window are
+                        ///< coalesced in to one event of the latest data (not used to unsubscribe)
 };
 
 /**
@@ -201,6 +315,8 @@ struct kowhai_protocol_event_t
 union kowhai_protocol_payload_spec_t
 {
     uint32_t version;
+    uint32_t packet_size;
+    uint32_t protocol_version;
     struct kowhai_protocol_id_list_t id_list;
     struct kowhai_protocol_data_payload_spec_t data;
     struct kowhai_protocol_descriptor_payload_spec_t descriptor;
@@ -208,6 +324,10 @@ union kowhai_protocol_payload_spec_t
     struct kowhai_protocol_function_call_t function_call;
     struct kowhai_protocol_event_t event;
     struct kowhai_protocol_string_list_t string_list;
+    struct kowhai_protocol_read_multi_t read_multi;
+    struct kowhai_protocol_write_multi_t write_multi;
+    struct kowhai_protocol_handle_spec_t handle;
+    struct kowhai_protocol_subscribe_t subscribe;
 };
 
 /**
@@ -241,6 +361,17 @@ struct kowhai_protocol_t
         protocol.header.id = id_;                                \
     }
 
+/**
+ * @brief set the request tag of a protocol, the server echoes it in each packet of the response so a client can have
+ * several requests in flight and match the responses (from KOW_PROTOCOL_VERSION_3)
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tag_, the request tag
+ */
+#define POPULATE_PROTOCOL_TAG(protocol, tag_)                    \
+    {                                                            \
+        protocol.header.tag = tag_;                              \
+    }
+
 /**
  * @brief format protocol to request reading the tree list
  * @param protocol, this is a kowhai_protocol_t struct used to make the request
@@ -318,6 +449,166 @@ struct kowhai_protocol_t
         protocol.header.id = 0;                            \
     }
 
+/**
+ * @brief format protocol to negotiate the packet size
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param packet_size_, the largest packet the client can handle
+ */
+#define POPULATE_PROTOCOL_SET_PACKET_SIZE(protocol, packet_size_)   \
+    {                                                               \
+        protocol.header.command = KOW_CMD_SET_PACKET_SIZE;          \
+        protocol.header.id = 0;                                     \
+        protocol.payload.spec.packet_size = packet_size_;           \
+    }
+
+/**
+ * @brief format protocol to negotiate the protocol version
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param protocol_version_, the newest protocol version the client can handle (ie KOW_PROTOCOL_VERSION)
+ */
+#define POPULATE_PROTOCOL_SET_PROTOCOL_VERSION(protocol, protocol_version_) \
+    {                                                                       \
+        protocol.header.command = KOW_CMD_SET_PROTOCOL_VERSION;             \
+        protocol.header.id = 0;                                             \
+        protocol.payload.spec.protocol_version = protocol_version_;         \
+    }
+
+/**
+ * @brief format protocol to request reading several nodes of a tree
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree to address this read to
+ * @param path_count_, the number of paths in the path list
+ * @param paths_, the path list (see kowhai_protocol_add_path)
+ * @param paths_size_, the bytes used by the path list
+ */
+#define POPULATE_PROTOCOL_READ_MULTI(protocol, tree_id_, path_count_, paths_, paths_size_)  \
+    {                                                                                       \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_READ_MULTI, tree_id_);                      \
+        protocol.payload.spec.read_multi.path_count = path_count_;                          \
+        protocol.payload.spec.read_multi.offset = 0;                                        \
+        protocol.payload.spec.read_multi.size = paths_size_;                                \
+        protocol.payload.buffer = paths_;                                                   \
+    }
+
+/**
+ * @brief format protocol to request reading several nodes of a tree by handle
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree to address this read to
+ * @param handle_count_, the number of handles in the handle list
+ * @param handles_, the handle list (uint16_t handles returned by KOW_CMD_RESOLVE_ACK)
+ */
+#define POPULATE_PROTOCOL_READ_MULTI_HANDLES(protocol, tree_id_, handle_count_, handles_)   \
+    {                                                                                       \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_READ_MULTI_HANDLES, tree_id_);              \
+        protocol.payload.spec.read_multi.path_count = handle_count_;                        \
+        protocol.payload.spec.read_multi.offset = 0;                                        \
+        protocol.payload.spec.read_multi.size = (handle_count_) * sizeof(uint16_t);         \
+        protocol.payload.buffer = handles_;                                                 \
+    }
+
+/**
+ * @brief format protocol to request writing several nodes of a tree in one step
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree to address this write to
+ * @param entry_count_, the number of writes in the write list
+ * @param entries_, the write list (see kowhai_protocol_add_write)
+ * @param entries_size_, the bytes used by the write list
+ */
+#define POPULATE_PROTOCOL_WRITE_MULTI(protocol, tree_id_, entry_count_, entries_, entries_size_) \
+    {                                                                                           \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_WRITE_MULTI, tree_id_);                         \
+        protocol.payload.spec.write_multi.entry_count = entry_count_;                           \
+        protocol.payload.spec.write_multi.size = entries_size_;                                 \
+        protocol.payload.buffer = entries_;                                                     \
+    }
+
+/**
+ * @brief format protocol to request resolving a symbol path to a handle
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree the symbol path belongs to
+ * @param symbol_count_, the number of symbols in the symbol path
+ * @param symbols_, the symbol path
+ */
+#define POPULATE_PROTOCOL_RESOLVE(protocol, tree_id_, symbol_count_, symbols_) \
+    POPULATE_PROTOCOL_READ(protocol, KOW_CMD_RESOLVE, tree_id_, symbol_count_, symbols_)
+
+/**
+ * @brief format protocol to request reading the data addressed by a handle
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree the handle was resolved in
+ * @param handle_, the handle returned by KOW_CMD_RESOLVE_ACK
+ */
+#define POPULATE_PROTOCOL_READ_HANDLE(protocol, tree_id_, handle_)  \
+    {                                                               \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_READ_HANDLE, tree_id_); \
+        protocol.payload.spec.handle.handle = handle_;              \
+    }
+
+/**
+ * @brief format protocol to request writing the data addressed by a handle
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param cmd, KOW_CMD_WRITE_HANDLE or KOW_CMD_WRITE_HANDLE_END (for the final packet of the write)
+ * @param tree_id_, the id of the tree the handle was resolved in
+ * @param handle_, the handle returned by KOW_CMD_RESOLVE_ACK
+ * @param data_type, the node type
+ * @param data_offset, offset of the bytes in the data the handle addresses
+ * @param data_size, number of bytes to write
+ * @param buffer_, the bytes to write
+ */
+#define POPULATE_PROTOCOL_WRITE_HANDLE(protocol, cmd, tree_id_, handle_, data_type, data_offset, data_size, buffer_) \
+    {                                                               \
+        POPULATE_PROTOCOL_CMD(protocol, cmd, tree_id_);             \
+        protocol.payload.spec.handle.handle = handle_;              \
+        protocol.payload.spec.handle.memory.type = data_type;       \
+        protocol.payload.spec.handle.memory.offset = data_offset;   \
+        protocol.payload.spec.handle.memory.size = data_size;       \
+        protocol.payload.buffer = buffer_;                          \
+    }
+
+/**
+ * @brief format protocol to request events of the data addressed by a handle
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree the handle was resolved in
+ * @param handle_, the handle returned by KOW_CMD_RESOLVE_ACK
+ * @param period_, server ticks between events, or 0 for an event whenever the data is written
+ */
+#define POPULATE_PROTOCOL_SUBSCRIBE(protocol, tree_id_, handle_, period_)   \
+    {                                                                       \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_SUBSCRIBE, tree_id_);       \
+        protocol.payload.spec.subscribe.handle = handle_;                   \
+        protocol.payload.spec.subscribe.period = period_;                   \
+        protocol.payload.spec.subscribe.window = 0;                         \
+    }
+
+/**
+ * @brief format protocol to request an event whenever the data addressed by a handle is written
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree the handle was resolved in
+ * @param handle_, the handle returned by KOW_CMD_RESOLVE_ACK
+ * @param window_, server ticks from a write to the event (the writes in the window are coalesced in to one event)
+ */
+#define POPULATE_PROTOCOL_SUBSCRIBE_ON_CHANGE(protocol, tree_id_, handle_, window_) \
+    {                                                                       \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_SUBSCRIBE, tree_id_);       \
+        protocol.payload.spec.subscribe.handle = handle_;                   \
+        protocol.payload.spec.subscribe.period = 0;                         \
+        protocol.payload.spec.subscribe.window = window_;                   \
+    }
+
+/**
+ * @brief format protocol to request stopping the events of a subscription
+ * @param protocol, this is a kowhai_protocol_t struct used to make the request
+ * @param tree_id_, the id of the tree the handle was resolved in
+ * @param handle_, the subscribed handle
+ */
+#define POPULATE_PROTOCOL_UNSUBSCRIBE(protocol, tree_id_, handle_)          \
+    {                                                                       \
+        POPULATE_PROTOCOL_CMD(protocol, KOW_CMD_UNSUBSCRIBE, tree_id_);     \
+        protocol.payload.spec.subscribe.handle = handle_;                   \
+        protocol.payload.spec.subscribe.period = 0;                         \
+        protocol.payload.spec.subscribe.window = 0;                         \
+    }
+
 #define KOW_TREE_ID(id) {id, 0}
 #define KOW_TREE_ID_FUNCTION_ONLY(id) {id, KOW_TREE_FOR_FUNCTION_CALL_ONLY}
 #define KOW_FUNCTION_ID(id) {id, 0}
@@ -335,6 +626,17 @@ struct kowhai_protocol_t
  */
 int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol);
 
+/**
+ * @brief Parse a packet of a given protocol version (see KOW_CMD_SET_PROTOCOL_VERSION), kowhai_protocol_parse parses
+ * KOW_PROTOCOL_VERSION_1 packets
+ * @param proto_packet a packet read over the protocol that needs parsing
+ * @param packet_size number of bytes in the proto_packet
+ * @param version the protocol version of the packet (KOW_PROTOCOL_VERSION_x)
+ * @param protocol update this with the information in the proto_packet
+ * @return KOW_STATUS_OK on success otherwise an error occurred
+ */
+int kowhai_protocol_parse2(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol);
+
 /**
  * @brief Create a new protocol packet used to communicate with another kowhai enabled program
  * @param proto_packet place the packet information into this buffer
@@ -345,6 +647,93 @@ int kowhai_protocol_parse(void* proto_packet, int packet_size, struct kowhai_pro
  */
 int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_protocol_t* protocol, int* bytes_required);
 
+/**
+ * @brief Create a packet of a given protocol version (see KOW_CMD_SET_PROTOCOL_VERSION), kowhai_protocol_create creates
+ * KOW_PROTOCOL_VERSION_1 packets
+ * @param proto_packet place the packet information into this buffer
+ * @param packet_size bytes allocated for the proto_packet
+ * @param version the protocol version of the packet (KOW_PROTOCOL_VERSION_x)
+ * @param protocol make the packet from the request info found in this structure
+ * @param bytes_required on KOW_STATUS_OK this contains the actual numbers of bytes used in proto_packet
+ * @return KOW_STATUS_OK on success, KOW_STATUS_INVALID_OFFSET if an offset or size does not fit the version otherwise
+ * an error occurred
+ */
+int kowhai_protocol_create2(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol, int* bytes_required);
+
+/**
+ * @brief Create the header and payload specification of a protocol packet but not the payload, so the payload can be
+ * sent from where it is (see kowhai_protocol_get_payload) without copying it in to the packet
+ * @param proto_packet place the packet header into this buffer
+ * @param packet_size bytes allocated for the proto_packet
+ * @param version the protocol version of the packet (KOW_PROTOCOL_VERSION_x)
+ * @param protocol make the packet from the request info found in this structure
+ * @param bytes_required on KOW_STATUS_OK this contains the actual numbers of bytes used in proto_packet
+ * @return KOW_STATUS_OK on success otherwise an error occurred
+ */
+int kowhai_protocol_create_header(void* proto_packet, int packet_size, int version, struct kowhai_protocol_t* protocol, int* bytes_required);
+
+/**
+ * @brief Get the payload that follows the header of a protocol packet
+ * @param protocol get the payload of this packet
+ * @param payload set to the payload buffer (NULL if the command has no payload)
+ * @param payload_size set to the number of payload bytes
+ * @return KOW_STATUS_OK on success otherwise an error occurred
+ */
+int kowhai_protocol_get_payload(struct kowhai_protocol_t* protocol, void** payload, int* payload_size);
+
+/**
+ * @brief Append a symbol path to a path list (a symbol count byte followed by the symbols for each path)
+ * @param paths the path list
+ * @param paths_size bytes allocated for the path list
+ * @param used bytes of the path list in use, this is updated
+ * @param symbol_count number of symbols in the path
+ * @param symbols the symbol path
+ * @return KOW_STATUS_OK on success, KOW_STATUS_PACKET_BUFFER_TOO_SMALL if the path does not fit
+ */
+int kowhai_protocol_add_path(void* paths, int paths_size, int* used, int symbol_count, const union kowhai_symbol_t* symbols);
+
+/**
+ * @brief Get the next symbol path of a path list
+ * @param paths the path list
+ * @param paths_size bytes of the path list
+ * @param position position of the next path in the path list (start with 0), this is updated
+ * @param symbol_count set to the number of symbols in the path
+ * @param symbols set to the symbol path (it points in to the path list)
+ * @return KOW_STATUS_OK on success, KOW_STATUS_NOT_FOUND at the end of the path list, KOW_STATUS_PACKET_BUFFER_TOO_SMALL
+ * if the path list is truncated
+ */
+int kowhai_protocol_next_path(void* paths, int paths_size, int* position, int* symbol_count, union kowhai_symbol_t** symbols);
+
+/**
+ * @brief Append a write to a write list (a symbol path as in a path list followed by a 32 bit offset, a 32 bit size and
+ * the bytes to write for each write)
+ * @param entries the write list
+ * @param entries_size bytes allocated for the write list
+ * @param used bytes of the write list in use, this is updated
+ * @param symbol_count number of symbols in the path
+ * @param symbols the symbol path of the node to write
+ * @param offset offset of the bytes in the node
+ * @param value the bytes to write
+ * @param size number of bytes to write
+ * @return KOW_STATUS_OK on success, KOW_STATUS_PACKET_BUFFER_TOO_SMALL if the write does not fit
+ */
+int kowhai_protocol_add_write(void* entries, int entries_size, int* used, int symbol_count, const union kowhai_symbol_t* symbols, int offset, const void* value, int size);
+
+/**
+ * @brief Get the next write of a write list
+ * @param entries the write list
+ * @param entries_size bytes of the write list
+ * @param position position of the next write in the write list (start with 0), this is updated
+ * @param symbol_count set to the number of symbols in the path
+ * @param symbols set to the symbol path (it points in to the write list)
+ * @param offset set to the offset of the bytes in the node
+ * @param value set to the bytes to write (it points in to the write list)
+ * @param size set to the number of bytes to write
+ * @return KOW_STATUS_OK on success, KOW_STATUS_NOT_FOUND at the end of the write list, KOW_STATUS_PACKET_BUFFER_TOO_SMALL
+ * if the write list is truncated
+ */
+int kowhai_protocol_next_write(void* entries, int entries_size, int* position, int* symbol_count, union kowhai_symbol_t** symbols, int* offset, void** value, int* size);
+
 /**
  * @brief Returkn the protocol overhead (header, payload specification etc, ie the meta part of the protocol that describes the payload)
  * @param protocol parse this for the overhead
@@ -352,5 +741,13 @@ int kowhai_protocol_create(void* proto_packet, int packet_size, struct kowhai_pr
  */
 int kowhai_protocol_get_overhead(struct kowhai_protocol_t* protocol, int* overhead);
 
+/**
+ * @brief Return the protocol overhead of a packet of a given protocol version (see kowhai_protocol_get_overhead)
+ * @param protocol parse this for the overhead
+ * @param version the protocol version of the packet (KOW_PROTOCOL_VERSION_x)
+ * @param overhead number of bytes taken up by the header, payload etc)
+ */
+int kowhai_protocol_get_overhead2(struct kowhai_protocol_t* protocol, int version, int* overhead);
+
 #endif
 
@@ -65,12 +65,19 @@ void kowhai_server_init(struct kowhai_protocol_server_t* server,
     kowhai_server_init_function_id_list(function_list, function_list_count, function_id_list);
 
     server->max_packet_size = max_packet_size;
+    kowhai_server_set_packet_size(server, max_packet_size);
+    kowhai_server_set_protocol_version(server, KOW_PROTOCOL_VERSION_1);
     server->packet_buffer = packet_buffer;
     server->node_pre_write = node_pre_write;
     server->node_post_write = node_post_write;
     server->node_write_param = node_write_param;
     server->send_packet = send_packet;
+    server->send_packet_vector = NULL;
     server->send_packet_param = send_packet_param;
+    server->flush_batch = NULL;
+    server->batch_buffer = NULL;
+    server->batch_size = 0;
+    server->batch_used = 0;
     server->tree_list_count = tree_list_count;
     server->tree_list = tree_list;
     server->tree_id_list = tree_id_list;
@@ -81,10 +88,84 @@ void kowhai_server_init(struct kowhai_protocol_server_t* server,
     server->function_called_param = function_called_param;
     server->symbol_list_count = symbol_list_count;
     server->symbol_list = symbol_list;
+    server->write_multi_items = NULL;
+    server->write_multi_item_count = 0;
+    server->handle_table = NULL;
+    server->handle_table_size = 0;
+    server->handle_count = 0;
+    server->subscription_table = NULL;
+    server->subscription_table_size = 0;
+    server->subscription_count = 0;
 
     server->current_write_node = NULL;
 }
 
+void kowhai_server_set_write_multi_items(struct kowhai_protocol_server_t* server, struct kowhai_batch_item_t* items, int item_count)
+{
+    server->write_multi_items = items;
+    server->write_multi_item_count = item_count;
+}
+
+void kowhai_server_set_handle_table(struct kowhai_protocol_server_t* server, struct kowhai_protocol_server_handle_t* handles, int handle_count)
+{
+    // handles are 16 bit on the wire
+    if (handle_count > 0x10000)
+        handle_count = 0x10000;
+    server->handle_table = handles;
+    server->handle_table_size = handle_count;
+    server->handle_count = 0;
+    // the subscriptions were of the old handles
+    server->subscription_count = 0;
+}
+
+void kowhai_server_set_subscription_table(struct kowhai_protocol_server_t* server, struct kowhai_protocol_server_subscription_t* subscriptions, int subscription_count)
+{
+    server->subscription_table = subscriptions;
+    server->subscription_table_size = subscription_count;
+    server->subscription_count = 0;
+}
+
+void kowhai_server_set_send_packet_vector(struct kowhai_protocol_server_t* server, kowhai_send_packet_vector_t send_packet_vector)
+{
+    server->send_packet_vector = send_packet_vector;
+}
+
+void kowhai_server_set_packet_size(struct kowhai_protocol_server_t* server, size_t packet_size)
+{
+    if (packet_size > server->max_packet_size)
+        packet_size = server->max_packet_size;
+    if (packet_size > KOW_PROTOCOL_MAX_PACKET_SIZE)
+        packet_size = KOW_PROTOCOL_MAX_PACKET_SIZE;
+    server->packet_size = packet_size;
+}
+
+void kowhai_server_set_protocol_version(struct kowhai_protocol_server_t* server, int protocol_version)
+{
+    if (protocol_version > KOW_PROTOCOL_VERSION)
+        protocol_version = KOW_PROTOCOL_VERSION;
+    server->protocol_version = protocol_version;
+}
+
+int kowhai_server_set_output_batch(struct kowhai_protocol_server_t* server, void* buffer, size_t buffer_size, kowhai_flush_batch_t flush_batch)
+{
+    if (flush_batch != NULL && buffer_size < server->max_packet_size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    kowhai_server_flush(server);
+    server->flush_batch = flush_batch;
+    server->batch_buffer = buffer;
+    server->batch_size = buffer_size;
+    return KOW_STATUS_OK;
+}
+
+void kowhai_server_flush(struct kowhai_protocol_server_t* server)
+{
+    if (server->batch_used == 0)
+        return;
+    server->flush_batch(server, server->send_packet_param, server->batch_buffer, server->batch_used);
+    server->batch_used = 0;
+}
+
+// find a served tree, the protocol only carries packed tree data so trees compiled with an aligned layout are not served
 int _get_tree_index(struct kowhai_protocol_server_t* server , uint16_t id, int* index)
 {
     int i = 0;
@@ -92,6 +173,11 @@ int _get_tree_index(struct kowhai_protocol_server_t* server , uint16_t id, int*
     {
         if (server->tree_list[i].list_id.id == id)
         {
+            if (kowhai_descriptor_layout(server->tree_list[i].descriptor) != KOW_LAYOUT_PACKED)
+            {
+                KOW_LOG("    tree %d is not packed\n", id);
+                return 0;
+            }
             *index = i;
             return 1;
         }
@@ -113,24 +199,410 @@ struct kowhai_tree_t _populate_tree(struct kowhai_protocol_server_t* server, uin
     return tree;
 }
 
-int _check_tree_id(struct kowhai_protocol_server_t* server, uint16_t id)
+// get the largest payload of each packet of a response, the client can set a packet size too small for the response
+// header (ie the echoed symbol path of a long path) so there might be no room for a payload at all
+int _get_max_payload_size(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot, int* overhead, int* max_payload_size)
+{
+    kowhai_protocol_get_overhead2(prot, server->protocol_version, overhead);
+    *max_payload_size = (int)server->packet_size - *overhead;
+    if (*max_payload_size <= 0)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    return KOW_STATUS_OK;
+}
+
+void _send_packet(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot)
+{
+    struct kowhai_iovec_t vector[2];
+    int bytes_required, payload_size;
+    void* payload;
+    // queue the packet in the output batch (flushing the batch first if a packet might not fit)
+    if (server->flush_batch != NULL)
+    {
+        if (server->batch_size - server->batch_used < server->packet_size)
+            kowhai_server_flush(server);
+        if (kowhai_protocol_create2((char*)server->batch_buffer + server->batch_used, server->packet_size, server->protocol_version, prot, &bytes_required) == KOW_STATUS_OK)
+            server->batch_used += bytes_required;
+        return;
+    }
+    kowhai_protocol_get_payload(prot, &payload, &payload_size);
+    // payloads already in the packet buffer are sent with the header in one buffer
+    if (server->send_packet_vector == NULL || payload_size == 0 ||
+        ((char*)payload >= (char*)server->packet_buffer && (char*)payload < (char*)server->packet_buffer + server->max_packet_size))
+    {
+        kowhai_protocol_create2(server->packet_buffer, server->max_packet_size, server->protocol_version, prot, &bytes_required);
+        server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
+        return;
+    }
+    // otherwise the payload is sent from where it is (ie tree data or a descriptor) without copying it
+    kowhai_protocol_create_header(server->packet_buffer, server->max_packet_size, server->protocol_version, prot, &bytes_required);
+    vector[0].base = server->packet_buffer;
+    vector[0].size = bytes_required;
+    vector[1].base = payload;
+    vector[1].size = payload_size;
+    server->send_packet_vector(server, server->send_packet_param, vector, 2, prot);
+}
+
+int _read_data(struct kowhai_tree_t* tree, struct kowhai_snapshot_t* snapshot, int zero_copy, int node_offset, struct kowhai_protocol_t* prot)
+{
+    // send unprotected tree data straight from the tree
+    if (zero_copy)
+    {
+        prot->payload.buffer = (char*)tree->data + node_offset + prot->payload.spec.data.memory.offset;
+        return KOW_STATUS_OK;
+    }
+    if (snapshot != NULL)
+        return kowhai_snapshot_read(snapshot, node_offset + prot->payload.spec.data.memory.offset, prot->payload.buffer, prot->payload.spec.data.memory.size);
+    return kowhai_read(tree, prot->payload.spec.data.symbols.count, prot->payload.spec.data.symbols.array_, prot->payload.spec.data.memory.offset, prot->payload.buffer, prot->payload.spec.data.memory.size);
+}
+
+// resolve a symbol path in to the handle table (a path already in the table keeps its handle)
+int _resolve_handle(struct kowhai_protocol_server_t* server, uint16_t tree_id, int num_symbols, union kowhai_symbol_t* symbols, int* handle)
+{
+    struct kowhai_protocol_server_handle_t entry;
+    int i, status;
+    entry.tree_id = tree_id;
+    entry.tree = _populate_tree(server, tree_id);
+    if (entry.tree.data == NULL)
+        return KOW_STATUS_NO_DATA;
+    status = kowhai_resolve(&entry.tree, num_symbols, symbols, &entry.handle);
+    if (status != KOW_STATUS_OK)
+        return status;
+    for (i = 0; i < server->handle_count; i++)
+    {
+        struct kowhai_protocol_server_handle_t* item = &server->handle_table[i];
+        if (item->tree_id == tree_id && item->handle.node == entry.handle.node &&
+            item->handle.offset == entry.handle.offset && item->handle.count == entry.handle.count)
+        {
+            *handle = i;
+            return KOW_STATUS_OK;
+        }
+    }
+    if (server->handle_count == server->handle_table_size)
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    *handle = server->handle_count++;
+    server->handle_table[*handle] = entry;
+    server->handle_table[*handle].handle.tree = &server->handle_table[*handle].tree;
+    return KOW_STATUS_OK;
+}
+
+// get a resolved path from the handle table (NULL if the handle was not resolved in this tree)
+struct kowhai_protocol_server_handle_t* _get_handle(struct kowhai_protocol_server_t* server, uint16_t tree_id, uint16_t handle)
+{
+    if (handle >= server->handle_count || server->handle_table[handle].tree_id != tree_id)
+        return NULL;
+    return &server->handle_table[handle];
+}
+
+int _read_handle(struct kowhai_handle_t* handle, struct kowhai_snapshot_t* snapshot, int zero_copy, struct kowhai_protocol_t* prot)
+{
+    // send unprotected tree data straight from the tree
+    if (zero_copy)
+    {
+        prot->payload.buffer = (char*)handle->tree->data + handle->offset + prot->payload.spec.handle.memory.offset;
+        return KOW_STATUS_OK;
+    }
+    if (snapshot != NULL)
+        return kowhai_snapshot_read(snapshot, handle->offset + prot->payload.spec.handle.memory.offset, prot->payload.buffer, prot->payload.spec.handle.memory.size);
+    return kowhai_handle_read(handle, prot->payload.spec.handle.memory.offset, prot->payload.buffer, prot->payload.spec.handle.memory.size);
+}
+
+// get the entry of the next handle of a read multi handle list
+struct kowhai_protocol_server_handle_t* _next_read_multi_handle(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot, void* handles, int* position)
+{
+    uint16_t handle;
+    memcpy(&handle, (char*)handles + *position, sizeof(uint16_t));
+    *position += sizeof(uint16_t);
+    return _get_handle(server, prot->header.id, handle);
+}
+
+// get the total size of the values of a read multi path or handle list (checking each path or handle)
+int _get_read_multi_size(struct kowhai_protocol_server_t* server, struct kowhai_tree_t* tree, struct kowhai_protocol_t* prot, int* size)
+{
+    int position = 0, path_count = 0, symbol_count, node_offset, path_size, status;
+    union kowhai_symbol_t* symbols;
+    struct kowhai_node_t* node;
+    *size = 0;
+    if (prot->header.command == KOW_CMD_READ_MULTI_HANDLES)
+    {
+        // the handles were checked when they were resolved, they just have to still be in the handle table
+        if (prot->payload.spec.read_multi.size != prot->payload.spec.read_multi.path_count * sizeof(uint16_t))
+            return KOW_STATUS_NODE_DATA_TOO_SMALL;
+        while (position < (int)prot->payload.spec.read_multi.size)
+        {
+            struct kowhai_protocol_server_handle_t* entry = _next_read_multi_handle(server, prot, prot->payload.buffer, &position);
+            if (entry == NULL)
+                return KOW_STATUS_NOT_FOUND;
+            *size += entry->handle.element_size * entry->handle.count;
+        }
+        return KOW_STATUS_OK;
+    }
+    while ((status = kowhai_protocol_next_path(prot->payload.buffer, prot->payload.spec.read_multi.size, &position, &symbol_count, &symbols)) == KOW_STATUS_OK)
+    {
+        status = kowhai_get_node(tree->desc, symbol_count, symbols, &node_offset, &node);
+        if (status == KOW_STATUS_OK)
+            status = kowhai_get_path_size(node, symbol_count, symbols, &path_size);
+        if (status != KOW_STATUS_OK)
+            return status;
+        *size += path_size;
+        path_count++;
+    }
+    if (status != KOW_STATUS_NOT_FOUND || path_count != prot->payload.spec.read_multi.path_count)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    return KOW_STATUS_OK;
+}
+
+// send the values of a read multi path or handle list (checked by _get_read_multi_size) packed in to as few packets as
+// possible
+int _send_read_multi(struct kowhai_protocol_server_t* server, struct kowhai_tree_t* tree, struct kowhai_protocol_t* prot, int size)
+{
+    void* paths = prot->payload.buffer;
+    int paths_size = prot->payload.spec.read_multi.size;
+    int handles = prot->header.command == KOW_CMD_READ_MULTI_HANDLES;
+    int position = 0, symbol_count = 0, node_offset = 0, path_offset = 0, path_size = 0;
+    int overhead, max_payload_size, payload_size, used, read_size;
+    union kowhai_symbol_t* symbols = NULL;
+    struct kowhai_node_t* node;
+    struct kowhai_protocol_server_handle_t* entry = NULL;
+    struct kowhai_snapshot_t* snapshot = NULL;
+    // get protocol overhead and max payload size
+    prot->header.command = KOW_CMD_READ_MULTI_ACK;
+    if (_get_max_payload_size(server, prot, &overhead, &max_payload_size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    // setup payload offset
+    prot->payload.spec.read_multi.offset = 0;
+    prot->payload.buffer = (char*)server->packet_buffer + overhead;
+    // all the packets are read from one snapshot if the tree has an idle kowhai_snapshot_t
+    if (size > max_payload_size)
+    {
+        snapshot = kowhai_snapshot_get(tree->data);
+        if (snapshot != NULL && kowhai_snapshot_begin(snapshot) != KOW_STATUS_OK)
+            snapshot = NULL;
+    }
+    // send packets
+    do
+    {
+        payload_size = size > max_payload_size ? max_payload_size : size;
+        // fill the payload with the values of the paths, a value can continue in the next packet
+        for (used = 0; used < payload_size; used += read_size)
+        {
+            if (path_offset == path_size)
+            {
+                if (handles)
+                {
+                    entry = _next_read_multi_handle(server, prot, paths, &position);
+                    node_offset = entry->handle.offset;
+                    path_size = entry->handle.element_size * entry->handle.count;
+                }
+                else
+                {
+                    kowhai_protocol_next_path(paths, paths_size, &position, &symbol_count, &symbols);
+                    kowhai_get_node(tree->desc, symbol_count, symbols, &node_offset, &node);
+                    kowhai_get_path_size(node, symbol_count, symbols, &path_size);
+                }
+                path_offset = 0;
+            }
+            read_size = path_size - path_offset;
+            if (read_size > payload_size - used)
+                read_size = payload_size - used;
+            if (snapshot != NULL)
+                kowhai_snapshot_read(snapshot, node_offset + path_offset, (char*)prot->payload.buffer + used, read_size);
+            else if (handles)
+                kowhai_handle_read(&entry->handle, path_offset, (char*)prot->payload.buffer + used, read_size);
+            else
+                kowhai_read(tree, symbol_count, symbols, path_offset, (char*)prot->payload.buffer + used, read_size);
+            path_offset += read_size;
+        }
+        size -= payload_size;
+        if (size == 0)
+            prot->header.command = KOW_CMD_READ_MULTI_ACK_END;
+        prot->payload.spec.read_multi.size = (uint32_t)payload_size;
+        _send_packet(server, prot);
+        // increment payload offset
+        prot->payload.spec.read_multi.offset += payload_size;
+    }
+    while (size > 0);
+    if (snapshot != NULL)
+        kowhai_snapshot_end(snapshot);
+    return KOW_STATUS_OK;
+}
+
+// get the writes of a write multi request in to the server write multi items (checking each write, writes that
+// overlap an earlier one are refused as the batch would apply them in no defined order)
+int _get_write_multi_items(struct kowhai_protocol_server_t* server, struct kowhai_tree_t* tree, struct kowhai_protocol_t* prot, int* item_count)
+{
+    int position = 0, node_offset, path_size, status, i;
+    struct kowhai_batch_item_t item;
+    struct kowhai_node_t* node;
+    *item_count = 0;
+    while ((status = kowhai_protocol_next_write(prot->payload.buffer, prot->payload.spec.write_multi.size, &position,
+        &item.num_symbols, &item.symbols, &item.offset, &item.buffer, &item.size)) == KOW_STATUS_OK)
+    {
+        if (*item_count == server->write_multi_item_count)
+            return KOW_STATUS_NODE_DATA_TOO_SMALL;
+        status = kowhai_get_node(tree->desc, item.num_symbols, item.symbols, &node_offset, &node);
+        if (status == KOW_STATUS_OK)
+            status = kowhai_get_path_size(node, item.num_symbols, item.symbols, &path_size);
+        if (status != KOW_STATUS_OK)
+            return status;
+        if (item.offset > path_size || item.size > path_size - item.offset)
+            return KOW_STATUS_NODE_DATA_TOO_SMALL;
+        item.data_offset = node_offset + item.offset;
+        for (i = 0; i < *item_count && item.size > 0; i++)
+        {
+            struct kowhai_batch_item_t* earlier = &server->write_multi_items[i];
+            if (earlier->size > 0 && item.data_offset < earlier->data_offset + earlier->size && earlier->data_offset < item.data_offset + item.size)
+                return KOW_STATUS_NODE_DATA_TOO_SMALL;
+        }
+        server->write_multi_items[(*item_count)++] = item;
+    }
+    if (status != KOW_STATUS_NOT_FOUND || *item_count != prot->payload.spec.write_multi.entry_count)
+        return KOW_STATUS_NODE_DATA_TOO_SMALL;
+    return KOW_STATUS_OK;
+}
+
+// apply the writes of a write multi request (checked by _get_write_multi_items) as one write, calling node_pre_write
+// for every write before and node_post_write for every write after (both in request order)
+int _write_multi(struct kowhai_protocol_server_t* server, struct kowhai_tree_t* tree, struct kowhai_protocol_t* prot, int item_count)
+{
+    struct kowhai_batch_item_t* items = server->write_multi_items;
+    struct kowhai_batch_item_t item;
+    struct kowhai_node_t* node;
+    int i, position = 0, node_offset, status;
+    if (server->node_pre_write)
+    {
+        for (i = 0; i < item_count; i++)
+        {
+            kowhai_get_node(tree->desc, items[i].num_symbols, items[i].symbols, &node_offset, &node);
+            server->node_pre_write(server, server->node_write_param, prot->header.id, node, node_offset);
+        }
+    }
+    status = kowhai_write_batch(tree, item_count, items);
+    if (status != KOW_STATUS_OK)
+        return status;
+    // the batch sorts the items in to tree data order so walk the request again
+    if (server->node_post_write)
+    {
+        while (kowhai_protocol_next_write(prot->payload.buffer, prot->payload.spec.write_multi.size, &position,
+            &item.num_symbols, &item.symbols, &item.offset, &item.buffer, &item.size) == KOW_STATUS_OK)
+        {
+            kowhai_get_node(tree->desc, item.num_symbols, item.symbols, &node_offset, &node);
+            server->node_post_write(server, server->node_write_param, prot->header.id, node, node_offset, item.offset + item.size);
+        }
+    }
+    return KOW_STATUS_OK;
+}
+
+// check the offsets of a size byte payload fit the negotiated protocol version (so they do not wrap)
+int _check_payload_size(struct kowhai_protocol_server_t* server, int size)
+{
+    if (server->protocol_version < KOW_PROTOCOL_VERSION_2 && size > 0xFFFF)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    return KOW_STATUS_OK;
+}
+
+// get the subscription index of a handle (-1 if the handle is not subscribed)
+int _get_subscription(struct kowhai_protocol_server_t* server, uint16_t handle)
 {
     int i;
-    for (i = 0; i < server->tree_list_count; i++)
+    for (i = 0; i < server->subscription_count; i++)
     {
-        if (server->tree_list[i].list_id.id == id)
-            return 1;
+        if (server->subscription_table[i].handle == handle)
+            return i;
     }
-    return 0;
+    return -1;
+}
+
+// add or update the subscription of a handle
+int _subscribe(struct kowhai_protocol_server_t* server, uint16_t tree_id, uint16_t handle, uint32_t period, uint32_t window)
+{
+    struct kowhai_protocol_server_handle_t* entry;
+    struct kowhai_protocol_server_subscription_t* subscription;
+    struct kowhai_dirty_t* dirty;
+    int index;
+    entry = _get_handle(server, tree_id, handle);
+    if (entry == NULL)
+        return KOW_STATUS_NOT_FOUND;
+    // changes are found with the tree change tracker
+    dirty = kowhai_handle_dirty(&entry->handle);
+    if (period == 0 && dirty == NULL)
+        return KOW_STATUS_INVALID_PROTOCOL_COMMAND;
+    index = _get_subscription(server, handle);
+    if (index < 0)
+    {
+        if (server->subscription_count == server->subscription_table_size)
+            return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+        index = server->subscription_count++;
+    }
+    subscription = &server->subscription_table[index];
+    subscription->handle = handle;
+    subscription->period = period;
+    subscription->window = window;
+    subscription->elapsed = 0;
+    subscription->pending = 0;
+    subscription->generation = dirty != NULL ? dirty->generation : 0;
+    return KOW_STATUS_OK;
+}
+
+// check if any leaf of the data addressed by a handle was written after a generation
+int _handle_written(struct kowhai_dirty_t* dirty, uint32_t since, struct kowhai_handle_t* handle)
+{
+    return kowhai_dirty_changed(dirty, since, handle->offset, handle->element_size * handle->count);
+}
+
+// send the data addressed by a handle as an event (read from one snapshot if it needs several packets)
+int _send_handle_event(struct kowhai_protocol_server_t* server, struct kowhai_protocol_server_handle_t* entry)
+{
+    int size = entry->handle.element_size * entry->handle.count;
+    int offset = 0, overhead, max_payload_size, payload_size;
+    struct kowhai_snapshot_t* snapshot = NULL;
+    struct kowhai_protocol_t prot;
+    // larger events need KOW_PROTOCOL_VERSION_2
+    if (_check_payload_size(server, entry->handle.offset + size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    prot.header.command = KOW_CMD_EVENT;
+    prot.header.id = entry->tree_id;
+    prot.header.tag = 0;
+    if (_get_max_payload_size(server, &prot, &overhead, &max_payload_size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    prot.payload.buffer = (char*)server->packet_buffer + overhead;
+    if (size > max_payload_size)
+    {
+        snapshot = kowhai_snapshot_get(entry->tree.data);
+        if (snapshot != NULL && kowhai_snapshot_begin(snapshot) != KOW_STATUS_OK)
+            snapshot = NULL;
+    }
+    // send packets
+    do
+    {
+        payload_size = size - offset > max_payload_size ? max_payload_size : size - offset;
+        if (offset + payload_size == size)
+            prot.header.command = KOW_CMD_EVENT_END;
+        prot.payload.spec.event.offset = (uint32_t)(entry->handle.offset + offset);
+        prot.payload.spec.event.size = (uint32_t)payload_size;
+        if (snapshot != NULL)
+            kowhai_snapshot_read(snapshot, entry->handle.offset + offset, prot.payload.buffer, payload_size);
+        else
+            kowhai_handle_read(&entry->handle, offset, prot.payload.buffer, payload_size);
+        _send_packet(server, &prot);
+        offset += payload_size;
+    }
+    while (offset < size);
+    if (snapshot != NULL)
+        kowhai_snapshot_end(snapshot);
+    return KOW_STATUS_OK;
+}
+
+int _check_tree_id(struct kowhai_protocol_server_t* server, uint16_t id)
+{
+    int index;
+    return _get_tree_index(server, id, &index);
 }
 
 void _invalid_tree_id(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot)
 {
-    int bytes_required;
     KOW_LOG("    invalid tree id (%d)\n", prot->header.id);
     prot->header.command = KOW_CMD_ERROR_INVALID_TREE_ID;
-    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, prot, &bytes_required);
-    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
+    _send_packet(server, prot);
 }
 
 int _get_function_index(struct kowhai_protocol_server_t* server , uint16_t id, int* index)
@@ -148,18 +620,17 @@ int _get_function_index(struct kowhai_protocol_server_t* server , uint16_t id, i
     return 0;
 }
 
-void _send_id_list(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot,
+int _send_id_list(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot,
                     uint8_t cmd_ack, uint8_t cmd_ack_end,
                     int id_list_count, struct kowhai_protocol_id_list_item_t* id_list)
 {
-    int bytes_required;
     int overhead, max_payload_size;
     int size = id_list_count * sizeof(struct kowhai_protocol_id_list_item_t);
-    // get protocol overhead
+    // get protocol overhead and max payload size
     prot->header.command = cmd_ack;
-    kowhai_protocol_get_overhead(prot, &overhead);
-    // setup max payload size and payload offset
-    max_payload_size = server->max_packet_size - overhead;
+    if (_get_max_payload_size(server, prot, &overhead, &max_payload_size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    // setup payload offset
     prot->payload.spec.id_list.offset = 0;
     prot->payload.spec.id_list.list_count = (uint16_t)id_list_count;
     // send packets
@@ -167,8 +638,7 @@ void _send_id_list(struct kowhai_protocol_server_t* server, struct kowhai_protoc
     {
         prot->payload.spec.id_list.size = (uint16_t)max_payload_size;
         prot->payload.buffer = (char*)id_list + prot->payload.spec.id_list.offset;
-        kowhai_protocol_create(server->packet_buffer, server->max_packet_size, prot, &bytes_required);
-        server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
+        _send_packet(server, prot);
         // increment payload offset and decrement remaining payload size
         prot->payload.spec.id_list.offset += (uint16_t)max_payload_size;
         size -= max_payload_size;
@@ -177,8 +647,8 @@ void _send_id_list(struct kowhai_protocol_server_t* server, struct kowhai_protoc
     prot->header.command = cmd_ack_end;
     prot->payload.spec.id_list.size = (uint16_t)size;
     prot->payload.buffer = (char*)id_list + prot->payload.spec.id_list.offset;
-    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, prot, &bytes_required);
-    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
+    _send_packet(server, prot);
+    return KOW_STATUS_OK;
 }
 
 size_t _get_string_list_size(char** list, int count)
@@ -216,18 +686,17 @@ void _copy_string_list_to_buffer(char** string_list, int count, int offset, void
     }
 }
 
-void _send_string_list(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot,
+int _send_string_list(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot,
                     uint8_t cmd_ack, uint8_t cmd_ack_end,
                     int string_list_count, char** string_list)
 {
-    int bytes_required;
     int overhead, max_payload_size;
     int size = _get_string_list_size(string_list, string_list_count);
-    // get protocol overhead
+    // get protocol overhead and max payload size
     prot->header.command = cmd_ack;
-    kowhai_protocol_get_overhead(prot, &overhead);
-    // setup max payload size and payload offset
-    max_payload_size = server->max_packet_size - overhead;
+    if (_get_max_payload_size(server, prot, &overhead, &max_payload_size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    // setup payload offset
     prot->payload.spec.string_list.offset = 0;
     prot->payload.spec.string_list.list_count = (uint16_t)string_list_count;
     prot->payload.spec.string_list.list_total_size = size;
@@ -237,8 +706,7 @@ void _send_string_list(struct kowhai_protocol_server_t* server, struct kowhai_pr
     {
         prot->payload.spec.string_list.size = (uint16_t)max_payload_size;
         _copy_string_list_to_buffer(string_list, string_list_count, prot->payload.spec.string_list.offset, prot->payload.buffer, max_payload_size);
-        kowhai_protocol_create(server->packet_buffer, server->max_packet_size, prot, &bytes_required);
-        server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
+        _send_packet(server, prot);
         // increment payload offset and decrement remaining payload size
         prot->payload.spec.string_list.offset += (uint16_t)max_payload_size;
         size -= max_payload_size;
@@ -247,8 +715,8 @@ void _send_string_list(struct kowhai_protocol_server_t* server, struct kowhai_pr
     prot->header.command = cmd_ack_end;
     prot->payload.spec.string_list.size = (uint16_t)size;
     _copy_string_list_to_buffer(string_list, string_list_count, prot->payload.spec.string_list.offset, prot->payload.buffer, max_payload_size);
-    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, prot, &bytes_required);
-    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, prot);
+    _send_packet(server, prot);
+    return KOW_STATUS_OK;
 }
 
 void _set_error_cmd(struct kowhai_protocol_t* prot, int status)
@@ -264,6 +732,7 @@ void _set_error_cmd(struct kowhai_protocol_t* prot, int status)
             prot->header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_OFFSET;
             break;
         case KOW_STATUS_NODE_DATA_TOO_SMALL:
+        case KOW_STATUS_PACKET_BUFFER_TOO_BIG:
             KOW_LOG("    invalid payload size\n");
             prot->header.command = KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE;
             break;
@@ -275,6 +744,14 @@ void _set_error_cmd(struct kowhai_protocol_t* prot, int status)
             KOW_LOG("    no tree data\n");
             prot->header.command = KOW_CMD_ERROR_NO_DATA;
             break;
+        case KOW_STATUS_NOT_FOUND:
+            KOW_LOG("    invalid handle\n");
+            prot->header.command = KOW_CMD_ERROR_INVALID_HANDLE;
+            break;
+        case KOW_STATUS_TARGET_BUFFER_TOO_SMALL:
+            KOW_LOG("    handle table full\n");
+            prot->header.command = KOW_CMD_ERROR_HANDLE_TABLE_FULL;
+            break;
         default:
             KOW_LOG("    unknown error\n");
             prot->header.command = KOW_CMD_ERROR_UNKNOWN;
@@ -285,7 +762,7 @@ void _set_error_cmd(struct kowhai_protocol_t* prot, int status)
 int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void* packet, size_t packet_size)
 {
     struct kowhai_protocol_t prot;
-    int bytes_required, status;
+    int status;
 
     if (packet_size > server->max_packet_size)
     {
@@ -293,13 +770,13 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
         return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
     }
 
-    status = kowhai_protocol_parse(packet, packet_size, &prot);
+    status = kowhai_protocol_parse2(packet, packet_size, server->protocol_version, &prot);
     if (status != KOW_STATUS_OK && status != KOW_STATUS_INVALID_PROTOCOL_COMMAND)
     {
         KOW_LOG("    ERROR: invalid protocol command\n");
         prot.header.command = KOW_CMD_ERROR_INVALID_COMMAND;
-        kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-        server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+        _send_packet(server, &prot);
+        kowhai_server_flush(server);
         return status;
     }
 
@@ -309,14 +786,48 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             KOW_LOG("    CMD get version\n");
             prot.header.command = KOW_CMD_GET_VERSION_ACK;
             prot.payload.spec.version = kowhai_version();
-            kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-            server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
+            break;
+        case KOW_CMD_SET_PACKET_SIZE:
+            KOW_LOG("    CMD set packet size\n");
+            if (prot.payload.spec.packet_size < KOW_PROTOCOL_MIN_PACKET_SIZE)
+            {
+                _set_error_cmd(&prot, KOW_STATUS_NODE_DATA_TOO_SMALL);
+                _send_packet(server, &prot);
+                break;
+            }
+            // use the largest packet both ends can handle from the next response on
+            kowhai_server_set_packet_size(server, prot.payload.spec.packet_size);
+            prot.header.command = KOW_CMD_SET_PACKET_SIZE_ACK;
+            prot.payload.spec.packet_size = (uint32_t)server->packet_size;
+            _send_packet(server, &prot);
+            break;
+        case KOW_CMD_SET_PROTOCOL_VERSION:
+            KOW_LOG("    CMD set protocol version\n");
+            if (prot.payload.spec.protocol_version < KOW_PROTOCOL_VERSION_1)
+            {
+                POPULATE_PROTOCOL_CMD(prot, KOW_CMD_ERROR_INVALID_COMMAND, prot.header.id);
+                _send_packet(server, &prot);
+                break;
+            }
+            // use the newest version both ends can handle, the acknowledgement is sent in the previous version as the
+            // client does not know the version until it is received
+            prot.header.command = KOW_CMD_SET_PROTOCOL_VERSION_ACK;
+            if (prot.payload.spec.protocol_version > KOW_PROTOCOL_VERSION)
+                prot.payload.spec.protocol_version = KOW_PROTOCOL_VERSION;
+            _send_packet(server, &prot);
+            kowhai_server_set_protocol_version(server, (int)prot.payload.spec.protocol_version);
             break;
         case KOW_CMD_GET_TREE_LIST:
         case KOW_CMD_GET_TREE_LIST_ACK_END:
-            _send_id_list(server, &prot,
+            status = _send_id_list(server, &prot,
                 KOW_CMD_GET_TREE_LIST_ACK, KOW_CMD_GET_TREE_LIST_ACK_END,
                 server->tree_list_count, server->tree_id_list);
+            if (status != KOW_STATUS_OK)
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+            }
             break;
         case KOW_CMD_WRITE_DATA:
         case KOW_CMD_WRITE_DATA_END:
@@ -375,8 +886,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                     // send response
                     prot.header.command = KOW_CMD_WRITE_DATA_ACK;
                     kowhai_read(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
-                    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                    _send_packet(server, &prot);
                     break;
                 }
             }
@@ -384,8 +894,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             server->current_write_node = NULL;
             // send error response
             _set_error_cmd(&prot, status);
-            kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-            server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
             break;
         }
         case KOW_CMD_READ_DATA:
@@ -394,6 +903,8 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             int node_offset;
             int size, overhead, max_payload_size;
             struct kowhai_node_t* node;
+            struct kowhai_snapshot_t* snapshot = NULL;
+            int zero_copy;
             struct kowhai_protocol_symbol_spec_t symbols = prot.payload.spec.data.symbols;
             KOW_LOG("    CMD read data\n");
             if (!_check_tree_id(server, prot.header.id))
@@ -409,47 +920,285 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             else
                 // get node information
                 status = kowhai_get_node(tree.desc, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, &node_offset, &node);
+            // get the bytes to send (from the addressed array item to the end of the node or slice)
+            if (status == KOW_STATUS_OK)
+                status = kowhai_get_path_size(node, symbols.count, symbols.array_, &size);
+            // larger nodes need KOW_PROTOCOL_VERSION_2
+            if (status == KOW_STATUS_OK)
+                status = _check_payload_size(server, size);
             if (status == KOW_STATUS_OK)
             {
-                union kowhai_symbol_t last_sym = symbols.array_[symbols.count-1];
-                kowhai_get_node_size(node, &size);
-                if (node->count > 1)
-                    size = size - size / node->count * last_sym.parts.array_index;
-                // get protocol overhead
+                // get protocol overhead and max payload size
                 prot.header.command = KOW_CMD_READ_DATA_ACK;
-                kowhai_protocol_get_overhead(&prot, &overhead);
-                // setup max payload size and payload offset
-                max_payload_size = server->max_packet_size - overhead;
+                status = _get_max_payload_size(server, &prot, &overhead, &max_payload_size);
+            }
+            if (status == KOW_STATUS_OK)
+            {
+                // setup payload offset
                 prot.payload.spec.data.memory.offset = 0;
                 prot.payload.spec.data.memory.type = node->type;
                 // set payload buffer pointer
                 // (this will make a part of the kowhai_protocol_create call redundant
                 // but we do not need to allocate any memory at least)
                 prot.payload.buffer = (char*)server->packet_buffer + overhead;
+                // kowhai_read retries torn reads if the tree has a kowhai_seqlock_t so each packet holds consistent
+                // data, and if the tree has an idle kowhai_snapshot_t all the packets are read from one snapshot
+                if (size > max_payload_size)
+                {
+                    snapshot = kowhai_snapshot_get(tree.data);
+                    if (snapshot != NULL && kowhai_snapshot_begin(snapshot) != KOW_STATUS_OK)
+                        snapshot = NULL;
+                }
+                // data that is not protected by a kowhai_seqlock_t can be sent without copying it
+                zero_copy = server->send_packet_vector != NULL && snapshot == NULL && kowhai_seqlock_get(tree.data) == NULL;
                 // send packets
                 while (size > max_payload_size)
                 {
-                    prot.payload.spec.data.memory.size = (uint16_t)max_payload_size;
-                    kowhai_read(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
-                    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                    prot.payload.spec.data.memory.size = (uint32_t)max_payload_size;
+                    _read_data(&tree, snapshot, zero_copy, node_offset, &prot);
+                    _send_packet(server, &prot);
                     // increment payload offset and decrement remaining payload size
-                    prot.payload.spec.data.memory.offset += (uint16_t)max_payload_size;
+                    prot.payload.spec.data.memory.offset += max_payload_size;
                     size -= max_payload_size;
                 }
                 // send final packet
                 prot.header.command = KOW_CMD_READ_DATA_ACK_END;
-                prot.payload.spec.data.memory.size = (uint16_t)size;
-                kowhai_read(&tree, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
-                kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                prot.payload.spec.data.memory.size = (uint32_t)size;
+                _read_data(&tree, snapshot, zero_copy, node_offset, &prot);
+                _send_packet(server, &prot);
+                if (snapshot != NULL)
+                    kowhai_snapshot_end(snapshot);
+            }
+            else
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+            }
+            break;
+        }
+        case KOW_CMD_READ_MULTI:
+        case KOW_CMD_READ_MULTI_HANDLES:
+        {
+            struct kowhai_tree_t tree;
+            int size;
+            KOW_LOG("    CMD read multi\n");
+            if (!_check_tree_id(server, prot.header.id))
+            {
+                _invalid_tree_id(server, &prot);
+                break;
+            }
+            // init tree helper struct
+            tree = _populate_tree(server, prot.header.id);
+            // check all the paths before sending anything
+            if (tree.data == NULL)
+                status = KOW_STATUS_NO_DATA;
+            else
+                status = _get_read_multi_size(server, &tree, &prot, &size);
+            if (status == KOW_STATUS_OK)
+                status = _check_payload_size(server, size);
+            if (status == KOW_STATUS_OK)
+                status = _send_read_multi(server, &tree, &prot, size);
+            if (status != KOW_STATUS_OK)
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+            }
+            break;
+        }
+        case KOW_CMD_WRITE_MULTI:
+        {
+            struct kowhai_tree_t tree;
+            int item_count;
+            KOW_LOG("    CMD write multi\n");
+            if (!_check_tree_id(server, prot.header.id))
+            {
+                _invalid_tree_id(server, &prot);
+                break;
+            }
+            // init tree helper struct
+            tree = _populate_tree(server, prot.header.id);
+            // check all the writes before applying any (a write data sequence must not be in progress)
+            if (tree.data == NULL)
+                status = KOW_STATUS_NO_DATA;
+            else if (server->current_write_node != NULL)
+                status = KOW_STATUS_INVALID_SEQUENCE;
+            else
+                status = _get_write_multi_items(server, &tree, &prot, &item_count);
+            if (status == KOW_STATUS_OK)
+                status = _write_multi(server, &tree, &prot, item_count);
+            if (status == KOW_STATUS_OK)
+            {
+                prot.header.command = KOW_CMD_WRITE_MULTI_ACK;
+                prot.payload.spec.write_multi.size = 0;
+                prot.payload.buffer = NULL;
+            }
+            else
+                _set_error_cmd(&prot, status);
+            _send_packet(server, &prot);
+            break;
+        }
+        case KOW_CMD_RESOLVE:
+        {
+            struct kowhai_handle_t* handle;
+            int index;
+            KOW_LOG("    CMD resolve\n");
+            if (!_check_tree_id(server, prot.header.id))
+            {
+                _invalid_tree_id(server, &prot);
+                break;
+            }
+            status = _resolve_handle(server, prot.header.id, prot.payload.spec.data.symbols.count, prot.payload.spec.data.symbols.array_, &index);
+            if (status == KOW_STATUS_OK)
+            {
+                // return the handle and the data it addresses (from the addressed array item to the end of the node or slice)
+                handle = &server->handle_table[index].handle;
+                prot.header.command = KOW_CMD_RESOLVE_ACK;
+                prot.payload.spec.handle.handle = (uint16_t)index;
+                prot.payload.spec.handle.memory.type = handle->node->type;
+                prot.payload.spec.handle.memory.offset = 0;
+                prot.payload.spec.handle.memory.size = (uint32_t)(handle->element_size * handle->count);
+                prot.payload.buffer = NULL;
             }
             else
+                _set_error_cmd(&prot, status);
+            _send_packet(server, &prot);
+            break;
+        }
+        case KOW_CMD_READ_HANDLE:
+        {
+            struct kowhai_protocol_server_handle_t* entry;
+            int size, overhead, max_payload_size;
+            struct kowhai_snapshot_t* snapshot = NULL;
+            int zero_copy;
+            KOW_LOG("    CMD read handle\n");
+            // the path was resolved by KOW_CMD_RESOLVE so there is nothing to look up
+            entry = _get_handle(server, prot.header.id, prot.payload.spec.handle.handle);
+            if (entry == NULL)
+                status = KOW_STATUS_NOT_FOUND;
+            else
+            {
+                size = entry->handle.element_size * entry->handle.count;
+                status = _check_payload_size(server, size);
+            }
+            if (status == KOW_STATUS_OK)
+            {
+                // get protocol overhead and max payload size
+                prot.header.command = KOW_CMD_READ_HANDLE_ACK;
+                status = _get_max_payload_size(server, &prot, &overhead, &max_payload_size);
+            }
+            if (status != KOW_STATUS_OK)
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+                break;
+            }
+            // setup payload offset
+            prot.payload.spec.handle.memory.type = entry->handle.node->type;
+            prot.payload.spec.handle.memory.offset = 0;
+            prot.payload.buffer = (char*)server->packet_buffer + overhead;
+            // read consistent packets as for KOW_CMD_READ_DATA
+            if (size > max_payload_size)
+            {
+                snapshot = kowhai_snapshot_get(entry->tree.data);
+                if (snapshot != NULL && kowhai_snapshot_begin(snapshot) != KOW_STATUS_OK)
+                    snapshot = NULL;
+            }
+            zero_copy = server->send_packet_vector != NULL && snapshot == NULL && kowhai_handle_seqlock(&entry->handle) == NULL;
+            // send packets
+            while (size > max_payload_size)
+            {
+                prot.payload.spec.handle.memory.size = (uint32_t)max_payload_size;
+                _read_handle(&entry->handle, snapshot, zero_copy, &prot);
+                _send_packet(server, &prot);
+                // increment payload offset and decrement remaining payload size
+                prot.payload.spec.handle.memory.offset += max_payload_size;
+                size -= max_payload_size;
+            }
+            // send final packet
+            prot.header.command = KOW_CMD_READ_HANDLE_ACK_END;
+            prot.payload.spec.handle.memory.size = (uint32_t)size;
+            _read_handle(&entry->handle, snapshot, zero_copy, &prot);
+            _send_packet(server, &prot);
+            if (snapshot != NULL)
+                kowhai_snapshot_end(snapshot);
+            break;
+        }
+        case KOW_CMD_WRITE_HANDLE:
+        case KOW_CMD_WRITE_HANDLE_END:
+        {
+            struct kowhai_protocol_server_handle_t* entry;
+            KOW_LOG("    CMD write handle\n");
+            // check/set current write node (like KOW_CMD_WRITE_DATA)
+            entry = _get_handle(server, prot.header.id, prot.payload.spec.handle.handle);
+            status = entry != NULL ? KOW_STATUS_OK : KOW_STATUS_NOT_FOUND;
+            if (entry != NULL && server->current_write_node != NULL)
+            {
+                if (entry->handle.node != server->current_write_node)
+                    status = KOW_STATUS_INVALID_SEQUENCE;
+            }
+            else if (entry != NULL)
+            {
+                server->current_write_node = entry->handle.node;
+                server->current_write_node_offset = entry->handle.offset;
+                server->current_write_node_bytes_written = 0;
+                if (server->node_pre_write)
+                    server->node_pre_write(server, server->node_write_param, prot.header.id, server->current_write_node, server->current_write_node_offset);
+            }
+            // write to tree
+            if (status == KOW_STATUS_OK)
+                status = kowhai_handle_write(&entry->handle, prot.payload.spec.handle.memory.offset, prot.payload.buffer, prot.payload.spec.handle.memory.size);
+            if (status == KOW_STATUS_OK)
             {
+                int bytes_written = prot.payload.spec.handle.memory.offset + prot.payload.spec.handle.memory.size;
+                if (bytes_written > server->current_write_node_bytes_written)
+                    server->current_write_node_bytes_written = bytes_written;
+                if (prot.header.command == KOW_CMD_WRITE_HANDLE_END)
+                {
+                    if (server->node_post_write)
+                        server->node_post_write(server, server->node_write_param, prot.header.id, server->current_write_node, server->current_write_node_offset, server->current_write_node_bytes_written);
+                    server->current_write_node = NULL;
+                }
+                // send response
+                prot.header.command = KOW_CMD_WRITE_HANDLE_ACK;
+                kowhai_handle_read(&entry->handle, prot.payload.spec.handle.memory.offset, prot.payload.buffer, prot.payload.spec.handle.memory.size);
+                _send_packet(server, &prot);
+                break;
+            }
+            // clear current write node if error encountered
+            server->current_write_node = NULL;
+            _set_error_cmd(&prot, status);
+            _send_packet(server, &prot);
+            break;
+        }
+        case KOW_CMD_SUBSCRIBE:
+            KOW_LOG("    CMD subscribe\n");
+            status = _subscribe(server, prot.header.id, prot.payload.spec.subscribe.handle, prot.payload.spec.subscribe.period, prot.payload.spec.subscribe.window);
+            if (status == KOW_STATUS_OK)
+                prot.header.command = KOW_CMD_SUBSCRIBE_ACK;
+            else if (status == KOW_STATUS_TARGET_BUFFER_TOO_SMALL)
+                prot.header.command = KOW_CMD_ERROR_SUBSCRIPTION_TABLE_FULL;
+            else if (status == KOW_STATUS_INVALID_PROTOCOL_COMMAND)
+                // on change subscriptions need a kowhai_dirty_t
+                prot.header.command = KOW_CMD_ERROR_INVALID_COMMAND;
+            else
                 _set_error_cmd(&prot, status);
-                kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
+            break;
+        case KOW_CMD_UNSUBSCRIBE:
+        {
+            int index;
+            KOW_LOG("    CMD unsubscribe\n");
+            if (_get_handle(server, prot.header.id, prot.payload.spec.subscribe.handle) == NULL ||
+                (index = _get_subscription(server, prot.payload.spec.subscribe.handle)) < 0)
+            {
+                _set_error_cmd(&prot, KOW_STATUS_NOT_FOUND);
+                _send_packet(server, &prot);
+                break;
             }
+            // move the last subscription in to the gap
+            server->subscription_table[index] = server->subscription_table[--server->subscription_count];
+            prot.header.command = KOW_CMD_UNSUBSCRIBE_ACK;
+            _send_packet(server, &prot);
             break;
         }
         case KOW_CMD_READ_DESCRIPTOR:
@@ -467,38 +1216,51 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             // get descriptor size
             _get_tree_index(server, prot.header.id, &index);
             size = server->tree_list[index].descriptor_size;
-            // get protocol overhead
-            prot.header.command = KOW_CMD_READ_DESCRIPTOR_ACK;
-            kowhai_protocol_get_overhead(&prot, &overhead);
-            // setup max payload size and payload offset
-            max_payload_size = server->max_packet_size - overhead;
+            // larger descriptors need KOW_PROTOCOL_VERSION_2
+            status = _check_payload_size(server, size);
+            if (status == KOW_STATUS_OK)
+            {
+                // get protocol overhead and max payload size
+                prot.header.command = KOW_CMD_READ_DESCRIPTOR_ACK;
+                status = _get_max_payload_size(server, &prot, &overhead, &max_payload_size);
+            }
+            if (status != KOW_STATUS_OK)
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+                break;
+            }
+            // setup payload offset
             prot.payload.spec.descriptor.offset = 0;
             prot.payload.spec.descriptor.node_count = size / sizeof(struct kowhai_node_t);
             // send packets
             while (size > max_payload_size)
             {
-                prot.payload.spec.descriptor.size = (uint16_t)max_payload_size;
+                prot.payload.spec.descriptor.size = (uint32_t)max_payload_size;
                 prot.payload.buffer = (char*)tree.desc + prot.payload.spec.descriptor.offset;
-                kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                _send_packet(server, &prot);
                 // increment payload offset and decrement remaining payload size
-                prot.payload.spec.descriptor.offset += (uint16_t)max_payload_size;
+                prot.payload.spec.descriptor.offset += max_payload_size;
                 size -= max_payload_size;
             }
             // send final packet
             prot.header.command = KOW_CMD_READ_DESCRIPTOR_ACK_END;
-            prot.payload.spec.descriptor.size = (uint16_t)size;
+            prot.payload.spec.descriptor.size = (uint32_t)size;
             prot.payload.buffer = (char*)tree.desc + prot.payload.spec.descriptor.offset;
-            kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-            server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
             break;
         }
         case KOW_CMD_GET_FUNCTION_LIST:
         {
             KOW_LOG("    CMD get function list\n");
-            _send_id_list(server, &prot,
+            status = _send_id_list(server, &prot,
                 KOW_CMD_GET_FUNCTION_LIST_ACK, KOW_CMD_GET_FUNCTION_LIST_ACK_END,
                 server->function_list_count, server->function_id_list);
+            if (status != KOW_STATUS_OK)
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+            }
             break;
         }
         case KOW_CMD_GET_FUNCTION_DETAILS:
@@ -516,8 +1278,7 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
             prot.payload.buffer = NULL;
 
             // send packet
-            kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-            server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
             break;
         }
         case KOW_CMD_CALL_FUNCTION:
@@ -572,31 +1333,35 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                                     int size, overhead, max_payload_size;
                                     KOW_LOG("        send return tree\n");
                                     prot.header.command = KOW_CMD_CALL_FUNCTION_RESULT;
-                                    kowhai_protocol_get_overhead(&prot, &overhead);
                                     // setup size
                                     kowhai_get_node_size(tree.desc, &size);
-                                    // setup max payload size and payload offset
-                                    max_payload_size = server->max_packet_size - overhead;
+                                    // larger results need KOW_PROTOCOL_VERSION_2
+                                    if (_check_payload_size(server, size) != KOW_STATUS_OK ||
+                                        _get_max_payload_size(server, &prot, &overhead, &max_payload_size) != KOW_STATUS_OK)
+                                    {
+                                        _set_error_cmd(&prot, KOW_STATUS_PACKET_BUFFER_TOO_BIG);
+                                        _send_packet(server, &prot);
+                                        break;
+                                    }
+                                    // setup payload offset
                                     prot.payload.spec.function_call.offset = 0;
-                                    prot.payload.spec.function_call.size = (uint16_t)max_payload_size;
+                                    prot.payload.spec.function_call.size = (uint32_t)max_payload_size;
                                     prot.payload.buffer = tree.data;
                                     // send packets
                                     while (size > max_payload_size)
                                     {
-                                        prot.payload.spec.function_call.size = (uint16_t)max_payload_size;
+                                        prot.payload.spec.function_call.size = (uint32_t)max_payload_size;
                                         prot.payload.buffer = (char*)tree.data + prot.payload.spec.function_call.offset;
-                                        kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                                        server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                                        _send_packet(server, &prot);
                                         // increment payload offset and decrement remaining payload size
-                                        prot.payload.spec.function_call.offset += (uint16_t)max_payload_size;
+                                        prot.payload.spec.function_call.offset += max_payload_size;
                                         size -= max_payload_size;
                                     }
                                     // send final packet
                                     prot.header.command = KOW_CMD_CALL_FUNCTION_RESULT_END;
-                                    prot.payload.spec.function_call.size = (uint16_t)size;
+                                    prot.payload.spec.function_call.size = (uint32_t)size;
                                     prot.payload.buffer = (char*)tree.data + prot.payload.spec.function_call.offset;
-                                    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-                                    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+                                    _send_packet(server, &prot);
                                     break;
                                 }
                                 else
@@ -628,57 +1393,122 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
                 KOW_LOG("        cant find function index\n");
             }
             // send packet
-            kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-            server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
             break;
         }
         case KOW_CMD_GET_SYMBOL_LIST:
         {
             KOW_LOG("    CMD get symbol list\n");
-            _send_string_list(server, &prot,
+            status = _send_string_list(server, &prot,
                 KOW_CMD_GET_SYMBOL_LIST_ACK, KOW_CMD_GET_SYMBOL_LIST_ACK_END,
                 server->symbol_list_count, server->symbol_list);
+            if (status != KOW_STATUS_OK)
+            {
+                _set_error_cmd(&prot, status);
+                _send_packet(server, &prot);
+            }
             break;
         }
         default:
             KOW_LOG("    invalid command (%d)\n", prot.header.command);
             POPULATE_PROTOCOL_CMD(prot, KOW_CMD_ERROR_INVALID_COMMAND, prot.header.id);
-            kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-            server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+            _send_packet(server, &prot);
             break;
     }
 
+    // send the whole response at once if it was batched
+    kowhai_server_flush(server);
     return KOW_STATUS_OK;
 }
 
 int kowhai_server_process_event(struct kowhai_protocol_server_t* server, uint16_t tree_id, void* buffer, int buffer_size)
 {
-    int overhead, max_payload_size, bytes_required;
+    int overhead, max_payload_size;
     struct kowhai_protocol_t prot;
     KOW_LOG("process event\n");
+    // larger events need KOW_PROTOCOL_VERSION_2
+    if (_check_payload_size(server, buffer_size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
     prot.header.command = KOW_CMD_EVENT;
     prot.header.id = tree_id;
-    kowhai_protocol_get_overhead(&prot, &overhead);
-    // setup max payload size and payload offset
-    max_payload_size = server->max_packet_size - overhead;
+    prot.header.tag = 0;
+    if (_get_max_payload_size(server, &prot, &overhead, &max_payload_size) != KOW_STATUS_OK)
+        return KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    // setup payload offset
     prot.payload.spec.event.offset = 0;
     prot.payload.buffer = buffer;
     // send packets
     while (buffer_size > max_payload_size)
     {
-        prot.payload.spec.event.size = (uint16_t)max_payload_size;
+        prot.payload.spec.event.size = (uint32_t)max_payload_size;
         prot.payload.buffer = (char*)buffer + prot.payload.spec.event.offset;
-        kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-        server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+        _send_packet(server, &prot);
         // increment payload offset and decrement remaining payload size
-        prot.payload.spec.event.offset += (uint16_t)max_payload_size;
+        prot.payload.spec.event.offset += max_payload_size;
         buffer_size -= max_payload_size;
     }
     // send final packet
     prot.header.command = KOW_CMD_EVENT_END;
-    prot.payload.spec.event.size = (uint16_t)buffer_size;
+    prot.payload.spec.event.size = (uint32_t)buffer_size;
     prot.payload.buffer = (char*)buffer + prot.payload.spec.event.offset;
-    kowhai_protocol_create(server->packet_buffer, server->max_packet_size, &prot, &bytes_required);
-    server->send_packet(server, server->send_packet_param, server->packet_buffer, bytes_required, &prot);
+    _send_packet(server, &prot);
+    kowhai_server_flush(server);
     return KOW_STATUS_OK;
 }
+
+int kowhai_server_tick(struct kowhai_protocol_server_t* server, uint32_t ticks)
+{
+    int i, status = KOW_STATUS_OK;
+    for (i = 0; i < server->subscription_count; i++)
+    {
+        struct kowhai_protocol_server_subscription_t* subscription = &server->subscription_table[i];
+        struct kowhai_protocol_server_handle_t* entry = &server->handle_table[subscription->handle];
+        if (subscription->period == 0)
+        {
+            // send on change, once the window after the first write has passed (so the writes in the window are
+            // coalesced in to one event of the latest data)
+            struct kowhai_dirty_t* dirty = kowhai_handle_dirty(&entry->handle);
+            uint32_t since = subscription->generation;
+            if (subscription->pending)
+                subscription->elapsed += ticks;
+            if (dirty != NULL && dirty->generation != since)
+            {
+                subscription->generation = dirty->generation;
+                if (!subscription->pending && _handle_written(dirty, since, &entry->handle))
+                {
+                    subscription->pending = 1;
+                    subscription->elapsed = 0;
+                }
+            }
+            if (!subscription->pending || subscription->elapsed < subscription->window)
+                continue;
+            subscription->pending = 0;
+        }
+        else
+        {
+            // send once per period (late ticks do not send a burst of events)
+            subscription->elapsed += ticks;
+            if (subscription->elapsed < subscription->period)
+                continue;
+            subscription->elapsed %= subscription->period;
+        }
+        KOW_LOG("subscription event\n");
+        if (_send_handle_event(server, entry) != KOW_STATUS_OK)
+            status = KOW_STATUS_PACKET_BUFFER_TOO_BIG;
+    }
+    kowhai_server_flush(server);
+    return status;
+}
+
+int kowhai_server_watch(struct kowhai_protocol_server_t* server, uint16_t tree_id, int num_symbols, union kowhai_symbol_t* symbols, uint32_t window)
+{
+    int handle;
+    int status = _resolve_handle(server, tree_id, num_symbols, symbols, &handle);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = _subscribe(server, tree_id, (uint16_t)handle, 0, window);
+    // a tree without a change tracker can not be watched
+    if (status == KOW_STATUS_INVALID_PROTOCOL_COMMAND)
+        return KOW_STATUS_NO_DATA;
+    return status;
+}
@@ -17,6 +17,35 @@ typedef struct kowhai_protocol_server_t* pkowhai_protocol_server_t;
  */
 typedef void (*kowhai_send_packet_t)(pkowhai_protocol_server_t server, void* param, void* packet, size_t packet_size, struct kowhai_protocol_t* protocol);
 
+/**
+ * @brief a buffer that is part of a packet, see kowhai_send_packet_vector_t
+ */
+struct kowhai_iovec_t
+{
+    const void* base;
+    size_t size;
+};
+
+/**
+ * @brief callback used to send a kowhai packet made up of several buffers (ie with writev or sendmsg) so payloads
+ * that live in tree data or descriptors are sent without being copied in to the packet buffer first
+ * @param server the protocol server object
+ * @param param application specific parameter passed through (the send_packet_param)
+ * @param vector the buffers to write out in order, the first holds the packet header
+ * @param vector_count number of buffers in vector
+ * @param protocol pointer to the protocol object that generated the packet
+ */
+typedef void (*kowhai_send_packet_vector_t)(pkowhai_protocol_server_t server, void* param, const struct kowhai_iovec_t* vector, int vector_count, struct kowhai_protocol_t* protocol);
+
+/**
+ * @brief callback used to send a batch of kowhai packets (written back to back) in one go, see kowhai_server_set_output_batch
+ * @param server the protocol server object
+ * @param param application specific parameter passed through (the send_packet_param)
+ * @param buffer the packets to write out
+ * @param buffer_size bytes in the buffer
+ */
+typedef void (*kowhai_flush_batch_t)(pkowhai_protocol_server_t server, void* param, void* buffer, size_t buffer_size);
+
 /**
  * @brief called before node has been written via the kowhai protocol
  * @param server the protocol server object
@@ -61,15 +90,45 @@ struct kowhai_protocol_server_function_item_t
     struct kowhai_protocol_function_details_t details;
 };
 
+/**
+ * @brief a symbol path resolved by KOW_CMD_RESOLVE, see kowhai_server_set_handle_table
+ */
+struct kowhai_protocol_server_handle_t
+{
+    uint16_t tree_id;
+    struct kowhai_tree_t tree;
+    struct kowhai_handle_t handle;      ///< handle.tree points to tree above
+};
+
+/**
+ * @brief a KOW_CMD_SUBSCRIBE subscription, see kowhai_server_set_subscription_table
+ */
+struct kowhai_protocol_server_subscription_t
+{
+    uint16_t handle;                    ///< the subscribed handle
+    uint32_t period;                    ///< ticks between events (0 to send an event when the data is written)
+    uint32_t window;                    ///< ticks from a write to the event (on change subscriptions only)
+    uint32_t elapsed;                   ///< ticks since the last event (or since the first write of the window)
+    uint32_t generation;                ///< kowhai_dirty_t generation the data was last checked at
+    int pending;                        ///< a write is waiting for the end of the window
+};
+
 struct kowhai_protocol_server_t
 {
     size_t max_packet_size;
+    size_t packet_size;
+    int protocol_version;
     void* packet_buffer;
     kowhai_node_pre_write_t node_pre_write;
     kowhai_node_post_write_t node_post_write;
     void* node_write_param;
     kowhai_send_packet_t send_packet;
+    kowhai_send_packet_vector_t send_packet_vector;
     void* send_packet_param;
+    kowhai_flush_batch_t flush_batch;
+    void* batch_buffer;
+    size_t batch_size;
+    size_t batch_used;
     int tree_list_count;
     struct kowhai_protocol_server_tree_item_t* tree_list;
     struct kowhai_protocol_id_list_item_t* tree_id_list;
@@ -80,6 +139,14 @@ struct kowhai_protocol_server_t
     void* function_called_param;
     int symbol_list_count;
     char** symbol_list;
+    struct kowhai_batch_item_t* write_multi_items;
+    int write_multi_item_count;
+    struct kowhai_protocol_server_handle_t* handle_table;
+    int handle_table_size;
+    int handle_count;
+    struct kowhai_protocol_server_subscription_t* subscription_table;
+    int subscription_table_size;
+    int subscription_count;
 
     struct kowhai_node_t* current_write_node;
     int current_write_node_offset;
@@ -105,6 +172,80 @@ void kowhai_server_init(struct kowhai_protocol_server_t* server,
     int symbol_list_count,
     char** symbol_list);
 
+/**
+ * @brief set the size of the packets sent by the server (the packets are split to fit), this is max_packet_size after
+ * kowhai_server_init and is renegotiated by clients with KOW_CMD_SET_PACKET_SIZE, so a server serving several
+ * connections should set it (ie to the size of a legacy client) when a connection is opened
+ * @param server configuration for this server
+ * @param packet_size the packet size, it is limited to max_packet_size and KOW_PROTOCOL_MAX_PACKET_SIZE
+ */
+void kowhai_server_set_packet_size(struct kowhai_protocol_server_t* server, size_t packet_size);
+
+/**
+ * @brief set the protocol version of the packets parsed and sent by the server, this is KOW_PROTOCOL_VERSION_1 after
+ * kowhai_server_init and is renegotiated by clients with KOW_CMD_SET_PROTOCOL_VERSION (like the packet size it should
+ * be reset when a connection is opened)
+ * @param server configuration for this server
+ * @param protocol_version the protocol version (KOW_PROTOCOL_VERSION_x), it is limited to KOW_PROTOCOL_VERSION
+ */
+void kowhai_server_set_protocol_version(struct kowhai_protocol_server_t* server, int protocol_version);
+
+/**
+ * @brief set the items used to apply KOW_CMD_WRITE_MULTI requests, a request with more writes than there are items
+ * is refused (there are none after kowhai_server_init, so write multi requests are refused until this is called)
+ * @param server configuration for this server
+ * @param items holds the writes of a request while it is checked and applied, this should be the server connection's
+ * own buffer (like the packet buffer)
+ * @param item_count number of items
+ */
+void kowhai_server_set_write_multi_items(struct kowhai_protocol_server_t* server, struct kowhai_batch_item_t* items, int item_count);
+
+/**
+ * @brief set the table of handles returned by KOW_CMD_RESOLVE (and addressed by KOW_CMD_READ_HANDLE and
+ * KOW_CMD_WRITE_HANDLE), the table is emptied so the handles of a previous connection are no longer valid. There is no
+ * table after kowhai_server_init, so resolve requests are refused until this is called.
+ * @param server configuration for this server
+ * @param handles holds the resolved paths, this should be the server connection's own buffer (like the packet buffer)
+ * @param handle_count number of handles the table holds (a resolve request is refused once the table is full)
+ */
+void kowhai_server_set_handle_table(struct kowhai_protocol_server_t* server, struct kowhai_protocol_server_handle_t* handles, int handle_count);
+
+/**
+ * @brief set the table of KOW_CMD_SUBSCRIBE subscriptions, the table is emptied (as it is when the handle table is set)
+ * There is no table after kowhai_server_init, so subscribe requests are refused until this is called.
+ * @param server configuration for this server
+ * @param subscriptions holds the subscriptions, this should be the server connection's own buffer (like the packet buffer)
+ * @param subscription_count number of subscriptions the table holds
+ */
+void kowhai_server_set_subscription_table(struct kowhai_protocol_server_t* server, struct kowhai_protocol_server_subscription_t* subscriptions, int subscription_count);
+
+/**
+ * @brief send packets whose payload is outside the packet buffer with a vector callback instead of copying the
+ * payload in to the packet buffer and calling send_packet
+ * @param server configuration for this server
+ * @param send_packet_vector the vector send callback (it is passed the send_packet_param), or NULL to always use send_packet
+ */
+void kowhai_server_set_send_packet_vector(struct kowhai_protocol_server_t* server, kowhai_send_packet_vector_t send_packet_vector);
+
+/**
+ * @brief queue the packets of each response in an output batch and send them with one flush_batch call at the end of
+ * kowhai_server_process_packet/kowhai_server_process_event (or sooner if the batch fills), instead of one send_packet
+ * call per packet. Payloads are copied in to the batch so send_packet_vector is not used while batching.
+ * @note the packets are written back to back so the transport must preserve the byte stream (ie tcp)
+ * @param server configuration for this server
+ * @param buffer holds the batch, this should be the server connection's own buffer (like the packet buffer)
+ * @param buffer_size size of buffer, it must hold at least max_packet_size bytes
+ * @param flush_batch the batch send callback (it is passed the send_packet_param), or NULL to stop batching
+ * @return KOW_STATUS_OK on success, KOW_STATUS_TARGET_BUFFER_TOO_SMALL if buffer_size is smaller than max_packet_size
+ */
+int kowhai_server_set_output_batch(struct kowhai_protocol_server_t* server, void* buffer, size_t buffer_size, kowhai_flush_batch_t flush_batch);
+
+/**
+ * @brief send any packets queued in the output batch
+ * @param server configuration for this server
+ */
+void kowhai_server_flush(struct kowhai_protocol_server_t* server);
+
 /**
  * @brief Parse a kowhai packet and perform requested commands
  * @param server configuration for this server
@@ -118,8 +259,37 @@ int kowhai_server_process_packet(struct kowhai_protocol_server_t* server, void*
  * @param tree_id the tree id (the description of the data contained in this event)
  * @param buffer the event data buffer
  * @param buffer_size the size of the buffer
+ * @return KOW_STATUS_OK on success, KOW_STATUS_PACKET_BUFFER_TOO_BIG if the event is larger than 64 KB and the protocol
+ * version is older than KOW_PROTOCOL_VERSION_2
  */
 int kowhai_server_process_event(struct kowhai_protocol_server_t* server, uint16_t tree_id, void* buffer, int buffer_size);
 
+/**
+ * @brief advance the subscriptions and send KOW_CMD_EVENT packets for the subscriptions that are due, ie whose period
+ * has elapsed or (for a period of 0) whose window has passed since their data was written. Each event holds the data
+ * addressed by the subscribed handle and its offsets are those of the data in the tree data. On change subscriptions
+ * need a kowhai_dirty_t tracking the tree. Call this from the thread that processes the connection packets.
+ * @param server configuration for this server
+ * @param ticks the time since the last tick, in the units of the subscription periods (ie milliseconds)
+ * @return KOW_STATUS_OK on success, KOW_STATUS_PACKET_BUFFER_TOO_BIG if an event did not fit the protocol version
+ * (see kowhai_server_process_event)
+ */
+int kowhai_server_tick(struct kowhai_protocol_server_t* server, uint32_t ticks);
+
+/**
+ * @brief send events whenever a node changes without a client subscribing to it, ie an on change KOW_CMD_SUBSCRIBE
+ * made by the application. The tree needs a kowhai_dirty_t, which kowhai_write, kowhai_set_xxx etc (and so the write
+ * commands) mark, and the events are sent by kowhai_server_tick. The path takes a slot in the handle and subscription
+ * tables (watch again after the tables are set).
+ * @param server configuration for this server
+ * @param tree_id the tree of the node
+ * @param num_symbols number of symbols in the symbol path
+ * @param symbols the symbol path of the node
+ * @param window ticks from a write to the event, the writes in the window are coalesced in to one event of the latest data
+ * @return KOW_STATUS_OK on success, KOW_STATUS_NO_DATA if the tree has no data or no change tracker,
+ * KOW_STATUS_TARGET_BUFFER_TOO_SMALL if a table is full or other on error
+ */
+int kowhai_server_watch(struct kowhai_protocol_server_t* server, uint16_t tree_id, int num_symbols, union kowhai_symbol_t* symbols, uint32_t window);
+
 
 #endif
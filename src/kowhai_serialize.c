@@ -137,205 +137,168 @@ int add_value(char** dest, size_t* dest_size, int* current_offset, uint16_t node
     return chars;
 }
 
-int serialize_tree(struct kowhai_node_t** desc, void** data, char* target_buffer, size_t target_size, int level, void* get_name_param, kowhai_get_symbol_name_t get_name, int in_union, int* largest_data_field)
+// the output of serialize_tree
+struct serialize_tree_walk_t
 {
-    int target_offset = 0;
-    struct kowhai_node_t* node;
+    char* target_buffer;
+    size_t target_size;
+    int target_offset;
+    void* get_name_param;
+    kowhai_get_symbol_name_t get_name;
+};
+
+// write the node a walk is at
+static int serialize_tree_visit(void* param, struct kowhai_walk_t *walk)
+{
+    struct serialize_tree_walk_t *ser = (struct serialize_tree_walk_t*)param;
+    const struct kowhai_node_t* node = walk->node;
     int i, chars;
     char* node_end_str;
 
-    while (1)
+    switch (walk->event)
     {
-        node = *desc;
-
-        if (node->type == KOW_BRANCH_END)
-            return target_offset;
-
-        // indent to current level using tabs
-        chars = add_indent(&target_buffer, &target_size, &target_offset, level);
-        if (chars < 0)
-            return chars;
-
-        //
-        // write node
-        //
-
-        switch (node->type)
-        {
-            case KOW_BRANCH_START:
-            case KOW_BRANCH_U_START:
+        case KOW_WALK_BRANCH_START:
+            if (walk->index == 0)
             {
-                int node_is_union = node->type == KOW_BRANCH_U_START;
-                int largest_child_data_field = 0;
-                void* initial_data = *data;
+                // indent to current level using tabs
+                chars = add_indent(&ser->target_buffer, &ser->target_size, &ser->target_offset, walk->depth);
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
                 // write header
-                chars = add_header(&target_buffer, &target_size, &target_offset, node, get_name_param, get_name);
+                chars = add_header(&ser->target_buffer, &ser->target_size, &ser->target_offset, (struct kowhai_node_t*)node, ser->get_name_param, ser->get_name);
                 if (chars < 0)
-                    return chars;
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                // write array or children identifier
                 if (node->count > 1)
-                {
-                    struct kowhai_node_t* initial_node = *desc;
-                    // write array identifier
-                    chars = add_string(&target_buffer, &target_size, &target_offset, ", \""ARRAY"\": [\n");
-                    if (chars < 0)
-                    return chars;
-                    for (i = 0; i < node->count; i++)
-                    {
-                        // set descriptor to initial node at the branch array
-                        *desc = initial_node;
-                        (*desc) += 1;
-                        // indent to current level using tab
-                        chars = add_indent(&target_buffer, &target_size, &target_offset, level + 1);
-                        if (chars < 0)
-                            return chars;
-                        // write branch children start
-                        chars = add_string(&target_buffer, &target_size, &target_offset, "[\n");
-                        if (chars < 0)
-                            return chars;
-                        // write branch children
-                        chars = serialize_tree(desc, data, target_buffer, target_size, level + 1, get_name_param, get_name, node_is_union, &largest_child_data_field);
-                        if (chars < 0)
-                            return chars;
-                        target_offset += chars;
-                        target_buffer += chars;
-                        target_size -= chars;
-                        // increment data pointer if node is a union
-                        if (node_is_union)
-                        {
-                            *data = (char*)initial_data + largest_child_data_field;
-                            initial_data = *data;
-                        }
-                        // indent to current level using tab
-                        chars = add_indent(&target_buffer, &target_size, &target_offset, level + 1);
-                        if (chars < 0)
-                            return chars;
-                        // write branch children end
-                        chars = add_string(&target_buffer, &target_size, &target_offset, "]");
-                        if (chars < 0)
-                            return chars;
-                        if (i < node->count - 1)
-                        {
-                            chars = add_string(&target_buffer, &target_size, &target_offset, ",\n");
-                            if (chars < 0)
-                                return chars;
-                        }
-                        else
-                        {
-                            chars = add_string(&target_buffer, &target_size, &target_offset, "\n");
-                            if (chars < 0)
-                                return chars;
-                        }
-                    }
-                }
+                    chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, ", \""ARRAY"\": [\n");
                 else
-                {
-                    // write children identifier
-                    chars = add_string(&target_buffer, &target_size, &target_offset, ", \""CHILDREN"\": [\n");
-                    if (chars < 0)
-                        return chars;
-                    // write branch children
-                    (*desc) += 1;
-                    chars = serialize_tree(desc, data, target_buffer, target_size, level + 1, get_name_param, get_name, node_is_union, &largest_child_data_field);
-                    if (chars < 0)
-                        return chars;
-                    target_offset += chars;
-                    target_buffer += chars;
-                    target_size -= chars;
-                    // increment data pointer if node is a union
-                    if (node_is_union)
-                        *data = (char*)initial_data + largest_child_data_field;
-                }
-                // indent to current level using tab
-                chars = add_indent(&target_buffer, &target_size, &target_offset, level);
+                    chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, ", \""CHILDREN"\": [\n");
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            }
+            if (node->count > 1)
+            {
+                // write branch array item start
+                chars = add_indent(&ser->target_buffer, &ser->target_size, &ser->target_offset, walk->depth + 1);
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, "[\n");
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            }
+            break;
+
+        case KOW_WALK_BRANCH_END:
+            if (node->count > 1)
+            {
+                // write branch array item end
+                chars = add_indent(&ser->target_buffer, &ser->target_size, &ser->target_offset, walk->depth + 1);
                 if (chars < 0)
-                    return chars;
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, walk->index < node->count - 1 ? "],\n" : "]\n");
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            }
+            if (walk->index == node->count - 1)
+            {
                 // write node end
-                if (level == 0 || (*desc)[1].type == KOW_BRANCH_END)
+                chars = add_indent(&ser->target_buffer, &ser->target_size, &ser->target_offset, walk->depth);
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                if (walk->depth == 0 || walk->end[1].type == KOW_BRANCH_END)
                     node_end_str = "]}\n";
                 else
                     node_end_str = "]},\n";
-                chars = add_string(&target_buffer, &target_size, &target_offset, node_end_str);
+                chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, node_end_str);
                 if (chars < 0)
-                    return chars;
-                break;
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
             }
-            default:
+            break;
+
+        default:
+        {
+            int value_size = kowhai_get_node_type_size(node->type);
+            // indent to current level using tabs
+            chars = add_indent(&ser->target_buffer, &ser->target_size, &ser->target_offset, walk->depth);
+            if (chars < 0)
+                return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            // write header
+            chars = add_header(&ser->target_buffer, &ser->target_size, &ser->target_offset, (struct kowhai_node_t*)node, ser->get_name_param, ser->get_name);
+            if (chars < 0)
+                return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            // write value identifier
+            chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, ", \""VALUE"\": ");
+            if (chars < 0)
+                return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            // write value/s
+            if (node->count > 1)
             {
-                int value_size = kowhai_get_node_type_size(node->type);
-                // write header
-                chars = add_header(&target_buffer, &target_size, &target_offset, node, get_name_param, get_name);
-                if (chars < 0)
-                    return chars;
-                // write value identifier
-                chars = add_string(&target_buffer, &target_size, &target_offset, ", \""VALUE"\": ");
+                // write start bracket
+                chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, "[");
                 if (chars < 0)
-                    return chars;
-                // write value/s
-                if (node->count > 1)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                for (i = 0; i < node->count; i++)
                 {
-                    // write start bracket
-                    chars = add_string(&target_buffer, &target_size, &target_offset, "[");
+                    // write leaf node array item value
+                    chars = add_value(&ser->target_buffer, &ser->target_size, &ser->target_offset, node->type, (char*)walk->data + i * value_size);
                     if (chars < 0)
-                        return chars;
-                    for (i = 0; i < node->count; i++)
+                        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+                    // write comma if there is another array item
+                    if (i < node->count - 1)
                     {
-                        // write leaf node array item value
-                        chars = add_value(&target_buffer, &target_size, &target_offset, node->type, (char*)*data + i * value_size);
+                        chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, ", ");
                         if (chars < 0)
-                            return chars;
-                        // write comma if there is another array item
-                        if (i < node->count - 1)
-                        {
-                            chars = add_string(&target_buffer, &target_size, &target_offset, ", ");
-                            if (chars < 0)
-                                return chars;
-                        }
+                            return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
                     }
-                    // increment data pointer
-                    if (!in_union)
-                        *data = (char*)*data + value_size * node->count;
-                    else if (value_size * node->count > *largest_data_field)
-                        *largest_data_field = value_size * node->count;
-                    // write end bracket
-                    chars = add_string(&target_buffer, &target_size, &target_offset, "]");
-                    if (chars < 0)
-                        return chars;
                 }
-                else
-                {
-                    // write leaf node value
-                    chars = add_value(&target_buffer, &target_size, &target_offset, node->type, *data);
-                    if (chars < 0)
-                        return chars;
-                    // increment data pointer
-                    if (!in_union)
-                        *data = (char*)*data + value_size;
-                    else if (value_size > *largest_data_field)
-                        *largest_data_field = value_size;
-                }
-                // write node end
-                if (level == 0 || node[1].type == KOW_BRANCH_END)
-                    node_end_str = " }\n";
-                else
-                    node_end_str = " },\n";
-                chars = add_string(&target_buffer, &target_size, &target_offset, node_end_str);
+                // write end bracket
+                chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, "]");
                 if (chars < 0)
-                    return chars;
-                break;
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            }
+            else
+            {
+                // write leaf node value
+                chars = add_value(&ser->target_buffer, &ser->target_size, &ser->target_offset, node->type, walk->data);
+                if (chars < 0)
+                    return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
             }
+            // write node end
+            if (walk->depth == 0 || node[1].type == KOW_BRANCH_END)
+                node_end_str = " }\n";
+            else
+                node_end_str = " },\n";
+            chars = add_string(&ser->target_buffer, &ser->target_size, &ser->target_offset, node_end_str);
+            if (chars < 0)
+                return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+            break;
         }
+    }
 
-        if (level == 0)
-            return target_offset;
+    return KOW_STATUS_OK;
+}
 
-        (*desc) += 1;
-    }
+// write a tree in descriptor order, returns the number of chars written or < 0 if the target buffer is too small
+static int serialize_tree(struct kowhai_tree_t *tree, char* target_buffer, size_t target_size, void* get_name_param, kowhai_get_symbol_name_t get_name)
+{
+    struct serialize_tree_walk_t ser;
+    ser.target_buffer = target_buffer;
+    ser.target_size = target_size;
+    ser.target_offset = 0;
+    ser.get_name_param = get_name_param;
+    ser.get_name = get_name;
+    if (kowhai_walk_tree(tree->desc, tree->data, serialize_tree_visit, &ser) != KOW_STATUS_OK)
+        return -1;
+    return ser.target_offset;
 }
 
 int kowhai_serialize_tree(struct kowhai_tree_t tree, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name)
 {
-    int largest_data_field;
-    int chars = serialize_tree(&tree.desc, &tree.data, target_buffer, *target_size, 0, get_name_param, get_name, tree.desc->type == KOW_BRANCH_U_START, &largest_data_field);
+    int chars;
+    // kowhai_deserialize_tree makes packed tree data so only packed trees round trip
+    if (kowhai_descriptor_layout(tree.desc) != KOW_LAYOUT_PACKED)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    chars = serialize_tree(&tree, target_buffer, *target_size, get_name_param, get_name);
     if (chars < 0)
         return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
     *target_size = chars;
@@ -407,19 +370,27 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
     int ipath = 0;
     const char *init = path_str;
     const char *sym_start = init, *sym_end;
-    const char *istart = init, *iend;
-    int r, index;
+    const char *istart = init, *iend, *range;
+    int r, index, slice_count;
 
     while (sym_start < init + path_strlen)
     {
-        // find next symbol
+        // find next symbol (skipping any '..' inside an array slice)
         int n = path_strlen - (sym_start - init);
         sym_end = strnchr(sym_start, n, '.');
+        istart = strnchr(sym_start, n, '[');
+        if (sym_end != NULL && istart != NULL && istart < sym_end)
+        {
+            iend = strnchr(istart, n - (istart - sym_start), ']');
+            if (iend != NULL)
+                sym_end = strnchr(iend, n - (iend - sym_start), '.');
+        }
         if (sym_end == NULL)
             sym_end = init + path_strlen; // so the rest of the string
 
-        // check for index
+        // check for index or slice (ie "name[start..end]")
         index = 0;
+        slice_count = 0;
         istart = strnchr(sym_start, sym_end - sym_start, '[');
         iend = strnchr(sym_start, sym_end - sym_start, ']');
         if (istart != NULL)
@@ -427,6 +398,15 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
             if (iend == NULL)
                 return KOW_STATUS_INVALID_SYMBOL_PATH; // malformed path, array index start must have a end
             index = atoi(istart + 1);
+            range = strnchr(istart, iend - istart, '.');
+            if (range != NULL)
+            {
+                if (range[1] != '.')
+                    return KOW_STATUS_INVALID_SYMBOL_PATH; // malformed path, slice must be "[start..end]"
+                slice_count = atoi(range + 2) - index + 1;
+                if (slice_count < 1 || sym_end != init + path_strlen)
+                    return KOW_STATUS_INVALID_SYMBOL_PATH; // empty slice or slice not at the end of the path
+            }
         }
         else
             istart = sym_end; // if no indexing this starts (and ends) at the last char
@@ -437,6 +417,12 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
         path[ipath++].symbol = KOWHAI_SYMBOL(r, index);
         if (ipath >= *path_len)
             return KOW_STATUS_PATH_TOO_SMALL; // path buffer not big enough
+        if (slice_count > 0)
+        {
+            path[ipath++].symbol = KOWHAI_SLICE(slice_count);
+            if (ipath >= *path_len)
+                return KOW_STATUS_PATH_TOO_SMALL; // path buffer not big enough
+        }
 
         sym_start = sym_end + 1;
     }
@@ -650,172 +636,123 @@ static int print_node_type(struct kowhai_node_t *root, char *dst, int dst_len, s
 }
 
 
-static int serialize_nodes(struct kowhai_node_t *root, char *dst, int dst_len, struct kowhai_node_t *src_node, void **src_data, 
-                    union kowhai_symbol_t *path, int ipath, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name,
-                    int is_union, int level)
+// find the first of the largest members of a union (the member that covers all the union data)
+static const struct kowhai_node_t* largest_union_member(const struct kowhai_node_t *node)
 {
-    int r, i, n = 0;
-    int count = 0;
-    int node_size;
-    int node_count;
-    int max_union_size = 0;
-    int rmax = 0;
-
-    // print opening array brace only if we are level 0
-    if (level == 0)
-        STARTEND("[");
+    const struct kowhai_node_t *child = node + 1;
+    int size, child_size, child_count;
 
-    while (1)
+    if (kowhai_get_node_size(node, &size) != KOW_STATUS_OK)
+        return NULL;
+    size /= node->count;
+    while (child->type != KOW_BRANCH_END)
     {
-        struct kowhai_node_t *node = &src_node[n];
-        
-        switch(node->type)
-        {
-            case KOW_BRANCH_U_START:
-                if (kowhai_get_node_size(node, &node_size) != KOW_STATUS_OK)
-                    return -1;
-
-                // for each complex array type recurse into each array element
-                for (i = 0; i < node->count; i++)
-                {
-                    // append this branch to the path
-                    if (ipath >= path_len)
-                        return -2;
-                    path[ipath].symbol = KOWHAI_SYMBOL(node->symbol, i);
-                
-                    // recurse into branch
-                    r = serialize_nodes(root, dst, dst_len, node + 1, src_data, path, ipath + 1, path_len, get_name_param, get_name, 1, level + 1);
-                    if (r < 0)
-                        return r;
-                    if (r >= dst_len)
-                        return count + r;
-                }
-                
-                // union type over
-                dst += r;
-                count += r;
-                dst_len -= r;
-                *(char **)src_data += node_size;
-
-                // move past this branch in the descriptor
-                if (kowhai_get_node_count(node, &node_count) != KOW_STATUS_OK)
-                    return -1;
-                node_count -= 1;
-                n += node_count;
-
-                // ending criteria
-                if (level == 0)
-                {
-                    STARTEND("]");
-                    return count;
-                }
-                break;
-
-            case KOW_BRANCH_START:
-                if (kowhai_get_node_size(node, &node_size) != KOW_STATUS_OK)
-                    return -1;
+        if (kowhai_get_node_size(child, &child_size) != KOW_STATUS_OK || kowhai_get_node_count(child, &child_count) != KOW_STATUS_OK)
+            return NULL;
+        if (child_size == size)
+            return child;
+        child += child_count;
+    }
+    return NULL;
+}
 
-                // for each complex array type recurse into each array element
-                if ((is_union && (node_size >= max_union_size)) || !is_union)
-                {
-                    for (i = 0; i < node->count; i++)
-                    {
-                        // append this branch to the path
-                        if (ipath >= path_len)
-                            return -2;
-                        path[ipath].symbol = KOWHAI_SYMBOL(node->symbol, i);
-                    
-                        // recurse into branch
-                        r = serialize_nodes(root, dst, dst_len, node + 1, src_data, path, ipath + 1, path_len, get_name_param, get_name, 0, level + 1);
-                        if (r < 0)
-                            return r;
-                        if (r >= dst_len)
-                            return count + r;
-                        rmax = r;
-
-                        // push pointer on if this is not a union
-                        // if it is we do this at the end for the
-                        // biggest field
-                        if (!is_union)
-                        {
-                            dst += r;
-                            count += r;
-                            dst_len -= r;
-                        }
-                    }
-                }
-                
-                // move past this branch in the descriptor
-                if (kowhai_get_node_count(node, &node_count) != KOW_STATUS_OK)
-                    return -1;
-                node_count -= 1;
-                n += node_count;
+// the output of serialize_nodes, each open union frame keeps the member that is written (user)
+struct serialize_nodes_walk_t
+{
+    const struct kowhai_node_t *root;
+    char *dst;
+    int dst_len;
+    int count;
+    union kowhai_symbol_t *path;
+    int path_len;
+    void* get_name_param;
+    kowhai_get_symbol_name_t get_name;
+    int result;         // returned by serialize_nodes if the walk is stopped
+};
 
-                // ending criteria
-                if (level == 0)
-                {
-                    STARTEND("]");
-                    return count;
-                }
-                break;
+// write the leaf a walk is at
+static int serialize_nodes_visit(void* param, struct kowhai_walk_t *walk)
+{
+    struct serialize_nodes_walk_t *nodes = (struct serialize_nodes_walk_t*)param;
+    struct kowhai_walk_frame_t *parent = walk->event == KOW_WALK_LEAF ? walk->frame : walk->frame->parent;
+    int r, path_len;
 
-            case KOW_BRANCH_END:
-                if (is_union)
-                {
-                    dst += rmax;
-                    count += rmax;
-                    dst_len -= rmax;
-                }
-                return count;
+    if (walk->event == KOW_WALK_BRANCH_END)
+        return KOW_STATUS_OK;
 
-            default:
+    // only the largest member of a union is written (its data covers the whole union)
+    if (walk->depth > 0 && parent->user != NULL && parent->user != walk->node)
+    {
+        if (walk->event == KOW_WALK_BRANCH_START)
+            return kowhai_walk_skip(walk);
+        return KOW_STATUS_OK;
+    }
 
-                // get this node size in bytes
-                node_size = kowhai_get_node_type_size(node->type) * node->count;
-                if (node_size < 0)
-                    return -1;
+    if (walk->event == KOW_WALK_BRANCH_START)
+    {
+        if (walk->node->type == KOW_BRANCH_U_START)
+        {
+            walk->frame->user = largest_union_member(walk->node);
+            if (walk->frame->user == NULL)
+                return KOW_STATUS_INVALID_DESCRIPTOR;
+        }
+        return KOW_STATUS_OK;
+    }
 
-                // handle unions
-                if (is_union)
-                {
-                    if (node_size <= max_union_size)
-                        break;
-                    max_union_size = node_size;
-                }
+    // update the path scratch buffer for this item
+    path_len = nodes->path_len;
+    if (kowhai_walk_get_path(walk, nodes->path, &path_len) != KOW_STATUS_OK)
+    {
+        nodes->result = -2;
+        return KOW_STATUS_PATH_TOO_SMALL;
+    }
 
-                // update the path scratch buffer for this item
-                if (ipath >= path_len)
-                    return -2;
-                path[ipath].symbol = KOWHAI_SYMBOL(node->symbol, 0);
-
-                // print this item
-                r = print_node_type(root, dst, dst_len, node, src_data, path, ipath, get_name_param, get_name);
-                if (r < 0)
-                    return r;
-                if (r > dst_len)
-                    return count + r;
-                rmax = r;
-                if (!is_union)
-                {
-                    dst += r;
-                    count += r;
-                    dst_len -= r;
+    // print this item
+    r = print_node_type((struct kowhai_node_t*)nodes->root, nodes->dst, nodes->dst_len, (struct kowhai_node_t*)walk->node, &walk->data, nodes->path, walk->depth, nodes->get_name_param, nodes->get_name);
+    if (r < 0 || r >= nodes->dst_len)
+    {
+        nodes->result = r < 0 ? r : nodes->count + r;
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    }
+    nodes->dst += r;
+    nodes->count += r;
+    nodes->dst_len -= r;
+    return KOW_STATUS_OK;
+}
 
-                    // move the data pointer
-                    *(char **)src_data += node_size;
-                }
+static int serialize_nodes(struct kowhai_tree_t *tree, char *dst, int dst_len, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name)
+{
+    struct serialize_nodes_walk_t nodes;
+    int r;
+    int count = 0;
 
-                break;
-        }
-        n++;
-    }
+    STARTEND("[");
+
+    nodes.root = tree->desc;
+    nodes.dst = dst;
+    nodes.dst_len = dst_len;
+    nodes.count = count;
+    nodes.path = path;
+    nodes.path_len = path_len;
+    nodes.get_name_param = get_name_param;
+    nodes.get_name = get_name;
+    nodes.result = -1;
+    if (kowhai_walk_tree(tree->desc, tree->data, serialize_nodes_visit, &nodes) != KOW_STATUS_OK)
+        return nodes.result;
+    dst = nodes.dst;
+    dst_len = nodes.dst_len;
+    count = nodes.count;
+
+    STARTEND("]");
+    return count;
 }
 
 int kowhai_serialize_nodes(char *dst, int *dst_len, struct kowhai_tree_t *src_tree, union kowhai_symbol_t *path, int path_len, void* get_name_param, kowhai_get_symbol_name_t get_name)
 {
-    void *src_data = src_tree->data;
-    int is_union = src_tree->desc->type == KOW_BRANCH_U_START;
-    int chars = serialize_nodes(src_tree->desc, dst, *dst_len, src_tree->desc, &src_data, path, 0, path_len, get_name_param, get_name, is_union, 0);
+    int chars;
+    if (kowhai_descriptor_layout(src_tree->desc) != KOW_LAYOUT_PACKED)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    chars = serialize_nodes(src_tree, dst, *dst_len, path, path_len, get_name_param, get_name);
 
     // handle errors
     switch (chars)
@@ -1281,6 +1218,9 @@ int kowhai_deserialize_nodes(char* src, int src_size, struct kowhai_tree_t *dst_
     int token_count = scratch_size / sizeof(jsmntok_t);
     jsmnerr_t err;
 
+    if (kowhai_descriptor_layout(dst_tree->desc) != KOW_LAYOUT_PACKED)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+
     jsmn_init_parser(&parser, src, tokens, token_count);
     err = jsmn_parse(&parser);
     switch (err)
@@ -1310,3 +1250,215 @@ int kowhai_deserialize_nodes(char* src, int src_size, struct kowhai_tree_t *dst_
     }
 
 }
+
+//
+// binary containers
+//
+
+// the tree data is placed at a multiple of this in a container (so aligned layouts stay aligned)
+#define BINARY_DATA_ALIGN 8
+
+// fnv-1a of a 16 bit value (low byte first so the hash does not depend on the byte order)
+static uint32_t hash_uint16(uint32_t hash, uint16_t value)
+{
+    hash = (hash ^ (value & 0xFF)) * 16777619u;
+    hash = (hash ^ (value >> 8)) * 16777619u;
+    return hash;
+}
+
+int kowhai_descriptor_hash(const struct kowhai_node_t *desc, uint32_t *hash)
+{
+    int i, count;
+    int status = kowhai_get_node_count(desc, &count);
+    if (status != KOW_STATUS_OK)
+        return status;
+    *hash = 2166136261u;
+    for (i = 0; i < count; i++)
+    {
+        *hash = hash_uint16(*hash, desc[i].type);
+        *hash = hash_uint16(*hash, desc[i].symbol);
+        *hash = hash_uint16(*hash, desc[i].count);
+        *hash = hash_uint16(*hash, desc[i].tag);
+    }
+    return KOW_STATUS_OK;
+}
+
+// crc32 (ieee 802.3) using a nibble table to keep the table small on embedded targets
+uint32_t kowhai_crc32(uint32_t crc, const void *buffer, size_t size)
+{
+    static const uint32_t table[16] =
+    {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t *byte = (const uint8_t*)buffer;
+    crc = ~crc;
+    while (size--)
+    {
+        crc ^= *byte++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+int kowhai_binary_header(const struct kowhai_node_t *desc, int flags, struct kowhai_binary_header_t *header)
+{
+    int status, node_count, data_size;
+
+    status = kowhai_get_node_count(desc, &node_count);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_descriptor_hash(desc, &header->descriptor_hash);
+    if (status != KOW_STATUS_OK)
+        return status;
+    header->magic = KOW_BINARY_MAGIC;
+    header->version = KOW_BINARY_VERSION;
+    header->layout = (uint16_t)kowhai_descriptor_layout(desc);
+    header->descriptor_size = (flags & KOW_BINARY_STORE_DESCRIPTOR) ? node_count * sizeof(struct kowhai_node_t) : 0;
+    header->data_offset = (sizeof(struct kowhai_binary_header_t) + header->descriptor_size + BINARY_DATA_ALIGN - 1) / BINARY_DATA_ALIGN * BINARY_DATA_ALIGN;
+    header->data_size = data_size;
+    header->flags = flags & (KOW_BINARY_STORE_DESCRIPTOR | KOW_BINARY_CHECKSUM);
+    header->checksum = 0;
+    return KOW_STATUS_OK;
+}
+
+// count the nodes of a descriptor read from a buffer without passing max_count nodes, returns -1 if the root branch
+// does not end within them
+static int bounded_node_count(const struct kowhai_node_t *desc, int max_count)
+{
+    int i, depth = 0;
+    for (i = 0; i < max_count; i++)
+    {
+        if (desc[i].type == KOW_BRANCH_START || desc[i].type == KOW_BRANCH_U_START)
+            depth++;
+        else if (desc[i].type == KOW_BRANCH_END)
+            depth--;
+        if (depth <= 0)
+            return i + 1;
+    }
+    return -1;
+}
+
+int kowhai_binary_check(const void *buffer, int buffer_size, const struct kowhai_node_t **desc)
+{
+    const struct kowhai_binary_header_t *header = (const struct kowhai_binary_header_t*)buffer;
+    uint32_t hash;
+    int status, data_size;
+
+    if (buffer_size < (int)sizeof(struct kowhai_binary_header_t) ||
+        header->magic != KOW_BINARY_MAGIC ||
+        header->version != KOW_BINARY_VERSION ||
+        (uint64_t)header->data_offset + header->data_size > (uint64_t)buffer_size ||
+        sizeof(struct kowhai_binary_header_t) + (uint64_t)header->descriptor_size > header->data_offset)
+        return KOW_STATUS_BUFFER_INVALID;
+    if ((header->flags & KOW_BINARY_CHECKSUM) &&
+        kowhai_crc32(0, header + 1, header->data_offset + header->data_size - sizeof(struct kowhai_binary_header_t)) != header->checksum)
+        return KOW_STATUS_BUFFER_INVALID;
+
+    // use the stored descriptor if none was given, it must fill the space stored for it exactly (the header checks
+    // above keep that space inside the buffer)
+    if (*desc == NULL)
+    {
+        const struct kowhai_node_t *stored = (const struct kowhai_node_t*)(header + 1);
+        int node_count = (int)(header->descriptor_size / sizeof(struct kowhai_node_t));
+        if (node_count == 0 || header->descriptor_size % sizeof(struct kowhai_node_t) != 0 ||
+            stored->type != KOW_BRANCH_START || bounded_node_count(stored, node_count) != node_count)
+            return KOW_STATUS_INVALID_DESCRIPTOR;
+        *desc = stored;
+    }
+
+    // the descriptor and the layout must match the ones the container was saved with
+    status = kowhai_descriptor_hash(*desc, &hash);
+    if (status != KOW_STATUS_OK)
+        return status;
+    status = kowhai_get_node_size(*desc, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (hash != header->descriptor_hash || (uint32_t)data_size != header->data_size || kowhai_descriptor_layout(*desc) != header->layout)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_binary_save(struct kowhai_tree_t *tree, int flags, void *buffer, int *buffer_size)
+{
+    struct kowhai_binary_header_t header;
+    union kowhai_symbol_t root;
+    char *dst = (char*)buffer;
+    int status;
+
+    status = kowhai_binary_header(tree->desc, flags, &header);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (*buffer_size < (int)(header.data_offset + header.data_size))
+    {
+        *buffer_size = header.data_offset + header.data_size;
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    }
+
+    // read the tree data through the library so a concurrent write is not torn
+    memset(dst, 0, header.data_offset);
+    memcpy(dst + sizeof(header), tree->desc, header.descriptor_size);
+    root.symbol = KOWHAI_SYMBOL(tree->desc->symbol, 0);
+    status = kowhai_read(tree, 1, &root, 0, dst + header.data_offset, header.data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    if (header.flags & KOW_BINARY_CHECKSUM)
+        header.checksum = kowhai_crc32(0, dst + sizeof(header), header.data_offset + header.data_size - sizeof(header));
+    memcpy(dst, &header, sizeof(header));
+    *buffer_size = header.data_offset + header.data_size;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_binary_load(const void *buffer, int buffer_size, struct kowhai_tree_t *tree)
+{
+    const struct kowhai_binary_header_t *header = (const struct kowhai_binary_header_t*)buffer;
+    const struct kowhai_node_t *desc = tree->desc;
+    union kowhai_symbol_t root;
+    int status;
+
+    if (desc == NULL)
+        return KOW_STATUS_INVALID_DESCRIPTOR;
+    status = kowhai_binary_check(buffer, buffer_size, &desc);
+    if (status != KOW_STATUS_OK)
+        return status;
+
+    // write through the library so locks, snapshots and dirty tracking see the load
+    root.symbol = KOWHAI_SYMBOL(desc->symbol, 0);
+    return kowhai_write(tree, 1, &root, 0, (char*)buffer + header->data_offset, header->data_size);
+}
+
+int kowhai_binary_open(void *buffer, int buffer_size, struct kowhai_tree_t *tree)
+{
+    const struct kowhai_binary_header_t *header = (const struct kowhai_binary_header_t*)buffer;
+    const struct kowhai_node_t *desc = tree->desc;
+    int status = kowhai_binary_check(buffer, buffer_size, &desc);
+    if (status != KOW_STATUS_OK)
+        return status;
+    tree->desc = (struct kowhai_node_t*)desc;
+    tree->data = (char*)buffer + header->data_offset;
+    return KOW_STATUS_OK;
+}
+
+int kowhai_binary_to_json(void *buffer, int buffer_size, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name)
+{
+    struct kowhai_tree_t tree = {NULL, NULL};
+    int status = kowhai_binary_open(buffer, buffer_size, &tree);
+    if (status != KOW_STATUS_OK)
+        return status;
+    return kowhai_serialize_tree(tree, target_buffer, target_size, get_name_param, get_name);
+}
+
+int kowhai_json_to_binary(char* json, void* scratch, int scratch_size, struct kowhai_node_t* descriptor, int descriptor_size, void* data, int data_size, int flags, void *buffer, int *buffer_size)
+{
+    struct kowhai_tree_t tree;
+    int status = kowhai_deserialize_tree(json, scratch, scratch_size, descriptor, &descriptor_size, data, &data_size);
+    if (status != KOW_STATUS_OK)
+        return status;
+    tree.desc = descriptor;
+    tree.data = data;
+    return kowhai_binary_save(&tree, flags, buffer, buffer_size);
+}
@@ -3,6 +3,35 @@
 
 #include "kowhai.h"
 
+#include <stddef.h>
+
+#define KOW_BINARY_MAGIC    0x4B4F5748  ///< "KOWH", also detects containers written on a machine of the other byte order
+#define KOW_BINARY_VERSION  1           ///< version of the binary container format
+
+// binary container flags
+#define KOW_BINARY_STORE_DESCRIPTOR 0x01    ///< the descriptor is stored so the container can be loaded without one
+#define KOW_BINARY_CHECKSUM         0x02    ///< a crc32 of the descriptor and data is stored and checked on load
+
+#pragma pack(1)
+
+/**
+ * @brief header at the start of a binary tree container, it is followed by the descriptor (if stored) and the tree data
+ */
+struct kowhai_binary_header_t
+{
+    uint32_t magic;             ///< KOW_BINARY_MAGIC
+    uint16_t version;           ///< KOW_BINARY_VERSION
+    uint16_t layout;            ///< tree data layout (KOW_LAYOUT_xxx)
+    uint32_t descriptor_hash;   ///< kowhai_descriptor_hash of the descriptor of the tree data
+    uint32_t descriptor_size;   ///< bytes of descriptor stored after the header (0 if not stored)
+    uint32_t data_offset;       ///< offset of the tree data from the start of the container
+    uint32_t data_size;         ///< bytes of tree data
+    uint32_t flags;             ///< KOW_BINARY_xxx flags the container was saved with
+    uint32_t checksum;          ///< crc32 of everything after the header (if flags has KOW_BINARY_CHECKSUM)
+};
+
+#pragma pack()
+
 /**
  * @brief callback used to convert a kowhai symbol id to its string representation
  * @param param application specific parameter passed through
@@ -30,6 +59,7 @@ typedef int (*kowhai_node_not_found_t)(void* param, union kowhai_symbol_t *path,
 /**
  * @brief convert a string with symbol names separated by '.' delimiters and arrays '[]' into a kowhai_symbol_t array
  * @param path_str path string to convert (symbols should be separated by '.' chars and array index designated by '[2]' for example, 0 is assumed if index not present
+ *        the last symbol may address a slice of its array, ie '[100..163]', which appends a KOWHAI_SLICE symbol to the path
  * @param path_strlen number of chars in the above string
  * @param path destination populated with kowhai_symbol_t to make the path
  * @param path_len size of path (number of kowhai_symbol_t allocated), updated on KOW_STATUS_OK to the number of symbols populated
@@ -47,7 +77,7 @@ int kowhai_str_to_path(const char *path_str, int path_strlen, union kowhai_symbo
  * @param target_size, the size of the target buffer (upon success the number of characters written to target_buffer are returned to the caller via this parameter)
  * @param get_name_param application specific parameter passed through the get_name callback
  * @param get_name, a pointer to a function that resolves kowhai symbol integers to strings
- * @return KOW_STATUS_OK if the function was successfull
+ * @return KOW_STATUS_OK if the function was successfull, KOW_STATUS_INVALID_DESCRIPTOR if the tree does not use the packed layout
  */
 int kowhai_serialize_tree(struct kowhai_tree_t tree, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name);
 
@@ -96,4 +126,98 @@ int kowhai_deserialize_tree(char* buffer, void* scratch, int scratch_size, struc
  */
 int kowhai_deserialize_nodes(char* src, int src_size, struct kowhai_tree_t *dst_tree, union kowhai_symbol_t *path, int path_len, void* scratch, int scratch_size, void *get_name_param, kowhai_get_symbol_t get_name, void *not_found_param, kowhai_node_not_found_t not_found);
 
+/**
+ * @brief hash a descriptor (node types, symbols, counts and tags) to check tree data matches it
+ * @param desc, the descriptor to hash (must start with a branch)
+ * @param hash, set to the descriptor hash
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_descriptor_hash(const struct kowhai_node_t *desc, uint32_t *hash);
+
+/**
+ * @brief calculate (or continue) the crc32 (ieee 802.3) of a buffer
+ * @param crc, 0 to start a crc or the result of a previous call to continue it
+ * @param buffer, the bytes to add to the crc
+ * @param size, number of bytes in buffer
+ * @return the crc of all the bytes so far
+ */
+uint32_t kowhai_crc32(uint32_t crc, const void *buffer, size_t size);
+
+/**
+ * @brief fill in the header of a binary container for a descriptor (the checksum is left 0)
+ * @param desc, the descriptor of the tree data
+ * @param flags, KOW_BINARY_xxx flags
+ * @param header, the header to fill in, header->data_offset + header->data_size is the size of the container
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_binary_header(const struct kowhai_node_t *desc, int flags, struct kowhai_binary_header_t *header);
+
+/**
+ * @brief check a binary container is intact and matches a descriptor
+ * @param buffer, the container
+ * @param buffer_size, number of bytes in buffer
+ * @param desc, the descriptor the tree data must match, or if it points to NULL it is set to the stored descriptor
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_INVALID_DESCRIPTOR if the container does not
+ * match the descriptor (or its current layout), KOW_STATUS_BUFFER_INVALID if the container is damaged
+ */
+int kowhai_binary_check(const void *buffer, int buffer_size, const struct kowhai_node_t **desc);
+
+/**
+ * @brief save a tree as a binary container (a header, optionally the descriptor and a copy of the tree data)
+ * The container can be loaded with kowhai_binary_load or kowhai_binary_open, or written to a file and opened with
+ * kowhai_tree_open_mapped.
+ * @param tree, the tree to save
+ * @param flags, KOW_BINARY_xxx flags
+ * @param buffer, the buffer to save the container to
+ * @param buffer_size, the size of buffer, set to the size of the container (or the size required if buffer is too small)
+ * @return kowhai status value, ie KOW_STATUS_OK on success, KOW_STATUS_TARGET_BUFFER_TOO_SMALL if buffer is too small
+ */
+int kowhai_binary_save(struct kowhai_tree_t *tree, int flags, void *buffer, int *buffer_size);
+
+/**
+ * @brief copy the tree data of a binary container into a tree
+ * @param buffer, the container
+ * @param buffer_size, number of bytes in buffer
+ * @param tree, the tree to load (its descriptor must match the container)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (see kowhai_binary_check)
+ */
+int kowhai_binary_load(const void *buffer, int buffer_size, struct kowhai_tree_t *tree);
+
+/**
+ * @brief use the tree data of a binary container in place (no copy)
+ * @param buffer, the container (ie read from or mapped from a file), it must stay valid while the tree is used
+ * @param buffer_size, number of bytes in buffer
+ * @param tree, set to the container data, if tree->desc is NULL it is set to the stored descriptor
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error (see kowhai_binary_check)
+ */
+int kowhai_binary_open(void *buffer, int buffer_size, struct kowhai_tree_t *tree);
+
+/**
+ * @brief convert a binary container (with a stored descriptor) to the json form of kowhai_serialize_tree
+ * @param buffer, the container
+ * @param buffer_size, number of bytes in buffer
+ * @param target_buffer, the ascii string to write the json representation to
+ * @param target_size, the size of the target buffer (upon success the number of characters written to target_buffer are returned to the caller via this parameter)
+ * @param get_name_param application specific parameter passed through the get_name callback
+ * @param get_name, a pointer to a function that resolves kowhai symbol integers to strings
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_binary_to_json(void *buffer, int buffer_size, char* target_buffer, int* target_size, void* get_name_param, kowhai_get_symbol_name_t get_name);
+
+/**
+ * @brief convert the json form of kowhai_serialize_tree to a binary container
+ * @param json, the json string
+ * @param scratch, a buffer to be used by the json parser
+ * @param scratch_size, the size of the scatch buffer
+ * @param descriptor, working buffer for the tree descriptor
+ * @param descriptor_size, number of nodes in descriptor
+ * @param data, working buffer for the tree data
+ * @param data_size, the size of data
+ * @param flags, KOW_BINARY_xxx flags
+ * @param buffer, the buffer to save the container to
+ * @param buffer_size, the size of buffer, set to the size of the container (or the size required if buffer is too small)
+ * @return kowhai status value, ie KOW_STATUS_OK on success or other on error
+ */
+int kowhai_json_to_binary(char* json, void* scratch, int scratch_size, struct kowhai_node_t* descriptor, int descriptor_size, void* data, int data_size, int flags, void *buffer, int *buffer_size);
+
 #endif
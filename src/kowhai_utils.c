@@ -58,120 +58,147 @@ static int compare_simple_node_contents(struct kowhai_tree_t *left, struct kowha
     return KOW_STATUS_OK;
 }
 
-static int increment_tree(struct kowhai_tree_t* tree, int in_union)
+// find the child of a right branch that matches a left node, offset is set to the bytes from the start of the branch item to the child
+static int find_matching_child(const struct kowhai_node_t *branch, const struct kowhai_node_t *left, const struct kowhai_node_t **child, int *offset)
 {
-    int res, size, count;
-    if (!in_union)
+    const struct kowhai_node_t *node = branch + 1;
+    const struct kowhai_index_t *index = kowhai_descriptor_get_index(branch);
+    int size, count, ret;
+
+    *offset = 0;
+    while (node->type != KOW_BRANCH_END)
     {
-        res = kowhai_get_node_size(tree->desc, &size);
-        if (res != KOW_STATUS_OK)
-            return res;
-        tree->data = (uint8_t*)tree->data + size;
+        if (index != NULL)
+            *offset = index->entries[node - index->desc].offset;
+        if (check_nodes_match((struct kowhai_node_t*)left, (struct kowhai_node_t*)node))
+        {
+            *child = node;
+            return KOW_STATUS_OK;
+        }
+        ret = kowhai_get_node_size(node, &size);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        ret = kowhai_get_node_count(node, &count);
+        if (ret != KOW_STATUS_OK)
+            return ret;
+        if (branch->type == KOW_BRANCH_START)
+            *offset += size;
+        node += count;
     }
-    res = kowhai_get_node_count(tree->desc, &count);
-    if (res != KOW_STATUS_OK)
-        return res;
-    tree->desc = tree->desc + count;
-    return KOW_STATUS_OK;
+    return KOW_STATUS_NOT_FOUND;
 }
 
-/**
- * @brief diff_l2r diff left tree against right tree
- * If a node is found in the left tree that is not in the right tree (ie symbol path and types/array size match) call on_unique 
- * If a node is found in both left and right tree, but the values of the node items do not match call on_diff
- * @note unique items on the right tree are ignored
- * @param left, diff this tree against right
- * @param left_node_index, the index of the left node in the original descriptor (used in recursive calls, original caller should pass 0)
- * @param right, diff this tree against left
- * @param right_node_index, the index of the right node in the original descriptor (used in recursive calls, original caller should pass 0)
- * @param on_diff_param, application specific parameter passed through the on_diff callback
- * @param on_diff, call this when a unique node in the left tree is found... or a common node is found in both left and right trees and the values do not match
- * @param depth, how deep in the tree are we (0 root, 1 first branch, etc)
- */
-static int diff_l2r(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff, int depth)
+// the right tree of a diff, each open left branch frame keeps the matching right node (user) and the data of its
+// current array item (user_data)
+struct diff_walk_t
 {
-    int ret;
-    int in_union = left->desc->type == KOW_BRANCH_U_START;
+    struct kowhai_tree_t *right;
+    void* on_diff_param;
+    kowhai_on_diff_t on_diff;
+};
+
+static int diff_l2r_visit(void* param, struct kowhai_walk_t *walk)
+{
+    struct diff_walk_t *diff = (struct diff_walk_t*)param;
+    struct kowhai_walk_frame_t *frame = walk->frame, *parent;
+    const struct kowhai_node_t *right_node;
     struct kowhai_tree_t left_leafs, right_leafs;
+    int right_offset, right_size;
+    int ret = KOW_STATUS_OK;
 
-    // init left tree (first node to compare at this level)
-    left_leafs.desc = left->desc + 1;
-    left_leafs.data = left->data;
+    if (walk->event == KOW_WALK_BRANCH_END)
+        return KOW_STATUS_OK;
 
-    while (left_leafs.desc->type != KOW_BRANCH_END)
+    // the left root is compared against the right root
+    if (walk->depth == 0)
     {
-        int found_node_match = 0;
-
-        // init right tree (compare against left tree at this level)
-        right_leafs.desc = right->desc + 1;
-        right_leafs.data = right->data;
+        if (walk->event == KOW_WALK_BRANCH_START)
+        {
+            if (walk->index > 0)
+                ret = kowhai_walk_skip(walk);
+            frame->user = diff->right->desc;
+            frame->user_data = diff->right->data;
+        }
+        return ret;
+    }
+    parent = walk->event == KOW_WALK_LEAF ? frame : frame->parent;
 
-        while (right_leafs.desc->type != KOW_BRANCH_END)
+    // find the matching node in the right tree (only once for all the items of a branch array)
+    if (walk->event == KOW_WALK_BRANCH_START && walk->index > 0)
+        right_node = (const struct kowhai_node_t*)frame->user;
+    else
+    {
+        right_node = NULL;
+        ret = find_matching_child((const struct kowhai_node_t*)parent->user, walk->node, &right_node, &right_offset);
+        if (ret == KOW_STATUS_NOT_FOUND)
+            ret = KOW_STATUS_OK;
+        else if (ret != KOW_STATUS_OK)
+            return ret;
+        if (right_node != NULL && walk->event == KOW_WALK_BRANCH_START)
         {
-            if (check_nodes_match(left_leafs.desc, right_leafs.desc))
-            {
-                // node metadata matches, do data comparison
-                int node_is_union = left_leafs.desc->type == KOW_BRANCH_U_START;
-                int node_is_branch = node_is_union || left_leafs.desc->type == KOW_BRANCH_START;
-                found_node_match = 1;
-                if (node_is_branch)
-                {
-                    // compare a complex (branch) node
-                    int left_size, right_size, i;
-                    ret = kowhai_get_node_size(left_leafs.desc, &left_size);
-                    if (ret != KOW_STATUS_OK)
-                        return ret;
-                    ret = kowhai_get_node_size(right_leafs.desc, &right_size);
-                    if (ret != KOW_STATUS_OK)
-                        return ret;
-                    for (i = 0; i < left_leafs.desc->count; i++)
-                    {
-                        // check for data diff in right branch array items
-                        if (i < right_leafs.desc->count)
-                        {
-                            ret = diff_l2r(&left_leafs, &right_leafs, on_diff_param, on_diff, depth + 1);
-                            if (ret != KOW_STATUS_OK)
-                                return ret;
-                            right_leafs.data = (uint8_t*)right_leafs.data + right_size / right_leafs.desc->count;
-                        }
-                        else if (on_diff != NULL)
-                            // missing array items from right branch
-                            on_diff(on_diff_param, left_leafs.desc, left_leafs.data, NULL, NULL, i, depth);
-                        left_leafs.data = (uint8_t*)left_leafs.data + left_size / left_leafs.desc->count;
-                    }
-                    // rewind as increment tree will increment the data pointer
-                    left_leafs.data = (uint8_t*)left_leafs.data - left_size;
-                    right_leafs.data = (uint8_t*)right_leafs.data - right_size;
-                }
-                else
-                {
-                    // compare a simple (non branch) node
-                    ret = compare_simple_node_contents(&left_leafs, &right_leafs, on_diff_param, on_diff, depth + 1);
-                    if (ret != KOW_STATUS_OK)
-                        return ret;
-                }
-                break;
-            }
-            else
-            {
-                // node metadata does not match increment right tree
-                ret = increment_tree(&right_leafs, in_union);
-                if (ret != KOW_STATUS_OK)
-                    return ret;
-            }
+            frame->user = right_node;
+            frame->user_data = (uint8_t*)parent->user_data + right_offset;
         }
+    }
 
-        if (!found_node_match && on_diff != NULL)
-            // node not found in right tree, call on_diff
-            on_diff(on_diff_param, left_leafs.desc, left_leafs.data, NULL, NULL, 1, depth);
+    if (right_node == NULL)
+    {
+        // node not found in right tree, call on_diff
+        if (walk->event == KOW_WALK_BRANCH_START)
+        {
+            frame->user = NULL;
+            ret = kowhai_walk_skip(walk);
+            if (walk->index > 0)
+                return ret;
+        }
+        if (diff->on_diff != NULL)
+            diff->on_diff(diff->on_diff_param, walk->node, walk->data, NULL, NULL, 1, walk->depth - 1);
+        return ret;
+    }
 
-        // increment left tree (next node to compare at this level)
-        ret = increment_tree(&left_leafs, in_union);
-        if (ret != KOW_STATUS_OK)
-            return ret;
+    if (walk->event == KOW_WALK_BRANCH_START)
+    {
+        // compare a complex (branch) node one array item at a time
+        if (walk->index >= right_node->count)
+        {
+            // missing array items from right branch
+            if (diff->on_diff != NULL)
+                diff->on_diff(diff->on_diff_param, walk->node, walk->data, NULL, NULL, walk->index, walk->depth - 1);
+            ret = kowhai_walk_skip(walk);
+        }
+        else if (walk->index > 0)
+        {
+            ret = kowhai_get_node_size(right_node, &right_size);
+            frame->user_data = (uint8_t*)frame->user_data + right_size / right_node->count;
+        }
+        return ret;
     }
 
-    return KOW_STATUS_OK;
+    // compare a simple (non branch) node
+    left_leafs.desc = (struct kowhai_node_t*)walk->node;
+    left_leafs.data = walk->data;
+    right_leafs.desc = (struct kowhai_node_t*)right_node;
+    right_leafs.data = (uint8_t*)parent->user_data + right_offset;
+    return compare_simple_node_contents(&left_leafs, &right_leafs, diff->on_diff_param, diff->on_diff, walk->depth);
+}
+
+/**
+ * @brief diff_l2r diff left tree against right tree
+ * If a node is found in the left tree that is not in the right tree (ie symbol path and types/array size match) call on_diff
+ * If a node is found in both left and right tree, but the values of the node items do not match call on_diff
+ * @note unique items on the right tree are ignored
+ * @param left, diff this tree against right
+ * @param right, diff this tree against left
+ * @param on_diff_param, application specific parameter passed through the on_diff callback
+ * @param on_diff, call this when a unique node in the left tree is found... or a common node is found in both left and right trees and the values do not match
+ */
+static int diff_l2r(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* on_diff_param, kowhai_on_diff_t on_diff)
+{
+    struct diff_walk_t diff;
+    diff.right = right;
+    diff.on_diff_param = on_diff_param;
+    diff.on_diff = on_diff;
+    return kowhai_walk_tree(left->desc, left->data, diff_l2r_visit, &diff);
 }
 
 /**
@@ -189,7 +216,7 @@ int kowhai_diff(struct kowhai_tree_t *left, struct kowhai_tree_t *right, void* o
 
     // we use diff_l2r to find nodes that are unique in the left tree, or nodes that differ in value between left and right first
     KOW_LOG(KOWHAI_UTILS_INFO "diff left against right\n");
-    ret = diff_l2r(left, right, on_diff_param, on_diff, 0);
+    ret = diff_l2r(left, right, on_diff_param, on_diff);
     if (ret != KOW_STATUS_OK)
         return ret;
 
@@ -293,73 +320,49 @@ int kowhai_create_symbol_path(struct kowhai_node_t* descriptor, struct kowhai_no
     return KOW_STATUS_OK;
 }
 
-int _create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size, int symbol_path_length, int in_union)
+// the target of kowhai_create_symbol_path2
+struct symbol_path_walk_t
 {
-    if (*target_size < symbol_path_length)
-        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
-    while (tree->data <= target_location)
-    {
-        int ret;
-        switch (tree->desc->type)
-        {
-            case KOW_BRANCH_START:
-            case KOW_BRANCH_U_START:
-            {
-                int i;
-                struct kowhai_node_t* node = tree->desc;
-                for (i = 0; i < node->count; i++)
-                {
-                    void* p_original = tree->data;
-                    target[symbol_path_length - 1].symbol = KOWHAI_SYMBOL(node->symbol, i);
-                    tree->desc = node + 1;
-                    ret = _create_symbol_path2(tree, target_location, target, target_size, symbol_path_length + 1, node->type == KOW_BRANCH_U_START);
-                    if (ret == KOW_STATUS_OK)
-                        return ret;
-                    if (ret != KOW_STATUS_NOT_FOUND)
-                        return ret;
-                    if (node->type == KOW_BRANCH_U_START)
-                    {
-                        int size;
-                        tree->data = p_original;
-                        if (kowhai_get_node_size(node, &size) == KOW_STATUS_OK)
-                            tree->data = (char*)tree->data + size / node->count;
-                        else
-                            return KOW_STATUS_INVALID_DESCRIPTOR;
-                    }
-                }
-                break;
-            }
-            case KOW_BRANCH_END:
-                return KOW_STATUS_NOT_FOUND;
-            default:
-            {
-                int i;
-                ret = kowhai_get_node_type_size(tree->desc->type);
-                for (i = 0; i < tree->desc->count; i++)
-                {
-                    target[symbol_path_length - 1].symbol = KOWHAI_SYMBOL(tree->desc->symbol, i);
-                    if ((char*)tree->data + ret * (i + 1) > (char*)target_location)
-                        break;
-                }
-                if (!in_union)
-                    tree->data = (char*)tree->data + ret * tree->desc->count;
-                break;
-            }
-        }
-        tree->desc++;
-    }
-    *target_size = symbol_path_length;
-    return KOW_STATUS_OK;
+    void* target_location;
+    union kowhai_symbol_t* target;
+    int* target_size;
+};
+
+// visit status that stops the walk once the target location is found (not a kowhai status)
+#define SYMBOL_PATH_FOUND -1
+
+static int symbol_path_visit(void* param, struct kowhai_walk_t *walk)
+{
+    struct symbol_path_walk_t *search = (struct symbol_path_walk_t*)param;
+    int i, size, ret;
+
+    // find the first leaf whose data contains the target location
+    if (walk->event != KOW_WALK_LEAF ||
+        (char*)search->target_location < (char*)walk->data ||
+        (char*)search->target_location >= (char*)walk->data + walk->size)
+        return KOW_STATUS_OK;
+    i = ((char*)search->target_location - (char*)walk->data) / kowhai_get_node_type_size(walk->node->type);
+    size = *search->target_size;
+    ret = kowhai_walk_get_path(walk, search->target, &size);
+    if (ret != KOW_STATUS_OK)
+        return ret;
+    search->target[walk->depth].symbol = KOWHAI_SYMBOL(walk->node->symbol, i);
+    *search->target_size = size;
+    return SYMBOL_PATH_FOUND;
 }
 
 int kowhai_create_symbol_path2(struct kowhai_tree_t* tree, void* target_location, union kowhai_symbol_t* target, int* target_size)
 {
-    struct kowhai_tree_t tmp_tree = *tree;
-    // first node will be a branch
-    if (*target_size < 1)
-        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
-    target->symbol = tmp_tree.desc->symbol;
-    tmp_tree.desc++;
-    return _create_symbol_path2(&tmp_tree, target_location, target, target_size, 2, tree->desc->type == KOW_BRANCH_U_START);
-}
+    struct symbol_path_walk_t search;
+    int ret;
 
+    search.target_location = target_location;
+    search.target = target;
+    search.target_size = target_size;
+    ret = kowhai_walk_tree(tree->desc, tree->data, symbol_path_visit, &search);
+    if (ret == SYMBOL_PATH_FOUND)
+        return KOW_STATUS_OK;
+    if (ret == KOW_STATUS_OK)
+        return KOW_STATUS_NOT_FOUND;
+    return ret;
+}
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+#
+# generate a C header of constant node offsets, sizes and typed inline
+# accessors from a kowhai tree descriptor
+#
+# usage: accessor_gen.py <tree.json> [<output.h>]
+#
+# the descriptor is read from the json emitted by kowhai_serialize_tree (node
+# values are ignored) so the generated header matches the descriptor that is
+# served over the kowhai protocol
+#
+
+import sys
+import re
+import json
+
+# kowhai node types
+KOW_BRANCH_START = 0x00
+KOW_BRANCH_END = 0x01
+KOW_BRANCH_U_START = 0x02
+
+# leaf node types and their c types
+leaf_types = {
+    0x70: ("int8_t", 1),
+    0x71: ("uint8_t", 1),
+    0x72: ("int16_t", 2),
+    0x73: ("uint16_t", 2),
+    0x74: ("int32_t", 4),
+    0x75: ("uint32_t", 4),
+    0x76: ("float", 4),
+    0x77: ("char", 1),
+}
+
+def c_name(name):
+    # convert a symbol name (ie FluxCapacitor) into a c name (ie flux_capacitor)
+    name = re.sub("([a-z0-9])([A-Z])", r"\1_\2", name)
+    return re.sub("[^A-Za-z0-9]", "_", name).lower()
+
+def get_children(node):
+    # branches are serialized with either "children" (count 1) or one child list per array item
+    if "children" in node:
+        return node["children"]
+    if "array" in node:
+        return node["array"][0]
+    return []
+
+class Node:
+    def __init__(self, node, parent, offset):
+        self.name = node["name"]
+        self.type_ = node["type"]
+        self.count = node["count"]
+        self.parent = parent
+        self.offset = offset
+        self.children = []
+        if parent is None:
+            self.path = [c_name(self.name)]
+        else:
+            self.path = parent.path + [c_name(self.name)]
+        if self.type_ in leaf_types:
+            self.ctype, self.element_size = leaf_types[self.type_]
+        elif self.type_ in (KOW_BRANCH_START, KOW_BRANCH_U_START):
+            # union children all start at the union offset and the union is as big as its biggest child
+            child_offset = 0
+            self.element_size = 0
+            for child in get_children(node):
+                child = Node(child, self, offset + child_offset)
+                self.children.append(child)
+                if self.type_ == KOW_BRANCH_START:
+                    child_offset += child.size()
+                    self.element_size = child_offset
+                else:
+                    self.element_size = max(self.element_size, child.size())
+        else:
+            raise ValueError("invalid node type 0x%x for node %s" % (self.type_, self.name))
+
+    def size(self):
+        return self.element_size * self.count
+
+    def node_count(self):
+        # number of descriptor nodes (branches include their end node)
+        if self.type_ in leaf_types:
+            return 1
+        return 2 + sum([child.node_count() for child in self.children])
+
+    def macro(self, suffix):
+        return "KOW_%s_%s" % ("_".join(self.path).upper(), suffix)
+
+    def function(self, verb):
+        return "%s_%s" % ("_".join(self.path), verb)
+
+    def indexed_ancestors(self):
+        # this node and its parents that are arrays (each adds an index parameter to the accessors)
+        nodes = []
+        node = self
+        while node is not None:
+            if node.count > 1:
+                nodes.insert(0, node)
+            node = node.parent
+        return nodes
+
+    def walk(self):
+        yield self
+        for child in self.children:
+            for node in child.walk():
+                yield node
+
+def write_constants(f, root):
+    f.write("// node offsets are from the start of the tree data with all array indices at 0\n")
+    for node in root.walk():
+        f.write("#define %s %d\n" % (node.macro("OFFSET"), node.offset))
+        f.write("#define %s %d\n" % (node.macro("STRIDE"), node.element_size))
+        f.write("#define %s %d\n" % (node.macro("COUNT"), node.count))
+        f.write("#define %s %d\n" % (node.macro("SIZE"), node.size()))
+    f.write("#define %s %d\n\n" % (root.macro("NODE_COUNT"), root.node_count()))
+
+def write_accessors(f, root):
+    for node in root.walk():
+        if node.type_ not in leaf_types:
+            continue
+        indexed = node.indexed_ancestors()
+        params = "".join([", int %s_index" % n.path[-1] for n in indexed])
+        offset = node.macro("OFFSET") + "".join([" + %s_index * %s" % (n.path[-1], n.macro("STRIDE")) for n in indexed])
+        f.write("static inline %s %s(const void* data%s)\n{\n" % (node.ctype, node.function("get"), params))
+        f.write("    %s value;\n" % node.ctype)
+        f.write("    memcpy(&value, (const char*)data + %s, sizeof(value));\n" % offset)
+        f.write("    return value;\n}\n\n")
+        f.write("// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)\n")
+        f.write("static inline void %s(void* data%s, %s value)\n{\n" % (node.function("set"), params, node.ctype))
+        f.write("    memcpy((char*)data + %s, &value, sizeof(value));\n}\n\n" % offset)
+
+def generate(tree_filename, header_filename):
+    f = open(tree_filename)
+    root = Node(json.load(f), None, 0)
+    f.close()
+    if root.type_ != KOW_BRANCH_START:
+        raise ValueError("tree root must be a branch")
+
+    guard = "_%s_ACCESSORS_H_" % c_name(root.name).upper()
+    f = open(header_filename, "w")
+    f.write("// generated by accessor_gen.py from %s, do not edit\n\n" % tree_filename.replace("\\", "/").split("/")[-1])
+    f.write("#ifndef %s\n" % guard)
+    f.write("#define %s\n\n" % guard)
+    f.write("#include <stdint.h>\n")
+    f.write("#include <string.h>\n\n")
+    write_constants(f, root)
+    write_accessors(f, root)
+    f.write("#endif\n")
+    f.close()
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.stderr.write("usage: %s <tree.json> [<output.h>]\n" % sys.argv[0])
+        sys.exit(1)
+    tree_filename = sys.argv[1]
+    if len(sys.argv) > 2:
+        header_filename = sys.argv[2]
+    else:
+        header_filename = re.sub(r"\.json$", "", tree_filename) + "_accessors.h"
+    generate(tree_filename, header_filename)
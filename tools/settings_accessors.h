@@ -0,0 +1,274 @@
+// generated by accessor_gen.py from settings.json, do not edit
+
+#ifndef _SETTINGS_ACCESSORS_H_
+#define _SETTINGS_ACCESSORS_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// node offsets are from the start of the tree data with all array indices at 0
+#define KOW_SETTINGS_OFFSET 0
+#define KOW_SETTINGS_STRIDE 152
+#define KOW_SETTINGS_COUNT 1
+#define KOW_SETTINGS_SIZE 152
+#define KOW_SETTINGS_FLUX_CAPACITOR_OFFSET 0
+#define KOW_SETTINGS_FLUX_CAPACITOR_STRIDE 44
+#define KOW_SETTINGS_FLUX_CAPACITOR_COUNT 2
+#define KOW_SETTINGS_FLUX_CAPACITOR_SIZE 88
+#define KOW_SETTINGS_FLUX_CAPACITOR_OWNER_OFFSET 0
+#define KOW_SETTINGS_FLUX_CAPACITOR_OWNER_STRIDE 1
+#define KOW_SETTINGS_FLUX_CAPACITOR_OWNER_COUNT 12
+#define KOW_SETTINGS_FLUX_CAPACITOR_OWNER_SIZE 12
+#define KOW_SETTINGS_FLUX_CAPACITOR_FREQUENCY_OFFSET 12
+#define KOW_SETTINGS_FLUX_CAPACITOR_FREQUENCY_STRIDE 4
+#define KOW_SETTINGS_FLUX_CAPACITOR_FREQUENCY_COUNT 1
+#define KOW_SETTINGS_FLUX_CAPACITOR_FREQUENCY_SIZE 4
+#define KOW_SETTINGS_FLUX_CAPACITOR_GAIN_OFFSET 16
+#define KOW_SETTINGS_FLUX_CAPACITOR_GAIN_STRIDE 4
+#define KOW_SETTINGS_FLUX_CAPACITOR_GAIN_COUNT 1
+#define KOW_SETTINGS_FLUX_CAPACITOR_GAIN_SIZE 4
+#define KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_OFFSET 20
+#define KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_STRIDE 4
+#define KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_COUNT 6
+#define KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_SIZE 24
+#define KOW_SETTINGS_OVEN_OFFSET 88
+#define KOW_SETTINGS_OVEN_STRIDE 4
+#define KOW_SETTINGS_OVEN_COUNT 1
+#define KOW_SETTINGS_OVEN_SIZE 4
+#define KOW_SETTINGS_OVEN_TEMP_OFFSET 88
+#define KOW_SETTINGS_OVEN_TEMP_STRIDE 2
+#define KOW_SETTINGS_OVEN_TEMP_COUNT 1
+#define KOW_SETTINGS_OVEN_TEMP_SIZE 2
+#define KOW_SETTINGS_OVEN_TIMEOUT_OFFSET 90
+#define KOW_SETTINGS_OVEN_TIMEOUT_STRIDE 2
+#define KOW_SETTINGS_OVEN_TIMEOUT_COUNT 1
+#define KOW_SETTINGS_OVEN_TIMEOUT_SIZE 2
+#define KOW_SETTINGS_UNION_CONTAINER_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_STRIDE 28
+#define KOW_SETTINGS_UNION_CONTAINER_COUNT 2
+#define KOW_SETTINGS_UNION_CONTAINER_SIZE 56
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE 12
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_COUNT 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_SIZE 24
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TEMP_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TEMP_STRIDE 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TEMP_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TEMP_SIZE 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_STRIDE 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_SIZE 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_BEEP_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_BEEP_STRIDE 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_BEEP_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_BEEP_SIZE 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_STRIDE 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_COUNT 12
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_SIZE 12
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_STRIDE 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_SIZE 2
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_OFFSET 92
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_STRIDE 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_SIZE 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_OFFSET 93
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_STRIDE 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_SIZE 1
+#define KOW_SETTINGS_UNION_CONTAINER_CHECK_OFFSET 116
+#define KOW_SETTINGS_UNION_CONTAINER_CHECK_STRIDE 4
+#define KOW_SETTINGS_UNION_CONTAINER_CHECK_COUNT 1
+#define KOW_SETTINGS_UNION_CONTAINER_CHECK_SIZE 4
+#define KOW_SETTINGS_CHECK_OFFSET 148
+#define KOW_SETTINGS_CHECK_STRIDE 4
+#define KOW_SETTINGS_CHECK_COUNT 1
+#define KOW_SETTINGS_CHECK_SIZE 4
+#define KOW_SETTINGS_NODE_COUNT 26
+
+static inline char settings_flux_capacitor_owner_get(const void* data, int flux_capacitor_index, int owner_index)
+{
+    char value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_FLUX_CAPACITOR_OWNER_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE + owner_index * KOW_SETTINGS_FLUX_CAPACITOR_OWNER_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_flux_capacitor_owner_set(void* data, int flux_capacitor_index, int owner_index, char value)
+{
+    memcpy((char*)data + KOW_SETTINGS_FLUX_CAPACITOR_OWNER_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE + owner_index * KOW_SETTINGS_FLUX_CAPACITOR_OWNER_STRIDE, &value, sizeof(value));
+}
+
+static inline uint32_t settings_flux_capacitor_frequency_get(const void* data, int flux_capacitor_index)
+{
+    uint32_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_FLUX_CAPACITOR_FREQUENCY_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_flux_capacitor_frequency_set(void* data, int flux_capacitor_index, uint32_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_FLUX_CAPACITOR_FREQUENCY_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE, &value, sizeof(value));
+}
+
+static inline uint32_t settings_flux_capacitor_gain_get(const void* data, int flux_capacitor_index)
+{
+    uint32_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_FLUX_CAPACITOR_GAIN_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_flux_capacitor_gain_set(void* data, int flux_capacitor_index, uint32_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_FLUX_CAPACITOR_GAIN_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE, &value, sizeof(value));
+}
+
+static inline float settings_flux_capacitor_coefficient_get(const void* data, int flux_capacitor_index, int coefficient_index)
+{
+    float value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE + coefficient_index * KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_flux_capacitor_coefficient_set(void* data, int flux_capacitor_index, int coefficient_index, float value)
+{
+    memcpy((char*)data + KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_OFFSET + flux_capacitor_index * KOW_SETTINGS_FLUX_CAPACITOR_STRIDE + coefficient_index * KOW_SETTINGS_FLUX_CAPACITOR_COEFFICIENT_STRIDE, &value, sizeof(value));
+}
+
+static inline int16_t settings_oven_temp_get(const void* data)
+{
+    int16_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_OVEN_TEMP_OFFSET, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_oven_temp_set(void* data, int16_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_OVEN_TEMP_OFFSET, &value, sizeof(value));
+}
+
+static inline uint16_t settings_oven_timeout_get(const void* data)
+{
+    uint16_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_OVEN_TIMEOUT_OFFSET, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_oven_timeout_set(void* data, uint16_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_OVEN_TIMEOUT_OFFSET, &value, sizeof(value));
+}
+
+static inline int16_t settings_union_container_union_temp_get(const void* data, int union_container_index, int union_index)
+{
+    int16_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_TEMP_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_union_temp_set(void* data, int union_container_index, int union_index, int16_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_TEMP_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, &value, sizeof(value));
+}
+
+static inline uint16_t settings_union_container_union_timeout_get(const void* data, int union_container_index, int union_index)
+{
+    uint16_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_union_timeout_set(void* data, int union_container_index, int union_index, uint16_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_TIMEOUT_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, &value, sizeof(value));
+}
+
+static inline uint8_t settings_union_container_union_beep_get(const void* data, int union_container_index, int union_index)
+{
+    uint8_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_BEEP_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_union_beep_set(void* data, int union_container_index, int union_index, uint8_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_BEEP_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, &value, sizeof(value));
+}
+
+static inline char settings_union_container_union_owner_get(const void* data, int union_container_index, int union_index, int owner_index)
+{
+    char value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE + owner_index * KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_union_owner_set(void* data, int union_container_index, int union_index, int owner_index, char value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE + owner_index * KOW_SETTINGS_UNION_CONTAINER_UNION_OWNER_STRIDE, &value, sizeof(value));
+}
+
+static inline uint8_t settings_union_container_union_parts_part1_get(const void* data, int union_container_index, int union_index)
+{
+    uint8_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_union_parts_part1_set(void* data, int union_container_index, int union_index, uint8_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART1_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, &value, sizeof(value));
+}
+
+static inline uint8_t settings_union_container_union_parts_part2_get(const void* data, int union_container_index, int union_index)
+{
+    uint8_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_union_parts_part2_set(void* data, int union_container_index, int union_index, uint8_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE + union_index * KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE, &value, sizeof(value));
+}
+
+static inline uint32_t settings_union_container_check_get(const void* data, int union_container_index)
+{
+    uint32_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_UNION_CONTAINER_CHECK_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_union_container_check_set(void* data, int union_container_index, uint32_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_UNION_CONTAINER_CHECK_OFFSET + union_container_index * KOW_SETTINGS_UNION_CONTAINER_STRIDE, &value, sizeof(value));
+}
+
+static inline uint32_t settings_check_get(const void* data)
+{
+    uint32_t value;
+    memcpy(&value, (const char*)data + KOW_SETTINGS_CHECK_OFFSET, sizeof(value));
+    return value;
+}
+
+// writes the data directly, a sequence lock, change tracker or snapshot registered for it is not used (see kowhai_write)
+static inline void settings_check_set(void* data, uint32_t value)
+{
+    memcpy((char*)data + KOW_SETTINGS_CHECK_OFFSET, &value, sizeof(value));
+}
+
+#endif
@@ -4,6 +4,8 @@
 
 #include "../src/kowhai.h"
 #include "../src/kowhai_utils.h"
+#include "../src/kowhai_journal.h"
+#include "../src/kowhai_mapped.h"
 #include "../src/kowhai_protocol.h"
 #include "../src/kowhai_protocol_server.h"
 #include "../src/kowhai_serialize.h"
@@ -18,6 +20,7 @@
 #include <time.h>
 #include <float.h>
 #include <math.h>
+#include <stddef.h>
 
 #define COUNT_OF(x) ((sizeof(x)/sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
 
@@ -27,6 +30,12 @@
 
 #include "symbols.h"
 
+//
+// generated node offsets and accessors (see accessor_gen.py and settings.json)
+//
+
+#include "settings_accessors.h"
+
 //
 // settings tree descriptor
 //
@@ -232,6 +241,46 @@ struct scope_data_t
 
 #pragma pack()
 
+//
+// aligned tree descriptor and (non packed) struct
+//
+
+struct kowhai_node_t aligned_descriptor[] =
+{
+    { KOW_BRANCH_START,     SYM_BIG,            1,                 0 },
+    { KOW_UINT8,            SYM_STATUS,         1,                 0 },
+    { KOW_UINT32,           SYM_TIME,           1,                 0 },
+    { KOW_UINT16,           SYM_COEFFICIENT,    3,                 0 },
+    { KOW_BRANCH_START,     SYM_PARTS,          2,                 0 },
+    { KOW_UINT8,            SYM_PART1,          1,                 0 },
+    { KOW_FLOAT,            SYM_PART2,          1,                 0 },
+    { KOW_BRANCH_END,       SYM_PARTS,          0,                 0 },
+    { KOW_BRANCH_U_START,   SYM_UNION,          1,                 0 },
+    { KOW_UINT8,            SYM_BEEP,           1,                 0 },
+    { KOW_UINT16,           SYM_TIMEOUT,        1,                 0 },
+    { KOW_BRANCH_END,       SYM_UNION,          0,                 0 },
+    { KOW_UINT8,            SYM_CHECK,          1,                 0 },
+    { KOW_BRANCH_END,       SYM_BIG,            0,                 0 },
+};
+
+struct aligned_data_t
+{
+    uint8_t status;
+    uint32_t time;
+    uint16_t coefficient[3];
+    struct
+    {
+        uint8_t part1;
+        float part2;
+    } parts[2];
+    union
+    {
+        uint8_t beep;
+        uint16_t timeout;
+    } union_;
+    uint8_t check;
+};
+
 //
 // test commands
 //
@@ -259,6 +308,8 @@ struct beep_data_t beepd;
 struct kowhai_tree_t beep_tree = {beep_descriptor, &beepd};
 struct scope_data_t scope;
 struct kowhai_tree_t scope_tree = {scope_descriptor, &scope};
+struct aligned_data_t aligned;
+struct kowhai_tree_t aligned_tree = {aligned_descriptor, &aligned};
 
 //
 // test server structures
@@ -317,6 +368,31 @@ union kowhai_symbol_t symbols18[] = {SYM_SETTINGS, SYM_UNIONCONTAINER, SYM_CHECK
 union kowhai_symbol_t symbols19[] = {SYM_SETTINGS, KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), SYM_CHECK};
 union kowhai_symbol_t symbols99[] = {SYM_SETTINGS, SYM_CHECK};
 
+struct dirty_list_t
+{
+    int count;
+    const struct kowhai_dirty_entry_t* entries[16];
+};
+int on_dirty(void* param, const struct kowhai_dirty_entry_t *entry)
+{
+    struct dirty_list_t* list = (struct dirty_list_t*)param;
+    if (list->count >= COUNT_OF(list->entries))
+        return KOW_STATUS_TARGET_BUFFER_TOO_SMALL;
+    list->entries[list->count++] = entry;
+    return KOW_STATUS_OK;
+}
+
+int count_diffs(void* param, const struct kowhai_node_t *left_node, void *left_data, const struct kowhai_node_t *right_node, void *right_data, int index, int depth)
+{
+    (*(int*)param)++;
+    return KOW_STATUS_OK;
+}
+
+char* get_symbol_name(void* param, uint16_t symbol)
+{
+    return symbols[symbol];
+}
+
 void core_tests()
 {
     int offset;
@@ -365,6 +441,61 @@ void core_tests()
 
     printf(" passed!\n");
 
+    // test compiled descriptor
+    printf("test kowhai_descriptor_compile...\t");
+    {
+        struct kowhai_index_t index;
+        struct kowhai_index_entry_t entries[COUNT_OF(settings_descriptor)];
+        uint16_t symbol_table[COUNT_OF(settings_descriptor) * 2];
+        assert(kowhai_descriptor_compile(settings_descriptor, &index, entries, COUNT_OF(settings_descriptor) - 1, symbol_table, COUNT_OF(symbol_table)) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        assert(kowhai_descriptor_compile(settings_descriptor, &index, entries, COUNT_OF(entries), symbol_table, COUNT_OF(settings_descriptor)) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        assert(kowhai_descriptor_get_index(settings_descriptor) == NULL);
+        assert(kowhai_descriptor_compile(settings_descriptor, &index, entries, COUNT_OF(entries), symbol_table, COUNT_OF(symbol_table)) == KOW_STATUS_OK);
+        assert(kowhai_descriptor_get_index(&settings_descriptor[8]) == &index);
+        assert(index.node_count == COUNT_OF(settings_descriptor));
+        assert(entries[0].size == sizeof(struct settings_data_t));
+        assert(entries[1].stride == sizeof(struct flux_capacitor_t));
+        assert(entries[1].node_count == 6);
+        assert(kowhai_get_node(settings_tree.desc, 3, symbols1, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, oven.temp));
+        assert(node == &settings_descriptor[8]);
+        assert(kowhai_get_node(settings_tree.desc, 2, symbols4, &offset, &node) == KOW_STATUS_INVALID_SYMBOL_PATH);
+        assert(kowhai_get_node(settings_tree.desc, 3, symbols9, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, flux_capacitor[1].coefficient[3]));
+        assert(node == &settings_descriptor[5]);
+        assert(kowhai_get_node(settings_tree.desc, 2, symbols12, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, flux_capacitor[1]));
+        assert(kowhai_get_node(settings_tree.desc, COUNT_OF(symbols15), symbols15, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, union_container[0].union_[0].timeout));
+        assert(kowhai_get_node(settings_tree.desc, COUNT_OF(symbols19), symbols19, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, union_container[1].check));
+        assert(kowhai_get_node(settings_tree.desc, COUNT_OF(symbols99), symbols99, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, check));
+        kowhai_descriptor_release(&index);
+        assert(kowhai_descriptor_get_index(settings_descriptor) == NULL);
+
+        // size/count cache only
+        assert(kowhai_descriptor_compile(settings_descriptor, &index, entries, COUNT_OF(entries), NULL, 0) == KOW_STATUS_OK);
+        assert(kowhai_get_node_size(settings_tree.desc, &size) == KOW_STATUS_OK);
+        assert(size == sizeof(struct settings_data_t));
+        assert(kowhai_get_node_count(settings_tree.desc, &count) == KOW_STATUS_OK);
+        assert(count == COUNT_OF(settings_descriptor));
+        assert(kowhai_get_node_count(&settings_tree.desc[2], &count) == KOW_STATUS_OK);
+        assert(count == 1);
+        assert(kowhai_get_node_size(&settings_descriptor[12], &size) == KOW_STATUS_OK);
+        assert(size == sizeof(union union_t) * UNION_COUNT);
+        assert(kowhai_get_node(settings_tree.desc, COUNT_OF(symbols19), symbols19, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == offsetof(struct settings_data_t, union_container[1].check));
+        // the cached values are used rather than walking the descriptor
+        entries[0].size = 1234;
+        assert(kowhai_get_node_size(settings_tree.desc, &size) == KOW_STATUS_OK);
+        assert(size == 1234);
+        kowhai_descriptor_release(&index);
+        assert(kowhai_get_node_size(settings_tree.desc, &size) == KOW_STATUS_OK);
+        assert(size == sizeof(struct settings_data_t));
+    }
+    printf(" passed!\n");
+
     // test get node size
     printf("test kowhai_get_node_size & kowhai_get_node_count...\t\t");
     assert(kowhai_get_node_size(settings_tree.desc, &size) == KOW_STATUS_OK);
@@ -462,11 +593,627 @@ void core_tests()
     assert(kowhai_get_int32(&settings_tree, COUNT_OF(symbols19), symbols19, &check) == KOW_STATUS_OK);
     assert(check == 20);
     printf(" passed!\n");
-}
 
-char* get_symbol_name(void* param, uint16_t symbol)
-{
-    return symbols[symbol];
+    // test resolved node handles
+    printf("test kowhai_resolve/kowhai_handle_xxx...\t");
+    {
+        struct settings_data_t saved_settings = settings;
+        struct kowhai_handle_t handle;
+        float coeffs[COEFF_COUNT - 3];
+        assert(kowhai_resolve(&settings_tree, 2, symbols4, &handle) == KOW_STATUS_INVALID_SYMBOL_PATH);
+        assert(kowhai_resolve(&settings_tree, 3, symbols9, &handle) == KOW_STATUS_OK);
+        assert(handle.offset == offsetof(struct settings_data_t, flux_capacitor[1].coefficient[3]));
+        assert(handle.element_size == sizeof(float));
+        assert(handle.count == COEFF_COUNT - 3);
+        assert(kowhai_handle_set_float(&handle, 123.4f) == KOW_STATUS_OK);
+        assert(settings.flux_capacitor[1].coefficient[3] == 123.4f);
+        assert(kowhai_handle_get_float(&handle, &coeff) == KOW_STATUS_OK);
+        assert(coeff == 123.4f);
+        assert(kowhai_handle_set_int32(&handle, 1) == KOW_STATUS_INVALID_NODE_TYPE);
+        assert(kowhai_handle_read(&handle, 0, coeffs, sizeof(coeffs)) == KOW_STATUS_OK);
+        assert(coeffs[0] == 123.4f && coeffs[2] == settings.flux_capacitor[1].coefficient[5]);
+        assert(kowhai_handle_read(&handle, sizeof(float), coeffs, sizeof(coeffs)) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        assert(kowhai_handle_read(&handle, -1, coeffs, sizeof(float)) == KOW_STATUS_INVALID_OFFSET);
+        coeffs[2] = 5.5f;
+        assert(kowhai_handle_write(&handle, 0, coeffs, sizeof(coeffs)) == KOW_STATUS_OK);
+        assert(settings.flux_capacitor[1].coefficient[5] == 5.5f);
+        assert(kowhai_resolve(&settings_tree, COUNT_OF(symbols14), symbols14, &handle) == KOW_STATUS_OK);
+        assert(kowhai_handle_set_int16(&handle, 4321) == KOW_STATUS_OK);
+        assert(settings.union_container[0].union_[0].temp == 4321);
+        assert(kowhai_handle_get_int16(&handle, (int16_t*)&temp) == KOW_STATUS_OK);
+        assert(temp == 4321);
+        assert(kowhai_resolve(&shadow_tree, 2, symbols5, &handle) == KOW_STATUS_OK);
+        assert(kowhai_handle_set_int8(&handle, 7) == KOW_STATUS_OK);
+        assert(shadow.status == 7);
+        // the settings are shared with the later tests, leave them as they were
+        settings = saved_settings;
+    }
+    printf(" passed!\n");
+
+    // test batch read/write
+    printf("test kowhai_read_batch/kowhai_write_batch...\t");
+    {
+        struct settings_data_t saved_settings = settings;
+        uint32_t gain0 = 11, gain1 = 22, check0 = 0;
+        float coeffs[2] = {1.5f, 2.5f};
+        struct kowhai_batch_item_t items[] =
+        {
+            { COUNT_OF(symbols99), symbols99, 0, &check, sizeof(check), 0, 0 },
+            { COUNT_OF(symbols8), symbols8, 0, &gain1, sizeof(gain1), 0, 0 },
+            { COUNT_OF(symbols9), symbols9, 0, coeffs, sizeof(coeffs), 0, 0 },
+            { COUNT_OF(symbols6), symbols6, 0, &gain0, sizeof(gain0), 0, 0 },
+            { COUNT_OF(symbols18), symbols18, 0, &check0, sizeof(check0), 0, 0 },
+        };
+        check = 77;
+        assert(kowhai_write_batch(&settings_tree, COUNT_OF(items), items) == KOW_STATUS_OK);
+        assert(settings.check == 77);
+        assert(settings.flux_capacitor[0].gain == 11 && settings.flux_capacitor[1].gain == 22);
+        assert(settings.flux_capacitor[1].coefficient[3] == 1.5f && settings.flux_capacitor[1].coefficient[4] == 2.5f);
+        assert(settings.union_container[0].check == 0);
+        // items come back in tree data order
+        assert(items[0].data_offset == offsetof(struct settings_data_t, flux_capacitor[0].gain));
+        assert(items[COUNT_OF(items) - 1].data_offset == offsetof(struct settings_data_t, check));
+        gain0 = gain1 = check = 0;
+        coeffs[0] = coeffs[1] = 0;
+        settings.union_container[0].check = 33;
+        assert(kowhai_read_batch(&settings_tree, COUNT_OF(items), items) == KOW_STATUS_OK);
+        assert(gain0 == 11 && gain1 == 22 && check == 77 && check0 == 33);
+        assert(coeffs[0] == 1.5f && coeffs[1] == 2.5f);
+        // nothing is written if any item is invalid
+        items[1].size = sizeof(float) * 4;
+        gain0 = 99;
+        assert(kowhai_write_batch(&settings_tree, COUNT_OF(items), items) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        assert(settings.flux_capacitor[0].gain == 11);
+        items[1].size = sizeof(uint32_t);
+        items[2].num_symbols = COUNT_OF(symbols4);
+        items[2].symbols = symbols4;
+        assert(kowhai_read_batch(&settings_tree, COUNT_OF(items), items) == KOW_STATUS_INVALID_SYMBOL_PATH);
+        assert(items[2].status == KOW_STATUS_INVALID_SYMBOL_PATH);
+        // same again with a compiled descriptor
+        {
+            struct kowhai_index_t index;
+            struct kowhai_index_entry_t entries[COUNT_OF(settings_descriptor)];
+            uint16_t symbol_table[COUNT_OF(settings_descriptor) * 2];
+            assert(kowhai_descriptor_compile(settings_descriptor, &index, entries, COUNT_OF(entries), symbol_table, COUNT_OF(symbol_table)) == KOW_STATUS_OK);
+            assert(kowhai_read_batch(&settings_tree, COUNT_OF(items), items) == KOW_STATUS_INVALID_SYMBOL_PATH);
+            items[2].num_symbols = COUNT_OF(symbols9);
+            items[2].symbols = symbols9;
+            gain0 = gain1 = check = check0 = 0;
+            assert(kowhai_read_batch(&settings_tree, COUNT_OF(items), items) == KOW_STATUS_OK);
+            assert(gain0 == 11 && gain1 == 22 && check == 77 && check0 == 33);
+            kowhai_descriptor_release(&index);
+        }
+        // overlapping writes are refused
+        {
+            struct kowhai_batch_item_t overlapping[] =
+            {
+                { COUNT_OF(symbols6), symbols6, 0, &gain0, sizeof(gain0), 0, 0 },
+                { COUNT_OF(symbols6), symbols6, 2, &gain1, 2, 0, 0 },
+            };
+            gain0 = 5;
+            assert(kowhai_write_batch(&settings_tree, COUNT_OF(overlapping), overlapping) == KOW_STATUS_INVALID_OFFSET);
+            assert(settings.flux_capacitor[0].gain == 11);
+            assert(kowhai_read_batch(&settings_tree, COUNT_OF(overlapping), overlapping) == KOW_STATUS_OK);
+        }
+        settings = saved_settings;
+    }
+    printf(" passed!\n");
+
+    // test array slices
+    printf("test array slices...\t\t\t");
+    {
+        union kowhai_symbol_t pixels[] = {KOWHAI_SYMBOL(SYM_SCOPE, 0), KOWHAI_SYMBOL(SYM_PIXELS, 100), KOWHAI_SLICE(64)};
+        union kowhai_symbol_t bad_slice[] = {KOWHAI_SYMBOL(SYM_SCOPE, 0), KOWHAI_SYMBOL(SYM_PIXELS, NUM_PIXELS - 10), KOWHAI_SLICE(11)};
+        union kowhai_symbol_t empty_slice[] = {KOWHAI_SYMBOL(SYM_SCOPE, 0), KOWHAI_SYMBOL(SYM_PIXELS, 100), KOWHAI_SLICE(0)};
+        struct kowhai_handle_t handle;
+        uint16_t buf[65];
+        int i;
+        for (i = 0; i < NUM_PIXELS; i++)
+            scope.pixels[i] = i;
+        assert(kowhai_get_node(scope_descriptor, COUNT_OF(pixels), pixels, &offset, &node) == KOW_STATUS_OK);
+        assert(offset == 100 * sizeof(uint16_t) && node == &scope_descriptor[1]);
+        assert(kowhai_get_path_size(node, COUNT_OF(pixels), pixels, &size) == KOW_STATUS_OK);
+        assert(size == 64 * sizeof(uint16_t));
+        assert(kowhai_get_path_size(node, 2, pixels, &size) == KOW_STATUS_OK);
+        assert(size == (NUM_PIXELS - 100) * sizeof(uint16_t));
+        assert(kowhai_get_path_size(node, COUNT_OF(bad_slice), bad_slice, &size) == KOW_STATUS_INVALID_SYMBOL_PATH);
+        assert(kowhai_get_path_size(node, COUNT_OF(empty_slice), empty_slice, &size) == KOW_STATUS_INVALID_SYMBOL_PATH);
+        // macro arguments may be expressions
+        assert(KOWHAI_SLICE(32 + 32) == KOWHAI_SLICE(64) && KOWHAI_SYMBOL(SYM_PIXELS, 50 + 50) == pixels[1].symbol);
+        // reads and writes must fit in the slice
+        assert(kowhai_read(&scope_tree, COUNT_OF(pixels), pixels, 0, buf, 65 * sizeof(uint16_t)) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        assert(kowhai_read(&scope_tree, COUNT_OF(pixels), pixels, 2, buf, 64 * sizeof(uint16_t)) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        assert(kowhai_read(&scope_tree, COUNT_OF(pixels), pixels, 0, buf, 64 * sizeof(uint16_t)) == KOW_STATUS_OK);
+        assert(buf[0] == 100 && buf[63] == 163);
+        assert(kowhai_read(&scope_tree, COUNT_OF(bad_slice), bad_slice, 0, buf, sizeof(uint16_t)) == KOW_STATUS_INVALID_SYMBOL_PATH);
+        for (i = 0; i < 64; i++)
+            buf[i] = 1000 + i;
+        assert(kowhai_write(&scope_tree, COUNT_OF(pixels), pixels, 0, buf, 65 * sizeof(uint16_t)) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        assert(kowhai_write(&scope_tree, COUNT_OF(pixels), pixels, 0, buf, 64 * sizeof(uint16_t)) == KOW_STATUS_OK);
+        assert(scope.pixels[99] == 99 && scope.pixels[100] == 1000 && scope.pixels[163] == 1063 && scope.pixels[164] == 164);
+        // handles address just the slice
+        assert(kowhai_resolve(&scope_tree, COUNT_OF(pixels), pixels, &handle) == KOW_STATUS_OK);
+        assert(handle.offset == 100 * sizeof(uint16_t) && handle.count == 64);
+    }
+    printf(" passed!\n");
+
+    // test walking a tree
+    printf("test kowhai_walk...\t\t\t");
+    {
+        struct kowhai_walk_t walk;
+        struct kowhai_walk_frame_t frames[4];
+        union kowhai_symbol_t path[5];
+        int leafs = 0, max_depth = 0, skipped = 0, path_len;
+        assert(kowhai_walk_init(&walk, settings_descriptor, &settings, frames, COUNT_OF(frames)) == KOW_STATUS_OK);
+        assert(kowhai_walk_next(&walk) == KOW_STATUS_OK);
+        assert(walk.event == KOW_WALK_BRANCH_START && walk.node == settings_descriptor && walk.depth == 0 && walk.data == &settings);
+        while (kowhai_walk_next(&walk) == KOW_STATUS_OK)
+        {
+            if (walk.depth > max_depth)
+                max_depth = walk.depth;
+            switch (walk.event)
+            {
+                case KOW_WALK_LEAF:
+                    // the walk path addresses the leaf data
+                    path_len = COUNT_OF(path);
+                    assert(kowhai_walk_get_path(&walk, path, &path_len) == KOW_STATUS_OK && path_len == walk.depth + 1);
+                    assert(kowhai_get_node(settings_descriptor, path_len, path, &offset, &node) == KOW_STATUS_OK);
+                    assert(node == walk.node && offset == walk.offset);
+                    assert((char*)walk.data == (char*)&settings + offset);
+                    assert(walk.size == kowhai_get_node_type_size(node->type) * node->count);
+                    leafs++;
+                    break;
+                case KOW_WALK_BRANCH_START:
+                    // skip the second flux capacitor
+                    if (walk.node->symbol == SYM_FLUXCAPACITOR && walk.index == 1)
+                    {
+                        assert(walk.offset == offsetof(struct settings_data_t, flux_capacitor[1]));
+                        assert(kowhai_walk_skip(&walk) == KOW_STATUS_OK);
+                        assert(kowhai_walk_next(&walk) == KOW_STATUS_OK);
+                        assert(walk.event == KOW_WALK_BRANCH_END && walk.node->symbol == SYM_FLUXCAPACITOR && walk.index == 1);
+                        assert(walk.size == sizeof(struct flux_capacitor_t));
+                        skipped++;
+                    }
+                    break;
+                case KOW_WALK_BRANCH_END:
+                    assert(kowhai_walk_skip(&walk) == KOW_STATUS_INVALID_SEQUENCE);
+                    break;
+            }
+        }
+        assert(skipped == 1 && max_depth == 4);
+        assert(leafs == (FLUX_CAP_COUNT - 1) * 4 + 2 + UNION_COUNT * (UNION_COUNT * 6 + 1) + 1);
+        assert(kowhai_walk_next(&walk) == KOW_STATUS_NOT_FOUND);
+    }
+    {
+        // deep trees are resolved and walked (each level is a branch holding a byte and the next level)
+        #define DEEP_LEVELS 40
+        struct kowhai_walk_t walk;
+        struct kowhai_walk_frame_t frames[2], more[DEEP_LEVELS];
+        struct kowhai_node_t deep[DEEP_LEVELS * 3 + 1];
+        union kowhai_symbol_t path[DEEP_LEVELS + 1], found[DEEP_LEVELS + 1];
+        uint8_t deep_data[DEEP_LEVELS + 16], other_data[DEEP_LEVELS + 16];
+        struct kowhai_tree_t deep_tree = {deep, deep_data}, other_tree = {deep, other_data};
+        struct kowhai_dirty_entry_t entries[DEEP_LEVELS + 4];
+        struct kowhai_dirty_t dirty;
+        static char js[0x8000];
+        int i, levels = COUNT_OF(frames), leafs = 0, diffs = 0, found_len = COUNT_OF(found), entry_count = COUNT_OF(entries);
+        for (i = 0; i < DEEP_LEVELS; i++)
+        {
+            struct kowhai_node_t start = {KOW_BRANCH_START, SYM_PARTS, 1, 0}, leaf = {KOW_UINT8, SYM_PART1, 1, 0}, end = {KOW_BRANCH_END, SYM_PARTS, 0, 0};
+            start.count = i == DEEP_LEVELS - 1 ? 2 : 1;
+            deep[i * 2] = start;
+            deep[i * 2 + 1] = leaf;
+            deep[DEEP_LEVELS * 3 - i] = end;
+            path[i].symbol = KOWHAI_SYMBOL(SYM_PARTS, i == DEEP_LEVELS - 1 ? 1 : 0);
+        }
+        deep[DEEP_LEVELS * 2].type = KOW_UINT32;
+        deep[DEEP_LEVELS * 2].symbol = SYM_PART2;
+        deep[DEEP_LEVELS * 2].count = 1;
+        deep[DEEP_LEVELS * 2].tag = 0;
+        path[DEEP_LEVELS].symbol = KOWHAI_SYMBOL(SYM_PART2, 0);
+        assert(kowhai_get_node_size(deep, &size) == KOW_STATUS_OK);
+        assert(size == DEEP_LEVELS - 1 + 2 * (1 + 4));
+        assert(kowhai_get_node(deep, COUNT_OF(path), path, &offset, &node) == KOW_STATUS_OK);
+        assert(node == &deep[DEEP_LEVELS * 2] && offset == DEEP_LEVELS - 1 + (1 + 4) + 1);
+        // a walk without enough frames stops and carries on once given another
+        assert(kowhai_walk_init(&walk, deep, NULL, frames, COUNT_OF(frames)) == KOW_STATUS_OK);
+        while ((i = kowhai_walk_next(&walk)) != KOW_STATUS_NOT_FOUND)
+        {
+            if (i == KOW_STATUS_TREE_TOO_DEEP)
+            {
+                assert(levels < DEEP_LEVELS);
+                kowhai_walk_add_frame(&walk, &more[levels++]);
+                continue;
+            }
+            assert(i == KOW_STATUS_OK);
+            if (walk.event == KOW_WALK_LEAF)
+                leafs++;
+        }
+        assert(levels == DEEP_LEVELS && leafs == DEEP_LEVELS - 1 + 2 * 2);
+        // and so are the utilities built on the walk
+        memset(deep_data, 0, sizeof(deep_data));
+        memset(other_data, 0, sizeof(other_data));
+        deep_data[offset] = 1;
+        assert(kowhai_diff(&deep_tree, &other_tree, &diffs, count_diffs) == KOW_STATUS_OK && diffs == 1);
+        assert(kowhai_merge(&other_tree, &deep_tree) == KOW_STATUS_OK && other_data[offset] == 1);
+        assert(kowhai_create_symbol_path2(&deep_tree, &deep_data[offset], found, &found_len) == KOW_STATUS_OK);
+        assert(found_len == COUNT_OF(path) && memcmp(found, path, sizeof(path)) == 0);
+        size = sizeof(js);
+        assert(kowhai_serialize_tree(deep_tree, js, &size, NULL, get_symbol_name) == KOW_STATUS_OK);
+        size = sizeof(js);
+        assert(kowhai_serialize_nodes(js, &size, &deep_tree, found, COUNT_OF(found), NULL, get_symbol_name) == KOW_STATUS_OK);
+        assert(kowhai_dirty_init(&dirty, &deep_tree, entries, &entry_count) == KOW_STATUS_OK && entry_count == DEEP_LEVELS - 1 + 2 * 2);
+        kowhai_dirty_release(&dirty);
+    }
+    printf(" passed!\n");
+
+    // test sequence locked tree data
+    printf("test kowhai_seqlock...\t\t\t");
+    {
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        struct kowhai_seqlock_t lock;
+        struct kowhai_batch_item_t item;
+        struct kowhai_handle_t stale, handle;
+        uint32_t sequence, value = 0, original;
+        assert(kowhai_seqlock_get(&settings) == NULL);
+        assert(kowhai_resolve(&settings_tree, COUNT_OF(gain), gain, &stale) == KOW_STATUS_OK);
+        assert(kowhai_handle_seqlock(&stale) == NULL);
+        assert(kowhai_seqlock_init(&lock, &settings_tree) == KOW_STATUS_OK);
+        assert(kowhai_seqlock_get(&settings) == &lock);
+        assert(kowhai_seqlock_get(&settings.check) == &lock);
+        assert(kowhai_seqlock_get(&settings + 1) == NULL);
+        original = settings.flux_capacitor[1].gain;
+        // every write publishes a new version
+        sequence = kowhai_seqlock_read_begin(&lock);
+        assert(kowhai_seqlock_read_retry(&lock, sequence) == 0);
+        assert(kowhai_set_int32(&settings_tree, COUNT_OF(gain), gain, 1234) == KOW_STATUS_OK);
+        assert(kowhai_seqlock_read_retry(&lock, sequence) != 0);
+        assert(kowhai_seqlock_read_begin(&lock) == sequence + 2);
+        assert(kowhai_get_int32(&settings_tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK);
+        assert(value == 1234 && settings.flux_capacitor[1].gain == 1234);
+        item.num_symbols = COUNT_OF(gain);
+        item.symbols = gain;
+        item.offset = 0;
+        item.buffer = &original;
+        item.size = sizeof(original);
+        assert(kowhai_write_batch(&settings_tree, 1, &item) == KOW_STATUS_OK);
+        assert(kowhai_seqlock_read_begin(&lock) == sequence + 4);
+        // direct writes are published explicitly
+        kowhai_seqlock_write_begin(&lock);
+        assert(lock.sequence & 1);
+        settings.check++;
+        settings.check--;
+        kowhai_seqlock_write_end(&lock);
+        assert(kowhai_seqlock_read_begin(&lock) == sequence + 6);
+        // handles cache the lock when resolved, and find it again if it was registered after they were resolved
+        assert(kowhai_resolve(&settings_tree, COUNT_OF(gain), gain, &handle) == KOW_STATUS_OK);
+        assert(handle.lock == &lock && kowhai_handle_seqlock(&handle) == &lock);
+        assert(stale.lock == NULL && kowhai_handle_seqlock(&stale) == &lock);
+        assert(kowhai_handle_set_int32(&handle, (int32_t)original) == KOW_STATUS_OK);
+        assert(kowhai_handle_set_int32(&stale, (int32_t)original) == KOW_STATUS_OK);
+        assert(kowhai_seqlock_read_begin(&lock) == sequence + 10);
+        kowhai_seqlock_release(&lock);
+        assert(kowhai_seqlock_get(&settings) == NULL);
+        assert(kowhai_handle_seqlock(&handle) == NULL);
+        assert(kowhai_handle_set_int32(&handle, (int32_t)original) == KOW_STATUS_OK);
+        assert(lock.sequence == sequence + 10);
+        assert(settings.flux_capacitor[1].gain == original);
+    }
+    printf(" passed!\n");
+
+    // test dirty tracking
+    printf("test kowhai_dirty...\t\t\t");
+    {
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 0), KOWHAI_SYMBOL(SYM_UNION, 1), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        union kowhai_symbol_t oven[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0)};
+        struct kowhai_dirty_t dirty;
+        struct kowhai_dirty_entry_t entries[64];
+        struct dirty_list_t changed;
+        int i, entry_count = 4;
+        uint32_t synced;
+        int16_t temp_value = settings.union_container[0].union_[1].temp;
+        assert(kowhai_dirty_init(&dirty, &settings_tree, entries, &entry_count) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        assert(entry_count == FLUX_CAP_COUNT * 4 + 2 + UNION_COUNT * (UNION_COUNT * 6 + 1) + 1);
+        entry_count = COUNT_OF(entries);
+        assert(kowhai_dirty_init(&dirty, &settings_tree, entries, &entry_count) == KOW_STATUS_OK);
+        assert(kowhai_dirty_get(&settings.oven) == &dirty);
+        changed.count = 0;
+        assert(kowhai_dirty_enumerate(&dirty, 0, &changed, on_dirty) == KOW_STATUS_OK);
+        assert(changed.count == 0);
+        // a leaf write marks just that leaf
+        assert(kowhai_set_int32(&settings_tree, COUNT_OF(gain), gain, settings.flux_capacitor[1].gain) == KOW_STATUS_OK);
+        assert(kowhai_dirty_enumerate(&dirty, 0, &changed, on_dirty) == KOW_STATUS_OK);
+        assert(changed.count == 1 && changed.entries[0]->node->symbol == SYM_GAIN);
+        assert(changed.entries[0]->offset == offsetof(struct settings_data_t, flux_capacitor[1].gain));
+        synced = dirty.generation;
+        // a union member write marks every member it overlaps (temp, timeout, beep, owner and both parts)
+        assert(kowhai_write(&settings_tree, COUNT_OF(temp), temp, 0, &temp_value, sizeof(temp_value)) == KOW_STATUS_OK);
+        changed.count = 0;
+        assert(kowhai_dirty_enumerate(&dirty, synced, &changed, on_dirty) == KOW_STATUS_OK);
+        assert(changed.count == 6);
+        for (i = 0; i < changed.count; i++)
+            assert(changed.entries[i]->offset == offsetof(struct settings_data_t, union_container[0].union_[1]) + (changed.entries[i]->node->symbol == SYM_PART2));
+        changed.count = 0;
+        assert(kowhai_dirty_enumerate(&dirty, 0, &changed, on_dirty) == KOW_STATUS_OK);
+        assert(changed.count == 7);
+        assert(kowhai_dirty_changed(&dirty, synced, offsetof(struct settings_data_t, union_container[0].union_[1].timeout), 1));
+        assert(!kowhai_dirty_changed(&dirty, synced, offsetof(struct settings_data_t, union_container[0].union_[0]), sizeof(union union_t)));
+        assert(kowhai_dirty_changed(&dirty, 0, 0, sizeof(settings)) && !kowhai_dirty_changed(&dirty, dirty.generation, 0, sizeof(settings)));
+        // a branch write marks all its leaves
+        kowhai_dirty_clear(&dirty);
+        synced = dirty.generation;
+        assert(kowhai_write(&settings_tree, COUNT_OF(oven), oven, 0, &settings.oven, sizeof(settings.oven)) == KOW_STATUS_OK);
+        changed.count = 0;
+        assert(kowhai_dirty_enumerate(&dirty, 0, &changed, on_dirty) == KOW_STATUS_OK);
+        assert(changed.count == 2 && changed.entries[0]->node->symbol == SYM_TEMP && changed.entries[1]->node->symbol == SYM_TIMEOUT);
+        assert(dirty.generation == synced + 1);
+        kowhai_dirty_release(&dirty);
+        assert(kowhai_dirty_get(&settings) == NULL);
+    }
+    printf(" passed!\n");
+
+    // test copy-on-write snapshots
+    printf("test kowhai_snapshot...\t\t\t");
+    {
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        struct kowhai_snapshot_t snapshot;
+        struct kowhai_tree_t snapshot_tree;
+        struct settings_data_t copy;
+        uint8_t saved[(sizeof(settings) + 15) / 16 / 8 + 1];
+        uint32_t original = settings.flux_capacitor[1].gain, value;
+        int i, gain_chunk = offsetof(struct settings_data_t, flux_capacitor[1].gain) / 16;
+        assert(kowhai_snapshot_init(&snapshot, &settings_tree, &copy, sizeof(copy) - 1, saved, sizeof(saved), 16) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        assert(kowhai_snapshot_init(&snapshot, &settings_tree, &copy, sizeof(copy), saved, sizeof(saved), 16) == KOW_STATUS_OK);
+        assert(kowhai_snapshot_get(&settings.check) == &snapshot);
+        assert(kowhai_snapshot_read(&snapshot, 0, &value, sizeof(value)) == KOW_STATUS_INVALID_SEQUENCE);
+        assert(kowhai_snapshot_begin(&snapshot) == KOW_STATUS_OK);
+        assert(kowhai_snapshot_begin(&snapshot) == KOW_STATUS_INVALID_SEQUENCE);
+        assert(kowhai_snapshot_get(&settings) == NULL);
+        // writes copy just the chunks they change
+        assert(kowhai_set_int32(&settings_tree, COUNT_OF(gain), gain, original + 1) == KOW_STATUS_OK);
+        assert(settings.flux_capacitor[1].gain == original + 1);
+        for (i = 0; i < (int)sizeof(saved) * 8; i++)
+            assert(((saved[i / 8] >> (i % 8)) & 1) == (i == gain_chunk));
+        assert(kowhai_snapshot_read(&snapshot, offsetof(struct settings_data_t, flux_capacitor[1].gain), &value, sizeof(value)) == KOW_STATUS_OK);
+        assert(value == original);
+        assert(kowhai_snapshot_read(&snapshot, sizeof(settings) - 1, &value, 2) == KOW_STATUS_NODE_DATA_TOO_SMALL);
+        // the snapshot tree holds the data as it was when the snapshot began
+        assert(kowhai_snapshot_get_tree(&snapshot, &snapshot_tree) == KOW_STATUS_OK);
+        assert(snapshot_tree.data == &copy && copy.flux_capacitor[1].gain == original);
+        assert(memcmp(&copy.oven, &settings.oven, sizeof(settings.oven)) == 0);
+        assert(kowhai_get_int32(&snapshot_tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK);
+        assert(value == original);
+        kowhai_snapshot_end(&snapshot);
+        assert(kowhai_set_int32(&settings_tree, COUNT_OF(gain), gain, original) == KOW_STATUS_OK);
+        kowhai_snapshot_release(&snapshot);
+        assert(kowhai_snapshot_get(&settings) == NULL);
+    }
+    printf(" passed!\n");
+
+    // test memory mapped trees
+    printf("test kowhai_tree_open_mapped...\t\t");
+    {
+        const char* filename = "test_mapped.kow";
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        struct kowhai_mapped_t mapped;
+        struct kowhai_binary_header_t* header;
+        uint32_t value, hash;
+        remove(filename);
+        assert(kowhai_tree_open_mapped(&mapped, filename, NULL, 0) == KOW_STATUS_NOT_FOUND);
+        // a new file has zeroed tree data
+        assert(kowhai_tree_open_mapped(&mapped, filename, settings_descriptor, KOW_MAPPED_STORE_DESCRIPTOR) == KOW_STATUS_OK);
+        assert(mapped.created && mapped.tree.desc == settings_descriptor);
+        assert(kowhai_get_int32(&mapped.tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK && value == 0);
+        memcpy(mapped.tree.data, &settings, sizeof(settings));
+        assert(kowhai_set_int32(&mapped.tree, COUNT_OF(gain), gain, 0x12345678) == KOW_STATUS_OK);
+        header = (struct kowhai_binary_header_t*)mapped.base;
+        assert(kowhai_descriptor_hash(settings_descriptor, &hash) == KOW_STATUS_OK && header->descriptor_hash == hash);
+        assert(header->data_size == sizeof(settings) && header->data_offset % 8 == 0);
+        assert(kowhai_tree_sync_mapped(&mapped) == KOW_STATUS_OK);
+        kowhai_tree_close_mapped(&mapped);
+        // the data survives reopening, with the given or the stored descriptor
+        assert(kowhai_tree_open_mapped(&mapped, filename, settings_descriptor, 0) == KOW_STATUS_OK);
+        assert(!mapped.created);
+        assert(kowhai_get_int32(&mapped.tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK && value == 0x12345678);
+        assert(memcmp(&((struct settings_data_t*)mapped.tree.data)->oven, &settings.oven, sizeof(settings.oven)) == 0);
+        kowhai_tree_close_mapped(&mapped);
+        assert(kowhai_tree_open_mapped(&mapped, filename, NULL, 0) == KOW_STATUS_OK);
+        assert(mapped.tree.desc != settings_descriptor && memcmp(mapped.tree.desc, settings_descriptor, sizeof(settings_descriptor)) == 0);
+        assert(kowhai_get_int32(&mapped.tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK && value == 0x12345678);
+        kowhai_tree_close_mapped(&mapped);
+        // a different descriptor does not match the file
+        assert(kowhai_tree_open_mapped(&mapped, filename, shadow_descriptor, 0) == KOW_STATUS_INVALID_DESCRIPTOR);
+        assert(mapped.base == NULL);
+        remove(filename);
+        // a saved container keeps its checksum, opening it does not write to it and closing brings it up to date
+        {
+            char saved[1024], reread[1024];
+            int saved_size = sizeof(saved);
+            const struct kowhai_node_t* stored = NULL;
+            FILE* f;
+            assert(kowhai_binary_save(&settings_tree, KOW_BINARY_STORE_DESCRIPTOR | KOW_BINARY_CHECKSUM, saved, &saved_size) == KOW_STATUS_OK);
+            f = fopen(filename, "wb");
+            assert(f != NULL && fwrite(saved, 1, saved_size, f) == (size_t)saved_size);
+            fclose(f);
+            assert(kowhai_tree_open_mapped(&mapped, filename, NULL, 0) == KOW_STATUS_OK);
+            assert(memcmp(mapped.base, saved, saved_size) == 0);
+            assert(kowhai_set_int32(&mapped.tree, COUNT_OF(gain), gain, (int32_t)~settings.flux_capacitor[1].gain) == KOW_STATUS_OK);
+            kowhai_tree_close_mapped(&mapped);
+            f = fopen(filename, "rb");
+            assert(f != NULL && fread(reread, 1, saved_size, f) == (size_t)saved_size);
+            fclose(f);
+            assert(((struct kowhai_binary_header_t*)reread)->flags & KOW_BINARY_CHECKSUM);
+            assert(((struct kowhai_binary_header_t*)reread)->checksum != ((struct kowhai_binary_header_t*)saved)->checksum);
+            assert(kowhai_binary_check(reread, saved_size, &stored) == KOW_STATUS_OK);
+            remove(filename);
+        }
+    }
+    printf(" passed!\n");
+
+    // test write ahead journals
+    printf("test kowhai_journal...\t\t\t");
+    {
+        const char* filename = "test_journal.kowj";
+        const char* snapshot_filename = "test_journal.kows";
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        struct settings_data_t journaled;
+        struct kowhai_journal_tree_t trees[1];
+        struct kowhai_journal_t journal;
+        char buffer[sizeof(struct settings_data_t) + 64];
+        struct kowhai_node_t* node;
+        int gain_offset, temp_offset;
+        uint32_t value;
+        int16_t temp_value;
+        FILE* file;
+        remove(filename);
+        remove(snapshot_filename);
+        memcpy(&journaled, &settings, sizeof(settings));
+        trees[0].id = 3;
+        trees[0].tree.desc = settings_descriptor;
+        trees[0].tree.data = &journaled;
+        assert(kowhai_get_node(settings_descriptor, COUNT_OF(gain), gain, &gain_offset, &node) == KOW_STATUS_OK);
+        assert(kowhai_get_node(settings_descriptor, COUNT_OF(temp), temp, &temp_offset, &node) == KOW_STATUS_OK);
+        assert(kowhai_journal_open(&journal, filename, snapshot_filename, trees, 1, buffer, 10, 0) == KOW_STATUS_SCRATCH_TOO_SMALL);
+        // the first open checkpoints the current data
+        assert(kowhai_journal_open(&journal, filename, snapshot_filename, trees, 1, buffer, sizeof(buffer), 0) == KOW_STATUS_OK);
+        assert(journal.generation == 1 && journal.size == sizeof(struct kowhai_journal_header_t));
+        // writes are buffered until a commit
+        assert(kowhai_set_int32(&trees[0].tree, COUNT_OF(gain), gain, 0x12345678) == KOW_STATUS_OK);
+        assert(kowhai_journal_append(&journal, 3, gain_offset, sizeof(uint32_t)) == KOW_STATUS_OK);
+        assert(kowhai_set_int16(&trees[0].tree, COUNT_OF(temp), temp, 321) == KOW_STATUS_OK);
+        kowhai_journal_node_post_write(NULL, &journal, 3, node, temp_offset, sizeof(int16_t));
+        assert(journal.error == KOW_STATUS_OK);
+        assert(kowhai_journal_append(&journal, 4, 0, 1) == KOW_STATUS_NOT_FOUND);
+        // a failed append from the write callback is kept for the application
+        kowhai_journal_node_post_write(NULL, &journal, 4, node, 0, 1);
+        assert(journal.error == KOW_STATUS_NOT_FOUND);
+        journal.error = KOW_STATUS_OK;
+        assert(journal.size == sizeof(struct kowhai_journal_header_t) && journal.buffer_used > 0);
+        assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK);
+        assert(journal.buffer_used == 0 && journal.size == (long)(sizeof(struct kowhai_journal_header_t) + 2 * sizeof(struct kowhai_journal_record_t) + sizeof(uint32_t) + sizeof(int16_t)));
+        assert(kowhai_journal_close(&journal) == KOW_STATUS_OK);
+        // reopening replays the snapshot and the journal
+        memset(&journaled, 0, sizeof(journaled));
+        assert(kowhai_journal_open(&journal, filename, snapshot_filename, trees, 1, buffer, sizeof(buffer), 0) == KOW_STATUS_OK);
+        assert(journal.generation == 1);
+        assert(kowhai_get_int32(&trees[0].tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK && value == 0x12345678);
+        assert(kowhai_get_int16(&trees[0].tree, COUNT_OF(temp), temp, &temp_value) == KOW_STATUS_OK && temp_value == 321);
+        assert(memcmp(&journaled.flux_capacitor[0], &settings.flux_capacitor[0], sizeof(settings.flux_capacitor[0])) == 0);
+        // a checkpoint starts a new generation, uncommitted writes are covered by the snapshot
+        assert(kowhai_set_int32(&trees[0].tree, COUNT_OF(gain), gain, 0x1111) == KOW_STATUS_OK);
+        assert(kowhai_journal_append(&journal, 3, gain_offset, sizeof(uint32_t)) == KOW_STATUS_OK);
+        assert(kowhai_journal_checkpoint(&journal) == KOW_STATUS_OK);
+        assert(journal.generation == 2 && journal.buffer_used == 0);
+        assert(kowhai_journal_close(&journal) == KOW_STATUS_OK);
+        // a torn record is ignored (and the journal rewritten)
+        file = fopen(filename, "ab");
+        assert(file != NULL && fwrite(buffer, 1, 7, file) == 7);
+        fclose(file);
+        memset(&journaled, 0, sizeof(journaled));
+        assert(kowhai_journal_open(&journal, filename, snapshot_filename, trees, 1, buffer, sizeof(buffer), 0) == KOW_STATUS_OK);
+        assert(journal.generation == 3);
+        assert(kowhai_get_int32(&trees[0].tree, COUNT_OF(gain), gain, (int32_t*)&value) == KOW_STATUS_OK && value == 0x1111);
+        assert(kowhai_get_int16(&trees[0].tree, COUNT_OF(temp), temp, &temp_value) == KOW_STATUS_OK && temp_value == 321);
+        // reaching the checkpoint size checkpoints on commit
+        journal.checkpoint_size = journal.size + 1;
+        assert(kowhai_journal_append(&journal, 3, gain_offset, sizeof(uint32_t)) == KOW_STATUS_OK);
+        assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK);
+        assert(journal.generation == 4 && journal.size == sizeof(struct kowhai_journal_header_t));
+        // a failed commit cuts the journal back to its committed records and keeps the new ones buffered
+        journal.checkpoint_size = 0;
+        assert(kowhai_journal_append(&journal, 3, gain_offset, sizeof(uint32_t)) == KOW_STATUS_OK);
+        fclose((FILE*)journal.file);
+        journal.file = fopen(filename, "rb");
+        assert(kowhai_journal_commit(&journal) == KOW_STATUS_UNKNOWN_ERROR);
+        assert(journal.file != NULL && journal.buffer_used > 0 && journal.size == sizeof(struct kowhai_journal_header_t));
+        assert(kowhai_journal_commit(&journal) == KOW_STATUS_OK);
+        assert(journal.buffer_used == 0 && journal.size == (long)(sizeof(struct kowhai_journal_header_t) + sizeof(struct kowhai_journal_record_t) + sizeof(uint32_t)));
+        assert(kowhai_journal_close(&journal) == KOW_STATUS_OK);
+        // a snapshot of a different descriptor does not load
+        trees[0].tree.desc = shadow_descriptor;
+        assert(kowhai_journal_open(&journal, filename, snapshot_filename, trees, 1, buffer, sizeof(buffer), 0) == KOW_STATUS_INVALID_DESCRIPTOR);
+        remove(filename);
+        remove(snapshot_filename);
+    }
+    printf(" passed!\n");
+
+    // test aligned layouts
+    printf("test aligned layout...\t\t\t");
+    {
+        union kowhai_symbol_t time[] = {KOWHAI_SYMBOL(SYM_BIG, 0), KOWHAI_SYMBOL(SYM_TIME, 0)};
+        union kowhai_symbol_t part2[] = {KOWHAI_SYMBOL(SYM_BIG, 0), KOWHAI_SYMBOL(SYM_PARTS, 1), KOWHAI_SYMBOL(SYM_PART2, 0)};
+        union kowhai_symbol_t timeout[] = {KOWHAI_SYMBOL(SYM_BIG, 0), KOWHAI_SYMBOL(SYM_UNION, 0), KOWHAI_SYMBOL(SYM_TIMEOUT, 0)};
+        union kowhai_symbol_t check[] = {KOWHAI_SYMBOL(SYM_BIG, 0), KOWHAI_SYMBOL(SYM_CHECK, 0)};
+        struct kowhai_index_t index;
+        struct kowhai_index_entry_t entries[COUNT_OF(aligned_descriptor)];
+        uint16_t symbol_table[COUNT_OF(aligned_descriptor) * 2];
+        uint32_t time_value = 0x12345678;
+        float part2_value;
+        char js[0x400];
+        int i, js_size;
+        // packed by default
+        assert(kowhai_get_node_size(aligned_descriptor, &size) == KOW_STATUS_OK);
+        assert(size == 1 + 4 + 6 + 2 * 5 + 2 + 1);
+        assert(kowhai_get_node(aligned_descriptor, COUNT_OF(part2), part2, &offset, NULL) == KOW_STATUS_OK);
+        assert(offset == 1 + 4 + 6 + 5 + 1);
+        assert(kowhai_descriptor_compile_layout(aligned_descriptor, 2, &index, entries, COUNT_OF(entries), NULL, 0) == KOW_STATUS_INVALID_DESCRIPTOR);
+        // aligned with and without a symbol table
+        for (i = 0; i < 2; i++)
+        {
+            assert(kowhai_descriptor_compile_layout(aligned_descriptor, KOW_LAYOUT_ALIGNED, &index, entries, COUNT_OF(entries), i ? symbol_table : NULL, COUNT_OF(symbol_table)) == KOW_STATUS_OK);
+            assert(kowhai_get_node_size(aligned_descriptor, &size) == KOW_STATUS_OK);
+            assert(size == sizeof(struct aligned_data_t));
+            assert(kowhai_get_node(aligned_descriptor, COUNT_OF(time), time, &offset, NULL) == KOW_STATUS_OK);
+            assert(offset == offsetof(struct aligned_data_t, time));
+            assert(kowhai_get_node(aligned_descriptor, COUNT_OF(part2), part2, &offset, NULL) == KOW_STATUS_OK);
+            assert(offset == offsetof(struct aligned_data_t, parts[1].part2));
+            assert(kowhai_get_node(aligned_descriptor, COUNT_OF(timeout), timeout, &offset, NULL) == KOW_STATUS_OK);
+            assert(offset == offsetof(struct aligned_data_t, union_.timeout));
+            assert(kowhai_get_node(aligned_descriptor, COUNT_OF(check), check, &offset, NULL) == KOW_STATUS_OK);
+            assert(offset == offsetof(struct aligned_data_t, check));
+            // reads and writes land on the struct members
+            memset(&aligned, 0, sizeof(aligned));
+            aligned.parts[1].part2 = 2.5f;
+            assert(kowhai_write(&aligned_tree, COUNT_OF(time), time, 0, &time_value, sizeof(time_value)) == KOW_STATUS_OK);
+            assert(aligned.time == 0x12345678);
+            assert(kowhai_get_float(&aligned_tree, COUNT_OF(part2), part2, &part2_value) == KOW_STATUS_OK);
+            assert(part2_value == 2.5f);
+            assert(kowhai_set_int16(&aligned_tree, COUNT_OF(timeout), timeout, 0x4321) == KOW_STATUS_OK);
+            assert(aligned.union_.timeout == 0x4321);
+            // json only carries packed tree data
+            js_size = sizeof(js);
+            assert(kowhai_serialize_tree(aligned_tree, js, &js_size, NULL, NULL) == KOW_STATUS_INVALID_DESCRIPTOR);
+            kowhai_descriptor_release(&index);
+            assert(kowhai_descriptor_layout(aligned_descriptor) == KOW_LAYOUT_PACKED);
+        }
+    }
+    printf(" passed!\n");
+
+    // test generated accessors match the descriptor
+    printf("test generated accessors...\t\t");
+    {
+        union kowhai_symbol_t gain1[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t part2[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), KOWHAI_SYMBOL(SYM_UNION, 1), KOWHAI_SYMBOL(SYM_PARTS, 0), KOWHAI_SYMBOL(SYM_PART2, 0)};
+        struct settings_data_t saved = settings;
+        assert(kowhai_get_node_size(settings_descriptor, &size) == KOW_STATUS_OK);
+        assert(size == KOW_SETTINGS_SIZE && size == sizeof(struct settings_data_t));
+        assert(COUNT_OF(settings_descriptor) == KOW_SETTINGS_NODE_COUNT);
+        assert(kowhai_get_node(settings_descriptor, COUNT_OF(gain1), gain1, &offset, NULL) == KOW_STATUS_OK);
+        assert(offset == KOW_SETTINGS_FLUX_CAPACITOR_GAIN_OFFSET + KOW_SETTINGS_FLUX_CAPACITOR_STRIDE);
+        assert(kowhai_get_node(settings_descriptor, COUNT_OF(part2), part2, &offset, NULL) == KOW_STATUS_OK);
+        assert(offset == KOW_SETTINGS_UNION_CONTAINER_UNION_PARTS_PART2_OFFSET + KOW_SETTINGS_UNION_CONTAINER_STRIDE + KOW_SETTINGS_UNION_CONTAINER_UNION_STRIDE);
+        settings_flux_capacitor_gain_set(&settings, 1, 1234);
+        assert(settings.flux_capacitor[1].gain == 1234);
+        settings.flux_capacitor[1].coefficient[3] = 3.5f;
+        assert(settings_flux_capacitor_coefficient_get(&settings, 1, 3) == 3.5f);
+        settings_union_container_union_parts_part2_set(&settings, 1, 1, 0x5a);
+        assert(settings.union_container[1].union_[1].owner[1] == 0x5a); // parts overlays the start of the union
+        assert(settings_oven_timeout_get(&settings) == settings.oven.timeout);
+        settings = saved;
+    }
+    printf(" passed!\n");
 }
 
 int get_symbol_index(void *param, const char *symbol, int len)
@@ -501,6 +1248,18 @@ void serialization_tests()
 
     printf("test kowhai_serialize/kowhai_deserialize...\n");
 
+    // kowhai_str_to_path (with array slices)
+    n = COUNT_OF(path);
+    assert(kowhai_str_to_path("Scope.Pixels[100..163]", 22, path, &n, NULL, get_symbol_index) == KOW_STATUS_OK);
+    assert(n == 3);
+    assert(path[0].symbol == KOWHAI_SYMBOL(SYM_SCOPE, 0));
+    assert(path[1].symbol == KOWHAI_SYMBOL(SYM_PIXELS, 100));
+    assert(path[2].symbol == KOWHAI_SLICE(64));
+    n = COUNT_OF(path);
+    assert(kowhai_str_to_path("Settings.FluxCapacitor[1..0].Gain", 33, path, &n, NULL, get_symbol_index) == KOW_STATUS_INVALID_SYMBOL_PATH);
+    n = COUNT_OF(path);
+    assert(kowhai_str_to_path("Settings.FluxCapacitor[0..1].Gain", 33, path, &n, NULL, get_symbol_index) == KOW_STATUS_INVALID_SYMBOL_PATH);
+
     // kowhai_serialize (tree)
     assert(js != NULL && scratch != NULL && desc != NULL && data != NULL);
     buf_size = 100;
@@ -526,6 +1285,51 @@ void serialization_tests()
     assert(data_size == sizeof(settings));
     assert(memcmp(data, &settings, sizeof(settings)) == 0);
 
+    // kowhai binary containers (and conversion to and from json)
+    {
+        struct kowhai_tree_t tree = {NULL, NULL};
+        struct kowhai_tree_t tree2 = {settings_descriptor, &settings2};
+        const struct kowhai_node_t* stored = NULL;
+        int bin_size = 10;
+        assert(kowhai_binary_save(&settings_tree, 0, badjs, &bin_size) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        assert(bin_size == (int)(sizeof(struct kowhai_binary_header_t) + sizeof(settings)));
+        assert(kowhai_binary_save(&settings_tree, 0, badjs, &bin_size) == KOW_STATUS_OK);
+        assert(kowhai_binary_open(badjs, bin_size, &tree) == KOW_STATUS_INVALID_DESCRIPTOR);
+        memset(&settings2, 0, sizeof(settings2));
+        assert(kowhai_binary_load(badjs, bin_size, &tree2) == KOW_STATUS_OK);
+        assert(memcmp(&settings2, &settings, sizeof(settings)) == 0);
+        tree2.desc = shadow_descriptor;
+        assert(kowhai_binary_load(badjs, bin_size, &tree2) == KOW_STATUS_INVALID_DESCRIPTOR);
+        bin_size = 10;
+        assert(kowhai_json_to_binary(js, scratch, BUF_SIZE, desc, BUF_SIZE / sizeof(struct kowhai_node_t), data, BUF_SIZE, KOW_BINARY_STORE_DESCRIPTOR | KOW_BINARY_CHECKSUM, badjs, &bin_size) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        assert(kowhai_json_to_binary(js, scratch, BUF_SIZE, desc, BUF_SIZE / sizeof(struct kowhai_node_t), data, BUF_SIZE, KOW_BINARY_STORE_DESCRIPTOR | KOW_BINARY_CHECKSUM, badjs, &bin_size) == KOW_STATUS_OK);
+        assert(kowhai_binary_open(badjs, bin_size, &tree) == KOW_STATUS_OK);
+        assert(memcmp(tree.desc, settings_descriptor, sizeof(settings_descriptor)) == 0);
+        assert(memcmp(tree.data, &settings, sizeof(settings)) == 0);
+        buf_size = BUF_SIZE;
+        assert(kowhai_binary_to_json(badjs, bin_size, scratch, &buf_size, NULL, get_symbol_name) == KOW_STATUS_OK);
+        assert(strcmp(scratch, js) == 0);
+        // a damaged container fails its checksum
+        badjs[bin_size - 1] ^= 1;
+        assert(kowhai_binary_check(badjs, bin_size, &stored) == KOW_STATUS_BUFFER_INVALID);
+        badjs[bin_size - 1] ^= 1;
+        assert(kowhai_binary_check(badjs, bin_size - 1, &stored) == KOW_STATUS_BUFFER_INVALID);
+        assert(kowhai_binary_check(badjs, bin_size, &stored) == KOW_STATUS_OK && stored == tree.desc);
+        // a stored descriptor that does not end where its stored size says (even with a good checksum) is not used
+        {
+            struct kowhai_binary_header_t* header = (struct kowhai_binary_header_t*)badjs;
+            struct kowhai_node_t* root_end = (struct kowhai_node_t*)(header + 1) + COUNT_OF(settings_descriptor) - 1;
+            root_end->type = KOW_UINT8;
+            header->checksum = kowhai_crc32(0, header + 1, header->data_offset + header->data_size - sizeof(*header));
+            stored = NULL;
+            assert(kowhai_binary_check(badjs, bin_size, &stored) == KOW_STATUS_INVALID_DESCRIPTOR && stored == NULL);
+            root_end->type = KOW_BRANCH_END;
+            header->descriptor_size -= sizeof(struct kowhai_node_t);
+            header->checksum = kowhai_crc32(0, header + 1, header->data_offset + header->data_size - sizeof(*header));
+            assert(kowhai_binary_check(badjs, bin_size, &stored) == KOW_STATUS_INVALID_DESCRIPTOR && stored == NULL);
+        }
+    }
+
     // kowhai serialize (nodes)
 	settings.flux_capacitor[0].coefficient[1] = FLT_MIN; // test really small values can be deserialised without loosing precision
 	settings.flux_capacitor[0].coefficient[2] = 1.0f + FLT_EPSILON;
@@ -849,6 +1653,19 @@ void node_post_write(pkowhai_protocol_server_t server, void* param, uint16_t tre
     printf("node_post_write: tree_id: %d, node: %p, offset: %d, bytes_written: %d\n", tree_id, node, offset, bytes_written);
 }
 
+// count the pre and post write notifications in the int[2] node write param
+void counted_pre_write(pkowhai_protocol_server_t server, void* param, uint16_t tree_id, struct kowhai_node_t* node, int offset)
+{
+    ((int*)param)[0]++;
+}
+
+void counted_post_write(pkowhai_protocol_server_t server, void* param, uint16_t tree_id, struct kowhai_node_t* node, int offset, int bytes_written)
+{
+    // every post write notification follows all the pre write notifications
+    assert(((int*)param)[0] > ((int*)param)[1]);
+    ((int*)param)[1]++;
+}
+
 void server_buffer_send(pkowhai_protocol_server_t server, void* param, void* buffer, size_t buffer_size, struct kowhai_protocol_t* protocol)
 {
     xpsocket_handle conn = (xpsocket_handle)param;
@@ -921,6 +1738,654 @@ void server_buffer_received(xpsocket_handle conn, void* param, void* buffer, int
     kowhai_server_process_packet(server, buffer, buffer_size);
 }
 
+struct sent_packets_t
+{
+    char buffer[0x1000];
+    int size;
+    int count;
+    int zero_copy_count;
+};
+
+void sent_packet(pkowhai_protocol_server_t server, void* param, void* buffer, size_t buffer_size, struct kowhai_protocol_t* protocol)
+{
+    struct sent_packets_t* sent = (struct sent_packets_t*)param;
+    assert(sent->size + buffer_size <= sizeof(sent->buffer));
+    memcpy(sent->buffer + sent->size, buffer, buffer_size);
+    sent->size += buffer_size;
+    sent->count++;
+}
+
+void sent_packet_vector(pkowhai_protocol_server_t server, void* param, const struct kowhai_iovec_t* vector, int vector_count, struct kowhai_protocol_t* protocol)
+{
+    struct sent_packets_t* sent = (struct sent_packets_t*)param;
+    int i;
+    for (i = 0; i < vector_count; i++)
+    {
+        assert(sent->size + vector[i].size <= sizeof(sent->buffer));
+        memcpy(sent->buffer + sent->size, vector[i].base, vector[i].size);
+        sent->size += vector[i].size;
+        // count payloads sent straight from the scope tree data
+        if ((char*)vector[i].base >= (char*)&scope && (char*)vector[i].base < (char*)(&scope + 1))
+            sent->zero_copy_count++;
+    }
+    sent->count++;
+}
+
+void flushed_batch(pkowhai_protocol_server_t server, void* param, void* buffer, size_t buffer_size)
+{
+    sent_packet(server, param, buffer, buffer_size, NULL);
+}
+
+// a tree data reply reassembled from the packets of a protocol version
+struct received_data_t
+{
+    int version;
+    char buffer[0x14000];
+    int command;
+    int tag_counts[4];
+    struct kowhai_protocol_handle_spec_t spec;
+    int events;
+};
+
+void received_data(pkowhai_protocol_server_t server, void* param, void* buffer, size_t buffer_size, struct kowhai_protocol_t* protocol)
+{
+    struct received_data_t* received = (struct received_data_t*)param;
+    struct kowhai_protocol_t prot;
+    assert(kowhai_protocol_parse2(buffer, (int)buffer_size, received->version, &prot) == KOW_STATUS_OK);
+    received->command = prot.header.command;
+    assert(prot.header.tag < COUNT_OF(received->tag_counts));
+    received->tag_counts[prot.header.tag]++;
+    if (prot.header.command == KOW_CMD_READ_DATA_ACK || prot.header.command == KOW_CMD_READ_DATA_ACK_END)
+    {
+        assert(prot.payload.spec.data.memory.offset + prot.payload.spec.data.memory.size <= sizeof(received->buffer));
+        memcpy(received->buffer + prot.payload.spec.data.memory.offset, prot.payload.buffer, prot.payload.spec.data.memory.size);
+    }
+    if (prot.header.command == KOW_CMD_READ_MULTI_ACK || prot.header.command == KOW_CMD_READ_MULTI_ACK_END)
+    {
+        assert(prot.payload.spec.read_multi.offset + prot.payload.spec.read_multi.size <= sizeof(received->buffer));
+        memcpy(received->buffer + prot.payload.spec.read_multi.offset, prot.payload.buffer, prot.payload.spec.read_multi.size);
+    }
+    if (prot.header.command == KOW_CMD_READ_HANDLE_ACK || prot.header.command == KOW_CMD_READ_HANDLE_ACK_END)
+    {
+        assert(prot.payload.spec.handle.memory.offset + prot.payload.spec.handle.memory.size <= sizeof(received->buffer));
+        memcpy(received->buffer + prot.payload.spec.handle.memory.offset, prot.payload.buffer, prot.payload.spec.handle.memory.size);
+    }
+    if (prot.header.command == KOW_CMD_RESOLVE_ACK)
+        received->spec = prot.payload.spec.handle;
+    if (prot.header.command == KOW_CMD_EVENT || prot.header.command == KOW_CMD_EVENT_END)
+    {
+        assert(prot.payload.spec.event.offset + prot.payload.spec.event.size <= sizeof(received->buffer));
+        memcpy(received->buffer + prot.payload.spec.event.offset, prot.payload.buffer, prot.payload.spec.event.size);
+        if (prot.header.command == KOW_CMD_EVENT_END)
+            received->events++;
+    }
+}
+
+// send a request packet to a server
+void server_request(struct kowhai_protocol_server_t* server, struct kowhai_protocol_t* prot)
+{
+    char packet[MAX_PACKET_SIZE];
+    int bytes_required;
+    assert(kowhai_protocol_create(packet, MAX_PACKET_SIZE, prot, &bytes_required) == KOW_STATUS_OK);
+    assert(kowhai_server_process_packet(server, packet, bytes_required) == KOW_STATUS_OK);
+}
+
+void server_tests()
+{
+    char packet_buffer[MAX_PACKET_SIZE];
+    struct kowhai_protocol_server_t server;
+    struct kowhai_protocol_t prot;
+    static struct sent_packets_t sent, copied;
+    char batch[0x200];
+    union kowhai_symbol_t pixels[] = {KOWHAI_SYMBOL(SYM_SCOPE, 0), KOWHAI_SYMBOL(SYM_PIXELS, 0)};
+    int i;
+
+    kowhai_server_init(&server,
+        MAX_PACKET_SIZE,
+        packet_buffer,
+        NULL,
+        NULL,
+        NULL,
+        sent_packet,
+        NULL,
+        COUNT_OF(tree_list),
+        tree_list,
+        tree_id_list,
+        COUNT_OF(function_list),
+        function_list,
+        function_id_list,
+        function_called,
+        NULL,
+        COUNT_OF(symbols),
+        symbols);
+    for (i = 0; i < NUM_PIXELS; i++)
+        scope.pixels[i] = (uint16_t)i;
+
+    // test vector sends
+    printf("test kowhai_server_set_send_packet_vector...\t");
+    {
+        // copy the payloads in to the packet buffer
+        memset(&copied, 0, sizeof(copied));
+        server.send_packet_param = &copied;
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SCOPE, COUNT_OF(pixels), pixels);
+        server_request(&server, &prot);
+        POPULATE_PROTOCOL_CMD(prot, KOW_CMD_READ_DESCRIPTOR, SYM_SCOPE);
+        server_request(&server, &prot);
+        assert(copied.count > 2 && copied.zero_copy_count == 0);
+        // send the payloads from the tree data and descriptor, the packets are the same
+        memset(&sent, 0, sizeof(sent));
+        server.send_packet_param = &sent;
+        kowhai_server_set_send_packet_vector(&server, sent_packet_vector);
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SCOPE, COUNT_OF(pixels), pixels);
+        server_request(&server, &prot);
+        assert(sent.count > 2 && sent.zero_copy_count == sent.count);
+        POPULATE_PROTOCOL_CMD(prot, KOW_CMD_READ_DESCRIPTOR, SYM_SCOPE);
+        server_request(&server, &prot);
+        assert(sent.count == copied.count && sent.size == copied.size);
+        assert(memcmp(sent.buffer, copied.buffer, sent.size) == 0);
+        kowhai_server_set_send_packet_vector(&server, NULL);
+    }
+    printf(" passed!\n");
+
+    // test trees with an aligned layout are not served
+    printf("test aligned trees are not served...\t\t");
+    {
+        struct kowhai_protocol_t reply;
+        struct kowhai_index_t index;
+        struct kowhai_index_entry_t entries[COUNT_OF(scope_descriptor)];
+        server.send_packet_param = &sent;
+        assert(kowhai_descriptor_compile_layout(scope_descriptor, KOW_LAYOUT_ALIGNED, &index, entries, COUNT_OF(entries), NULL, 0) == KOW_STATUS_OK);
+        assert(kowhai_descriptor_layout(scope_descriptor) == KOW_LAYOUT_ALIGNED);
+        memset(&sent, 0, sizeof(sent));
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SCOPE, COUNT_OF(pixels), pixels);
+        server_request(&server, &prot);
+        assert(sent.count == 1 && kowhai_protocol_parse(sent.buffer, sent.size, &reply) == KOW_STATUS_OK);
+        assert(reply.header.command == KOW_CMD_ERROR_INVALID_TREE_ID);
+        kowhai_descriptor_release(&index);
+        memset(&sent, 0, sizeof(sent));
+        server_request(&server, &prot);
+        assert(sent.count > 1 && kowhai_protocol_parse(sent.buffer, sent.size, &reply) == KOW_STATUS_OK);
+        assert(reply.header.command == KOW_CMD_READ_DATA_ACK);
+    }
+    printf(" passed!\n");
+
+    // test packet size negotiation
+    printf("test KOW_CMD_SET_PACKET_SIZE...\t\t\t");
+    {
+        struct kowhai_protocol_t ack;
+        int packet_count;
+        server.send_packet_param = &sent;
+        // the server can not go over its packet buffer size
+        memset(&sent, 0, sizeof(sent));
+        POPULATE_PROTOCOL_SET_PACKET_SIZE(prot, KOW_PROTOCOL_MAX_PACKET_SIZE);
+        server_request(&server, &prot);
+        assert(kowhai_protocol_parse(sent.buffer, sent.size, &ack) == KOW_STATUS_OK);
+        assert(ack.header.command == KOW_CMD_SET_PACKET_SIZE_ACK && ack.payload.spec.packet_size == MAX_PACKET_SIZE);
+        // too small
+        memset(&sent, 0, sizeof(sent));
+        POPULATE_PROTOCOL_SET_PACKET_SIZE(prot, KOW_PROTOCOL_MIN_PACKET_SIZE - 1);
+        server_request(&server, &prot);
+        assert(kowhai_protocol_parse(sent.buffer, sent.size, &ack) == KOW_STATUS_OK);
+        assert(ack.header.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE && server.packet_size == MAX_PACKET_SIZE);
+        // smaller packets are used once negotiated
+        memset(&sent, 0, sizeof(sent));
+        POPULATE_PROTOCOL_SET_PACKET_SIZE(prot, MAX_PACKET_SIZE / 2);
+        server_request(&server, &prot);
+        assert(kowhai_protocol_parse(sent.buffer, sent.size, &ack) == KOW_STATUS_OK);
+        assert(ack.header.command == KOW_CMD_SET_PACKET_SIZE_ACK && ack.payload.spec.packet_size == MAX_PACKET_SIZE / 2);
+        memset(&sent, 0, sizeof(sent));
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SCOPE, COUNT_OF(pixels), pixels);
+        server_request(&server, &prot);
+        packet_count = sent.count;
+        assert(sent.size <= sent.count * MAX_PACKET_SIZE / 2);
+        kowhai_server_set_packet_size(&server, MAX_PACKET_SIZE);
+        memset(&sent, 0, sizeof(sent));
+        server_request(&server, &prot);
+        assert(sent.count < packet_count);
+        // a packet size too small for the header of a response is answered with an error rather than a payload
+        {
+            union kowhai_symbol_t part2[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_UNIONCONTAINER, 1), KOWHAI_SYMBOL(SYM_UNION, 1), KOWHAI_SYMBOL(SYM_PARTS, 0), KOWHAI_SYMBOL(SYM_PART2, 0), KOWHAI_SLICE(1)};
+            int overhead;
+            POPULATE_PROTOCOL_SET_PACKET_SIZE(prot, KOW_PROTOCOL_MIN_PACKET_SIZE);
+            server_request(&server, &prot);
+            POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA_ACK, SYM_SETTINGS, COUNT_OF(part2), part2);
+            assert(kowhai_protocol_get_overhead(&prot, &overhead) == KOW_STATUS_OK && overhead >= KOW_PROTOCOL_MIN_PACKET_SIZE);
+            memset(&sent, 0, sizeof(sent));
+            POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SETTINGS, COUNT_OF(part2), part2);
+            server_request(&server, &prot);
+            assert(sent.count == 1 && kowhai_protocol_parse(sent.buffer, sent.size, &ack) == KOW_STATUS_OK);
+            assert(ack.header.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE);
+            kowhai_server_set_packet_size(&server, MAX_PACKET_SIZE);
+        }
+    }
+    printf(" passed!\n");
+
+    // test protocol version negotiation
+    printf("test KOW_CMD_SET_PROTOCOL_VERSION...\t\t");
+    {
+        #define CAPTURE_COUNT 0x5000
+        static struct kowhai_node_t capture_descriptor[] =
+        {
+            { KOW_BRANCH_START,     SYM_BIG,            1,                 0 },
+            { KOW_UINT32,           SYM_COEFFICIENT,    CAPTURE_COUNT,     0 },
+            { KOW_BRANCH_END,       SYM_BIG,            0,                 0 },
+        };
+        static uint32_t capture[CAPTURE_COUNT];
+        static struct received_data_t received;
+        struct kowhai_protocol_server_tree_item_t capture_list[] = {
+            { KOW_TREE_ID(SYM_BIG), capture_descriptor, sizeof(capture_descriptor), capture },
+        };
+        struct kowhai_protocol_id_list_item_t capture_id_list[COUNT_OF(capture_list)];
+        struct kowhai_protocol_server_t capture_server;
+        union kowhai_symbol_t samples[] = {KOWHAI_SYMBOL(SYM_BIG, 0), KOWHAI_SYMBOL(SYM_COEFFICIENT, 0)};
+        char packet[MAX_PACKET_SIZE];
+        int bytes_required;
+
+        kowhai_server_init(&capture_server, MAX_PACKET_SIZE, packet_buffer, NULL, NULL, NULL, received_data, &received,
+            COUNT_OF(capture_list), capture_list, capture_id_list, 0, NULL, NULL, NULL, NULL, 0, NULL);
+        for (i = 0; i < CAPTURE_COUNT; i++)
+            capture[i] = i;
+        // version 1 offsets are 16 bit so the capture is refused rather than wrapping
+        POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_READ_DATA_ACK, SYM_BIG, COUNT_OF(samples), samples, KOW_UINT32, 0x10000, 4, capture);
+        assert(kowhai_protocol_create(packet, sizeof(packet), &prot, &bytes_required) == KOW_STATUS_INVALID_OFFSET);
+        received.version = KOW_PROTOCOL_VERSION_1;
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_BIG, COUNT_OF(samples), samples);
+        server_request(&capture_server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE);
+        // the server acknowledges the newest version it has
+        POPULATE_PROTOCOL_SET_PROTOCOL_VERSION(prot, KOW_PROTOCOL_VERSION + 1);
+        server_request(&capture_server, &prot);
+        assert(received.command == KOW_CMD_SET_PROTOCOL_VERSION_ACK && capture_server.protocol_version == KOW_PROTOCOL_VERSION);
+        kowhai_server_set_protocol_version(&capture_server, KOW_PROTOCOL_VERSION_1);
+        POPULATE_PROTOCOL_SET_PROTOCOL_VERSION(prot, KOW_PROTOCOL_VERSION_2);
+        server_request(&capture_server, &prot);
+        assert(received.command == KOW_CMD_SET_PROTOCOL_VERSION_ACK && capture_server.protocol_version == KOW_PROTOCOL_VERSION_2);
+        // version 2 offsets address the whole capture
+        received.version = KOW_PROTOCOL_VERSION_2;
+        memset(received.buffer, 0, sizeof(received.buffer));
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_BIG, COUNT_OF(samples), samples);
+        server_request(&capture_server, &prot);
+        assert(received.command == KOW_CMD_READ_DATA_ACK_END);
+        assert(memcmp(received.buffer, capture, sizeof(capture)) == 0);
+    }
+    printf(" passed!\n");
+
+    // test request tags
+    printf("test POPULATE_PROTOCOL_TAG...\t\t\t");
+    {
+        static struct received_data_t received;
+        char packet[MAX_PACKET_SIZE];
+        int bytes_required;
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        server.send_packet = received_data;
+        server.send_packet_param = &received;
+        // the acknowledgement is in the version the request was sent in
+        POPULATE_PROTOCOL_SET_PROTOCOL_VERSION(prot, KOW_PROTOCOL_VERSION_3);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_SET_PROTOCOL_VERSION_ACK && server.protocol_version == KOW_PROTOCOL_VERSION_3);
+        // send two tagged requests before reading any responses, each response packet carries its request tag
+        received.version = KOW_PROTOCOL_VERSION_3;
+        memset(received.tag_counts, 0, sizeof(received.tag_counts));
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SCOPE, COUNT_OF(pixels), pixels);
+        POPULATE_PROTOCOL_TAG(prot, 1);
+        assert(kowhai_protocol_create2(packet, sizeof(packet), KOW_PROTOCOL_VERSION_3, &prot, &bytes_required) == KOW_STATUS_OK);
+        assert(kowhai_server_process_packet(&server, packet, bytes_required) == KOW_STATUS_OK);
+        POPULATE_PROTOCOL_CMD(prot, KOW_CMD_READ_DESCRIPTOR, SYM_SCOPE);
+        POPULATE_PROTOCOL_TAG(prot, 2);
+        assert(kowhai_protocol_create2(packet, sizeof(packet), KOW_PROTOCOL_VERSION_3, &prot, &bytes_required) == KOW_STATUS_OK);
+        assert(kowhai_server_process_packet(&server, packet, bytes_required) == KOW_STATUS_OK);
+        assert(received.tag_counts[0] == 0 && received.tag_counts[1] > 1 && received.tag_counts[2] > 0);
+        assert(memcmp(received.buffer, scope.pixels, sizeof(scope.pixels)) == 0);
+        // events are not responses
+        kowhai_server_process_event(&server, SYM_SCOPE, &scope, sizeof(scope));
+        assert(received.command == KOW_CMD_EVENT_END && received.tag_counts[0] > 0);
+        kowhai_server_set_protocol_version(&server, KOW_PROTOCOL_VERSION_1);
+        server.send_packet = sent_packet;
+    }
+    printf(" passed!\n");
+
+    // test multi reads
+    printf("test KOW_CMD_READ_MULTI...\t\t\t");
+    {
+        struct settings_data_t saved_settings = settings;
+        static struct received_data_t received;
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        union kowhai_symbol_t flux[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 0)};
+        union kowhai_symbol_t coeff[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 0), KOWHAI_SYMBOL(SYM_COEFFICIENT, 2)};
+        union kowhai_symbol_t invalid[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_PIXELS, 0)};
+        char paths[MAX_PACKET_SIZE - 0x10], expected[0x100];
+        int used = 0, size = 0, path_size;
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        server.send_packet = received_data;
+        server.send_packet_param = &received;
+        for (i = 0; i < (int)sizeof(settings); i++)
+            ((char*)&settings)[i] = (char)i;
+        // the values of the paths are packed one after the other
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(gain), gain) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(temp), temp) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(flux), flux) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(coeff), coeff) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(coeff), coeff) == KOW_STATUS_PACKET_BUFFER_TOO_SMALL);
+        path_size = sizeof(uint32_t);
+        kowhai_read(&settings_tree, COUNT_OF(gain), gain, 0, expected + size, path_size);
+        size += path_size;
+        path_size = sizeof(int16_t);
+        kowhai_read(&settings_tree, COUNT_OF(temp), temp, 0, expected + size, path_size);
+        size += path_size;
+        // like KOW_CMD_READ_DATA an array item path reads to the end of the array
+        path_size = FLUX_CAP_COUNT * sizeof(struct flux_capacitor_t);
+        kowhai_read(&settings_tree, COUNT_OF(flux), flux, 0, expected + size, path_size);
+        size += path_size;
+        path_size = (COEFF_COUNT - 2) * sizeof(float);
+        kowhai_read(&settings_tree, COUNT_OF(coeff), coeff, 0, expected + size, path_size);
+        size += path_size;
+        POPULATE_PROTOCOL_READ_MULTI(prot, SYM_SETTINGS, 4, paths, used);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_READ_MULTI_ACK_END && received.tag_counts[0] > 1 && size > MAX_PACKET_SIZE);
+        assert(memcmp(received.buffer, expected, size) == 0);
+        // nothing is sent if a path is invalid
+        used = 0;
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(gain), gain) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_path(paths, sizeof(paths), &used, COUNT_OF(invalid), invalid) == KOW_STATUS_OK);
+        memset(&received, 0, sizeof(received));
+        POPULATE_PROTOCOL_READ_MULTI(prot, SYM_SETTINGS, 2, paths, used);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_SYMBOL_PATH && received.tag_counts[0] == 1);
+        server.send_packet = sent_packet;
+        settings = saved_settings;
+    }
+    printf(" passed!\n");
+
+    // test writing several nodes in one step
+    printf("test KOW_CMD_WRITE_MULTI...\t\t\t");
+    {
+        struct settings_data_t saved_settings = settings;
+        static struct received_data_t received;
+        struct kowhai_batch_item_t items[2];
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        char entries[MAX_PACKET_SIZE - 0x10], before[sizeof(settings)];
+        uint32_t gain_value = 0x12345678, gain_result;
+        int16_t temp_value = -1234, temp_result;
+        int used = 0, writes[2] = {0, 0}, symbol_count, offset, size, position = 0;
+        union kowhai_symbol_t* symbols;
+        void* value;
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        server.send_packet = received_data;
+        server.send_packet_param = &received;
+        server.node_pre_write = counted_pre_write;
+        server.node_post_write = counted_post_write;
+        server.node_write_param = writes;
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(gain), gain, 0, &gain_value, sizeof(gain_value)) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(temp), temp, 0, &temp_value, sizeof(temp_value)) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(temp), temp, 0, &temp_value, sizeof(temp_value)) == KOW_STATUS_PACKET_BUFFER_TOO_SMALL);
+        assert(kowhai_protocol_next_write(entries, used, &position, &symbol_count, &symbols, &offset, &value, &size) == KOW_STATUS_OK);
+        assert(symbol_count == COUNT_OF(gain) && offset == 0 && size == sizeof(gain_value) && memcmp(value, &gain_value, size) == 0);
+        assert(kowhai_protocol_next_write(entries, used, &position, &symbol_count, &symbols, &offset, &value, &size) == KOW_STATUS_OK);
+        assert(kowhai_protocol_next_write(entries, used, &position, &symbol_count, &symbols, &offset, &value, &size) == KOW_STATUS_NOT_FOUND);
+        // refused until the server has write multi items
+        POPULATE_PROTOCOL_WRITE_MULTI(prot, SYM_SETTINGS, 2, entries, used);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE && writes[0] == 0);
+        // all the writes are applied with one batch of notifications
+        kowhai_server_set_write_multi_items(&server, items, COUNT_OF(items));
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_WRITE_MULTI_ACK && writes[0] == 2 && writes[1] == 2);
+        assert(kowhai_get_int32(&settings_tree, COUNT_OF(gain), gain, (int32_t*)&gain_result) == KOW_STATUS_OK && gain_result == gain_value);
+        assert(kowhai_get_int16(&settings_tree, COUNT_OF(temp), temp, &temp_result) == KOW_STATUS_OK && temp_result == temp_value);
+        // nothing is written if a write overruns its node
+        used = 0;
+        gain_value = 0;
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(gain), gain, 0, &gain_value, sizeof(gain_value)) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(temp), temp, 1, &temp_value, sizeof(temp_value)) == KOW_STATUS_OK);
+        memcpy(before, &settings, sizeof(settings));
+        POPULATE_PROTOCOL_WRITE_MULTI(prot, SYM_SETTINGS, 2, entries, used);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE && writes[0] == 2);
+        assert(memcmp(before, &settings, sizeof(settings)) == 0);
+        // or if two writes go to the same node (they would be applied in no defined order)
+        used = 0;
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(gain), gain, 0, &gain_value, sizeof(gain_value)) == KOW_STATUS_OK);
+        assert(kowhai_protocol_add_write(entries, sizeof(entries), &used, COUNT_OF(gain), gain, 2, &gain_value, 2) == KOW_STATUS_OK);
+        POPULATE_PROTOCOL_WRITE_MULTI(prot, SYM_SETTINGS, 2, entries, used);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE && writes[0] == 2);
+        assert(memcmp(before, &settings, sizeof(settings)) == 0);
+        // or while a write data sequence is in progress
+        POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_WRITE_DATA, SYM_SETTINGS, COUNT_OF(temp), temp, KOW_INT16, 0, 1, &temp_value);
+        server_request(&server, &prot);
+        POPULATE_PROTOCOL_WRITE_MULTI(prot, SYM_SETTINGS, 1, entries, used - (int)(sizeof(temp) + 1 + 2 * sizeof(uint32_t) + sizeof(temp_value)));
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_SEQUENCE && writes[0] == 3);
+        POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_WRITE_DATA_END, SYM_SETTINGS, COUNT_OF(temp), temp, KOW_INT16, 1, 1, (char*)&temp_value + 1);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_WRITE_DATA_ACK && writes[1] == 3);
+        assert(memcmp(before, &settings, sizeof(settings)) == 0);
+        kowhai_server_set_write_multi_items(&server, NULL, 0);
+        server.node_pre_write = NULL;
+        server.node_post_write = NULL;
+        server.node_write_param = NULL;
+        server.send_packet = sent_packet;
+        settings = saved_settings;
+    }
+    printf(" passed!\n");
+
+    // test handles
+    printf("test KOW_CMD_RESOLVE...\t\t\t\t");
+    {
+        struct settings_data_t saved_settings = settings;
+        static struct received_data_t received;
+        struct kowhai_protocol_server_handle_t handles[2];
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t flux[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        uint32_t gain_value = 0x89ABCDEF, gain_result;
+        uint16_t gain_handle, flux_handle;
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        server.send_packet = received_data;
+        server.send_packet_param = &received;
+        // refused until the server has a handle table
+        POPULATE_PROTOCOL_RESOLVE(prot, SYM_SETTINGS, COUNT_OF(gain), gain);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_HANDLE_TABLE_FULL);
+        kowhai_server_set_handle_table(&server, handles, COUNT_OF(handles));
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_RESOLVE_ACK && received.spec.memory.type == KOW_UINT32 && received.spec.memory.size == sizeof(uint32_t));
+        gain_handle = received.spec.handle;
+        // a path keeps its handle
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_RESOLVE_ACK && received.spec.handle == gain_handle);
+        POPULATE_PROTOCOL_RESOLVE(prot, SYM_SETTINGS, COUNT_OF(flux), flux);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_RESOLVE_ACK && received.spec.memory.size == FLUX_CAP_COUNT * sizeof(struct flux_capacitor_t));
+        flux_handle = received.spec.handle;
+        assert(flux_handle != gain_handle);
+        POPULATE_PROTOCOL_RESOLVE(prot, SYM_SETTINGS, COUNT_OF(temp), temp);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_HANDLE_TABLE_FULL);
+        // read and write by handle
+        for (i = 0; i < (int)sizeof(settings); i++)
+            ((char*)&settings)[i] = (char)i;
+        POPULATE_PROTOCOL_READ_HANDLE(prot, SYM_SETTINGS, flux_handle);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_READ_HANDLE_ACK_END && received.tag_counts[0] > 1);
+        assert(memcmp(received.buffer, settings.flux_capacitor, sizeof(settings.flux_capacitor)) == 0);
+        POPULATE_PROTOCOL_WRITE_HANDLE(prot, KOW_CMD_WRITE_HANDLE_END, SYM_SETTINGS, gain_handle, KOW_UINT32, 0, sizeof(gain_value), &gain_value);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_WRITE_HANDLE_ACK);
+        assert(kowhai_get_int32(&settings_tree, COUNT_OF(gain), gain, (int32_t*)&gain_result) == KOW_STATUS_OK && gain_result == gain_value);
+        POPULATE_PROTOCOL_WRITE_HANDLE(prot, KOW_CMD_WRITE_HANDLE_END, SYM_SETTINGS, gain_handle, KOW_UINT32, 2, sizeof(gain_value), &gain_value);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_PAYLOAD_SIZE);
+        // several handles are read in one request, their values packed one after the other as for a path list
+        {
+            uint16_t handle_list[] = {gain_handle, flux_handle, gain_handle};
+            uint16_t invalid_list[] = {gain_handle, 0xFFFF};
+            memset(&received, 0, sizeof(received));
+            received.version = KOW_PROTOCOL_VERSION_1;
+            POPULATE_PROTOCOL_READ_MULTI_HANDLES(prot, SYM_SETTINGS, COUNT_OF(handle_list), handle_list);
+            server_request(&server, &prot);
+            assert(received.command == KOW_CMD_READ_MULTI_ACK_END && received.tag_counts[0] > 1);
+            assert(memcmp(received.buffer, &gain_value, sizeof(gain_value)) == 0);
+            assert(memcmp(received.buffer + sizeof(gain_value), settings.flux_capacitor, sizeof(settings.flux_capacitor)) == 0);
+            assert(memcmp(received.buffer + sizeof(gain_value) + sizeof(settings.flux_capacitor), &gain_value, sizeof(gain_value)) == 0);
+            // nothing is sent if a handle is invalid
+            memset(&received, 0, sizeof(received));
+            received.version = KOW_PROTOCOL_VERSION_1;
+            POPULATE_PROTOCOL_READ_MULTI_HANDLES(prot, SYM_SETTINGS, COUNT_OF(invalid_list), invalid_list);
+            server_request(&server, &prot);
+            assert(received.command == KOW_CMD_ERROR_INVALID_HANDLE && received.tag_counts[0] == 1);
+        }
+        // handles belong to the tree they were resolved in and the connection they were resolved on
+        POPULATE_PROTOCOL_READ_HANDLE(prot, SYM_SCOPE, gain_handle);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_HANDLE);
+        kowhai_server_set_handle_table(&server, handles, COUNT_OF(handles));
+        POPULATE_PROTOCOL_READ_HANDLE(prot, SYM_SETTINGS, gain_handle);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_HANDLE);
+        kowhai_server_set_handle_table(&server, NULL, 0);
+        server.send_packet = sent_packet;
+        settings = saved_settings;
+    }
+    printf(" passed!\n");
+
+    // test subscriptions
+    printf("test KOW_CMD_SUBSCRIBE...\t\t\t");
+    {
+        struct settings_data_t saved_settings = settings;
+        static struct received_data_t received;
+        struct kowhai_protocol_server_handle_t handles[4];
+        struct kowhai_protocol_server_subscription_t subscriptions[2];
+        struct kowhai_dirty_t dirty;
+        struct kowhai_dirty_entry_t entries[64];
+        int entry_count = COUNT_OF(entries);
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        union kowhai_symbol_t flux[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 0)};
+        uint16_t gain_handle, temp_handle, flux_handle;
+        int16_t temp_value = 500;
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        server.send_packet = received_data;
+        server.send_packet_param = &received;
+        kowhai_server_set_handle_table(&server, handles, COUNT_OF(handles));
+        kowhai_server_set_subscription_table(&server, subscriptions, COUNT_OF(subscriptions));
+        POPULATE_PROTOCOL_RESOLVE(prot, SYM_SETTINGS, COUNT_OF(gain), gain);
+        server_request(&server, &prot);
+        gain_handle = received.spec.handle;
+        POPULATE_PROTOCOL_RESOLVE(prot, SYM_SETTINGS, COUNT_OF(temp), temp);
+        server_request(&server, &prot);
+        temp_handle = received.spec.handle;
+        POPULATE_PROTOCOL_RESOLVE(prot, SYM_SETTINGS, COUNT_OF(flux), flux);
+        server_request(&server, &prot);
+        flux_handle = received.spec.handle;
+        // a periodic subscription sends its data once per period
+        POPULATE_PROTOCOL_SUBSCRIBE(prot, SYM_SETTINGS, gain_handle, 3);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_SUBSCRIBE_ACK);
+        assert(kowhai_server_tick(&server, 2) == KOW_STATUS_OK && received.events == 0);
+        settings.flux_capacitor[1].gain = 0x01020304;
+        assert(kowhai_server_tick(&server, 1) == KOW_STATUS_OK && received.events == 1);
+        assert(memcmp(received.buffer + offsetof(struct settings_data_t, flux_capacitor[1].gain), &settings.flux_capacitor[1].gain, sizeof(uint32_t)) == 0);
+        assert(kowhai_server_tick(&server, 7) == KOW_STATUS_OK && received.events == 2);
+        // an on change subscription needs a change tracker
+        POPULATE_PROTOCOL_SUBSCRIBE(prot, SYM_SETTINGS, temp_handle, 0);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_COMMAND);
+        assert(kowhai_dirty_init(&dirty, &settings_tree, entries, &entry_count) == KOW_STATUS_OK);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_SUBSCRIBE_ACK);
+        assert(kowhai_server_tick(&server, 0) == KOW_STATUS_OK && received.events == 2);
+        assert(kowhai_set_int32(&settings_tree, COUNT_OF(gain), gain, 5) == KOW_STATUS_OK);
+        assert(kowhai_server_tick(&server, 0) == KOW_STATUS_OK && received.events == 2);
+        assert(kowhai_set_int16(&settings_tree, COUNT_OF(temp), temp, 100) == KOW_STATUS_OK);
+        assert(kowhai_set_int16(&settings_tree, COUNT_OF(temp), temp, 200) == KOW_STATUS_OK);
+        assert(kowhai_server_tick(&server, 0) == KOW_STATUS_OK && received.events == 3);
+        assert(*(int16_t*)(received.buffer + offsetof(struct settings_data_t, oven.temp)) == 200);
+        assert(kowhai_server_tick(&server, 0) == KOW_STATUS_OK && received.events == 3);
+        // the table is full
+        POPULATE_PROTOCOL_SUBSCRIBE(prot, SYM_SETTINGS, flux_handle, 1);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_SUBSCRIPTION_TABLE_FULL);
+        POPULATE_PROTOCOL_UNSUBSCRIBE(prot, SYM_SETTINGS, gain_handle);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_UNSUBSCRIBE_ACK);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_ERROR_INVALID_HANDLE);
+        // writes within the window are coalesced in to one event of the latest value
+        POPULATE_PROTOCOL_SUBSCRIBE_ON_CHANGE(prot, SYM_SETTINGS, temp_handle, 5);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_SUBSCRIBE_ACK);
+        assert(kowhai_set_int16(&settings_tree, COUNT_OF(temp), temp, 300) == KOW_STATUS_OK);
+        assert(kowhai_server_tick(&server, 1) == KOW_STATUS_OK && received.events == 3);
+        assert(kowhai_set_int16(&settings_tree, COUNT_OF(temp), temp, 400) == KOW_STATUS_OK);
+        assert(kowhai_server_tick(&server, 3) == KOW_STATUS_OK && received.events == 3);
+        POPULATE_PROTOCOL_WRITE(prot, KOW_CMD_WRITE_DATA_END, SYM_SETTINGS, COUNT_OF(temp), temp, KOW_INT16, 0, sizeof(int16_t), &temp_value);
+        server_request(&server, &prot);
+        assert(kowhai_server_tick(&server, 1) == KOW_STATUS_OK && received.events == 3);
+        assert(kowhai_server_tick(&server, 1) == KOW_STATUS_OK && received.events == 4);
+        assert(*(int16_t*)(received.buffer + offsetof(struct settings_data_t, oven.temp)) == temp_value);
+        assert(kowhai_server_tick(&server, 10) == KOW_STATUS_OK && received.events == 4);
+        // larger data is split in to several event packets
+        POPULATE_PROTOCOL_SUBSCRIBE(prot, SYM_SETTINGS, flux_handle, 1);
+        server_request(&server, &prot);
+        assert(received.command == KOW_CMD_SUBSCRIBE_ACK);
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        assert(kowhai_server_tick(&server, 1) == KOW_STATUS_OK && received.events == 1 && received.tag_counts[0] > 1);
+        assert(memcmp(received.buffer + offsetof(struct settings_data_t, flux_capacitor), settings.flux_capacitor, sizeof(settings.flux_capacitor)) == 0);
+        // the application can watch a node without a client subscription
+        kowhai_server_set_handle_table(&server, handles, COUNT_OF(handles));
+        assert(kowhai_server_watch(&server, SYM_SETTINGS, COUNT_OF(gain), gain, 0) == KOW_STATUS_OK);
+        assert(kowhai_server_watch(&server, SYM_SCOPE, COUNT_OF(pixels), pixels, 0) == KOW_STATUS_NO_DATA);
+        memset(&received, 0, sizeof(received));
+        received.version = KOW_PROTOCOL_VERSION_1;
+        assert(kowhai_set_int32(&settings_tree, COUNT_OF(gain), gain, 6) == KOW_STATUS_OK);
+        assert(kowhai_server_tick(&server, 1) == KOW_STATUS_OK && received.events == 1);
+        assert(*(uint32_t*)(received.buffer + offsetof(struct settings_data_t, flux_capacitor[1].gain)) == 6);
+        kowhai_dirty_release(&dirty);
+        kowhai_server_set_subscription_table(&server, NULL, 0);
+        kowhai_server_set_handle_table(&server, NULL, 0);
+        server.send_packet = sent_packet;
+        settings = saved_settings;
+    }
+    printf(" passed!\n");
+
+    // test output batches
+    printf("test kowhai_server_set_output_batch...\t\t");
+    {
+        assert(kowhai_server_set_output_batch(&server, batch, MAX_PACKET_SIZE - 1, flushed_batch) == KOW_STATUS_TARGET_BUFFER_TOO_SMALL);
+        // the packets are flushed in a few big batches
+        assert(kowhai_server_set_output_batch(&server, batch, sizeof(batch), flushed_batch) == KOW_STATUS_OK);
+        memset(&sent, 0, sizeof(sent));
+        server.send_packet_param = &sent;
+        POPULATE_PROTOCOL_READ(prot, KOW_CMD_READ_DATA, SYM_SCOPE, COUNT_OF(pixels), pixels);
+        server_request(&server, &prot);
+        assert(sent.count > 1 && sent.count <= (int)(sent.size / (sizeof(batch) - MAX_PACKET_SIZE) + 1) && server.batch_used == 0);
+        POPULATE_PROTOCOL_CMD(prot, KOW_CMD_READ_DESCRIPTOR, SYM_SCOPE);
+        server_request(&server, &prot);
+        assert(sent.count < copied.count && sent.size == copied.size);
+        assert(memcmp(sent.buffer, copied.buffer, sent.size) == 0);
+        // a small response is one flush
+        memset(&sent, 0, sizeof(sent));
+        POPULATE_PROTOCOL_CMD(prot, KOW_CMD_READ_DESCRIPTOR, SYM_SCOPE);
+        server_request(&server, &prot);
+        assert(sent.count == 1);
+        // events are flushed too
+        memset(&sent, 0, sizeof(sent));
+        assert(kowhai_server_process_event(&server, SYM_SCOPE, &scope, sizeof(scope)) == KOW_STATUS_OK);
+        assert(sent.count > 0 && sent.count < 8 && server.batch_used == 0);
+        assert(kowhai_server_set_output_batch(&server, NULL, 0, NULL) == KOW_STATUS_OK);
+    }
+    printf(" passed!\n");
+}
+
 void test_server_protocol()
 {
     char packet_buffer[MAX_PACKET_SIZE];
@@ -1562,6 +3027,8 @@ int main(int argc, char* argv[])
     diff_tests();
     merge_tests();
     create_symbol_path_tests();
+    // test server (in process)
+    server_tests();
     // test server protocol
     if (test_command == TEST_PROTOCOL_SERVER)
         test_server_protocol();
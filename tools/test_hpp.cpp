@@ -0,0 +1,188 @@
+#include "../src/kowhai.hpp"
+
+#include <stdio.h>
+#include <assert.h>
+#include <stddef.h>
+#include <type_traits>
+
+#define COUNT_OF(x) ((sizeof(x)/sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
+
+//
+// treenode symbols
+//
+
+#include "symbols.h"
+
+//
+// settings tree descriptor (the same shape as the settings tree in test.c)
+//
+
+#define FLUX_CAP_COUNT 2
+#define COEFF_COUNT    6
+#define UNION_COUNT    2
+#define OWNER_MAX_LEN  12
+
+constexpr struct kowhai_node_t settings_descriptor[] =
+{
+    { KOW_BRANCH_START,     SYM_SETTINGS,       1,                0 },
+
+    { KOW_BRANCH_START,     SYM_FLUXCAPACITOR,  FLUX_CAP_COUNT,   0 },
+    { KOW_CHAR,             SYM_OWNER,          OWNER_MAX_LEN,    0 },
+    { KOW_UINT32,           SYM_FREQUENCY,      1,                0 },
+    { KOW_UINT32,           SYM_GAIN,           1,                0 },
+    { KOW_FLOAT,            SYM_COEFFICIENT,    COEFF_COUNT,      0 },
+    { KOW_BRANCH_END,       SYM_FLUXCAPACITOR,  0,                0 },
+
+    { KOW_BRANCH_START,     SYM_OVEN,           1,                0 },
+    { KOW_INT16,            SYM_TEMP,           1,                0 },
+    { KOW_UINT16,           SYM_TIMEOUT,        1,                0 },
+    { KOW_BRANCH_END,       SYM_OVEN,           0,                0 },
+
+    { KOW_BRANCH_START,     SYM_UNIONCONTAINER, UNION_COUNT,      0 },
+    { KOW_BRANCH_U_START,   SYM_UNION,          UNION_COUNT,      0 },
+    { KOW_INT16,            SYM_TEMP,           1,                0 },
+    { KOW_UINT16,           SYM_TIMEOUT,        1,                0 },
+    { KOW_UINT8,            SYM_BEEP,           1,                0 },
+    { KOW_CHAR,             SYM_OWNER,          OWNER_MAX_LEN,    0 },
+    { KOW_BRANCH_START,     SYM_PARTS,          1,                0 },
+    { KOW_UINT8,            SYM_PART1,          1,                0 },
+    { KOW_UINT8,            SYM_PART2,          1,                0 },
+    { KOW_BRANCH_END,       SYM_PARTS,          0,                0 },
+    { KOW_BRANCH_END,       SYM_UNION,          0,                0 },
+    { KOW_UINT32,           SYM_CHECK,          1,                0 },
+    { KOW_BRANCH_END,       SYM_UNIONCONTAINER, 0,                0 },
+
+    { KOW_UINT32,           SYM_CHECK,          1,                0 },
+
+    { KOW_BRANCH_END,       SYM_SETTINGS,       0,                0 },
+};
+
+//
+// settings tree structs
+//
+
+#pragma pack(1)
+
+struct flux_capacitor_t
+{
+    char owner[OWNER_MAX_LEN];
+    uint32_t frequency;
+    uint32_t gain;
+    float coefficient[COEFF_COUNT];
+};
+
+struct oven_t
+{
+    int16_t temp;
+    uint16_t timeout;
+};
+
+union union_t
+{
+    int16_t temp;
+    uint16_t timeout;
+    uint8_t beep;
+    char owner[OWNER_MAX_LEN];
+};
+
+struct union_container_t
+{
+    union union_t union_[UNION_COUNT];
+    uint32_t check;
+};
+
+struct settings_data_t
+{
+    struct flux_capacitor_t flux_capacitor[FLUX_CAP_COUNT];
+    struct oven_t oven;
+    struct union_container_t union_container[UNION_COUNT];
+    uint32_t check;
+};
+
+#pragma pack()
+
+typedef kowhai::view<settings_descriptor> settings_view;
+
+//
+// compile time layout
+//
+
+static_assert(settings_view::size == sizeof(struct settings_data_t), "tree size");
+static_assert(settings_view::offset_of<SYM_FLUXCAPACITOR, SYM_GAIN> == offsetof(struct settings_data_t, flux_capacitor[0].gain), "gain offset");
+static_assert(settings_view::offset_of<SYM_OVEN, SYM_TIMEOUT> == offsetof(struct settings_data_t, oven.timeout), "timeout offset");
+static_assert(settings_view::offset_of<SYM_UNIONCONTAINER, SYM_CHECK> == offsetof(struct settings_data_t, union_container[0].check), "union check offset");
+static_assert(settings_view::offset_of<SYM_CHECK> == offsetof(struct settings_data_t, check), "check offset");
+static_assert(settings_view::size_of<SYM_FLUXCAPACITOR> == sizeof(struct flux_capacitor_t) * FLUX_CAP_COUNT, "flux capacitor size");
+static_assert(settings_view::size_of<SYM_UNIONCONTAINER, SYM_UNION> == sizeof(union union_t) * UNION_COUNT, "union size");
+static_assert(settings_view::count_of<SYM_FLUXCAPACITOR, SYM_COEFFICIENT> == COEFF_COUNT, "coefficient count");
+static_assert(std::is_same<settings_view::type_of<SYM_OVEN, SYM_TEMP>, int16_t>::value, "temp type");
+static_assert(std::is_same<settings_view::type_of<SYM_FLUXCAPACITOR, SYM_COEFFICIENT>, float>::value, "coefficient type");
+
+struct settings_data_t settings;
+
+int main()
+{
+    settings_view view(&settings);
+    struct kowhai_tree_t tree = view.tree();
+
+    printf("test kowhai::view get/set...\t\t");
+    {
+        view.set<SYM_FLUXCAPACITOR, SYM_GAIN>(0x12345678, 1);
+        view.set<SYM_FLUXCAPACITOR, SYM_COEFFICIENT>(2.5f, 1, 3);
+        view.set<SYM_OVEN, SYM_TEMP>(-40);
+        view.set<SYM_UNIONCONTAINER, SYM_CHECK>(77, 1);
+        view.set<SYM_CHECK>(0xCAFE);
+        assert(settings.flux_capacitor[1].gain == 0x12345678 && settings.flux_capacitor[0].gain == 0);
+        assert(settings.flux_capacitor[1].coefficient[3] == 2.5f && settings.flux_capacitor[0].coefficient[3] == 0);
+        assert(settings.oven.temp == -40);
+        assert(settings.union_container[1].check == 77 && settings.union_container[0].check == 0);
+        assert(settings.check == 0xCAFE);
+        settings.union_container[1].union_[1].timeout = 0xBEEF;
+        assert((view.get<SYM_UNIONCONTAINER, SYM_UNION, SYM_TIMEOUT>(1, 1) == 0xBEEF));
+        assert((view.get<SYM_FLUXCAPACITOR, SYM_GAIN>(1) == 0x12345678));
+        assert((view.get<SYM_OVEN, SYM_TEMP>() == -40));
+        // a view of the c tree sees the same data
+        assert((settings_view(tree).get<SYM_CHECK>() == 0xCAFE));
+    }
+    printf(" passed!\n");
+
+    printf("test kowhai::view with the c api...\t");
+    {
+        union kowhai_symbol_t gain[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_FLUXCAPACITOR, 1), KOWHAI_SYMBOL(SYM_GAIN, 0)};
+        union kowhai_symbol_t temp[] = {KOWHAI_SYMBOL(SYM_SETTINGS, 0), KOWHAI_SYMBOL(SYM_OVEN, 0), KOWHAI_SYMBOL(SYM_TEMP, 0)};
+        uint32_t value = 0;
+        int16_t temp_value = 123;
+        int offset;
+        struct kowhai_node_t* node;
+        assert(tree.desc == settings_descriptor && tree.data == &settings);
+        assert(kowhai_get_node(tree.desc, COUNT_OF(gain), gain, &offset, &node) == KOW_STATUS_OK);
+        assert((offset == settings_view::offset_of<SYM_FLUXCAPACITOR, SYM_GAIN> + (int)sizeof(struct flux_capacitor_t)));
+        assert(kowhai_read(&tree, COUNT_OF(gain), gain, 0, &value, sizeof(value)) == KOW_STATUS_OK);
+        assert((value == view.get<SYM_FLUXCAPACITOR, SYM_GAIN>(1)));
+        assert(kowhai_write(&tree, COUNT_OF(temp), temp, 0, &temp_value, sizeof(temp_value)) == KOW_STATUS_OK);
+        assert((view.get<SYM_OVEN, SYM_TEMP>() == 123));
+    }
+    printf(" passed!\n");
+
+    printf("test kowhai::view read/write...\t\t");
+    {
+        struct kowhai_dirty_entry_t entries[64];
+        struct kowhai_dirty_t dirty;
+        int entry_count = COUNT_OF(entries);
+        uint32_t generation;
+        settings_view::type_of<SYM_UNIONCONTAINER, SYM_UNION, SYM_TIMEOUT> timeout = 0;
+        assert(kowhai_dirty_init(&dirty, &tree, entries, &entry_count) == KOW_STATUS_OK);
+        generation = dirty.generation;
+        // set bypasses the change tracker, write goes through it
+        view.set<SYM_OVEN, SYM_TEMP>(7);
+        assert(dirty.generation == generation);
+        assert((view.write<SYM_UNIONCONTAINER, SYM_UNION, SYM_TIMEOUT>(0x1234, 1, 1) == KOW_STATUS_OK));
+        assert(dirty.generation != generation && settings.union_container[1].union_[1].timeout == 0x1234);
+        assert((view.read<SYM_UNIONCONTAINER, SYM_UNION, SYM_TIMEOUT>(timeout, 1, 1) == KOW_STATUS_OK && timeout == 0x1234));
+        assert((view.write<SYM_FLUXCAPACITOR, SYM_GAIN>(5, FLUX_CAP_COUNT) == KOW_STATUS_INVALID_SYMBOL_PATH));
+        kowhai_dirty_release(&dirty);
+    }
+    printf(" passed!\n");
+
+    return 0;
+}